@@ -0,0 +1,245 @@
+// Memory behaviour of the node arena on a large program: block allocations, page faults, huge pages and dTLB misses.
+// Parses a generated program of the requested size, checks it, and walks every function body a number of times
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include "bench.hpp"
+#include "../src/blockSource.hpp"
+#include "../src/checker/checker.hpp"
+#include "../src/traversal/traversal.hpp"
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+/**
+ * Counts dTLB load misses of this thread with perf_event_open, user space only.
+ * Opening fails where the kernel does not allow it (perf_event_paranoid) or has no such counter,
+ * in which case the error is kept and nothing is counted
+*/
+struct TlbMissCounter {
+  int fd{-1};
+  int error{0};
+
+  TlbMissCounter() {
+#if defined(__linux__)
+    perf_event_attr attr;
+    memset(&attr, 0, sizeof (attr));
+    attr.size = sizeof (attr);
+    attr.type = PERF_TYPE_HW_CACHE;
+    attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    fd = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+    if (fd < 0) {
+      error = errno;
+    }
+#else
+    error = ENOSYS;
+#endif
+  }
+  TlbMissCounter(const TlbMissCounter&) = delete;
+  ~TlbMissCounter() {
+#if defined(__linux__)
+    if (fd >= 0) {
+      close(fd);
+    }
+#endif
+  }
+
+  void start() {
+#if defined(__linux__)
+    if (fd >= 0) {
+      ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+      ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif
+  }
+
+  /**
+   * \returns the misses since start, or -1 if they can't be counted
+  */
+  long long stop() {
+#if defined(__linux__)
+    long long count = 0;
+    if (fd >= 0) {
+      ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+      if (read(fd, &count, sizeof (count)) == sizeof (count)) {
+        return count;
+      }
+    }
+#endif
+    return -1;
+  }
+};
+
+/**
+ * Counts statements and expressions, the nodes parse time is reported per
+*/
+struct NodeCounter: NodeVisitor {
+  using NodeVisitor::enter;
+  size_t statements{0};
+  size_t expressions{0};
+
+  bool enter(Statement&) {
+    ++statements;
+    return true;
+  }
+  bool enter(Expression&) {
+    ++expressions;
+    return true;
+  }
+};
+
+/**
+ * Walks every function body of the program, reusing the traversal's stack
+*/
+template<typename Visitor>
+void walkFunctions(Program& program, Traversal<Visitor>& traversal) {
+  for (GeneralDec *dec : program.decs) {
+    if (dec->type == GeneralDecType::FUNCTION) {
+      traversal.walk(*dec->funcDec);
+    } else if (dec->type == GeneralDecType::TEMPLATE && !dec->tempDec->isStruct) {
+      traversal.walk(dec->tempDec->funcDec);
+    } else if (dec->type == GeneralDecType::STRUCT || dec->type == GeneralDecType::TEMPLATE) {
+      StructDec& structDec = dec->type == GeneralDecType::STRUCT ? *dec->structDec : dec->tempDec->structDec;
+      for (StructMember& member : structDec.decs) {
+        if (member.type == StructDecType::FUNC) {
+          traversal.walk(*member.funcDec);
+        }
+      }
+    }
+  }
+}
+
+/**
+ * Counts the blocks a pool takes from the source it wraps
+*/
+struct CountingBlockSource: BlockSource {
+  BlockSource& source;
+  size_t allocations{0};
+  size_t bytes{0};
+  explicit CountingBlockSource(BlockSource& source): source{source} {}
+
+  void *allocate(size_t size) override {
+    ++allocations;
+    bytes += size;
+    return source.allocate(size);
+  }
+  void deallocate(void *block, size_t size) override { source.deallocate(block, size); }
+  void discard(void *block, size_t size) override { source.discard(block, size); }
+};
+
+long minorFaults() {
+#if defined(__linux__)
+  rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_minflt;
+#else
+  return 0;
+#endif
+}
+
+/**
+ * \returns kilobytes of this process backed by transparent huge pages, or -1 if unknown
+*/
+long anonHugePagesKB() {
+  const std::string field = "AnonHugePages:";
+  std::ifstream smaps("/proc/self/smaps_rollup");
+  std::string line;
+  while (std::getline(smaps, line)) {
+    if (line.compare(0, field.size(), field) == 0) {
+      return std::stol(line.substr(field.size()));
+    }
+  }
+  return -1;
+}
+
+int usage(const char *program) {
+  std::cerr << "Usage: " << program << " [--source malloc|reserved] [--no-hint] [--walks N] <size in KB>\n";
+  return 1;
+}
+
+int main(int argc, char *argv[]) {
+  std::string sourceName = "reserved";
+  bool hint = true;
+  uint32_t walks = 10;
+  size_t sizeKB = 0;
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg = argv[i];
+    if (arg == "--source" && i + 1 < argc) {
+      sourceName = argv[++i];
+    } else if (arg == "--no-hint") {
+      hint = false;
+    } else if (arg == "--walks" && i + 1 < argc) {
+      walks = std::stoul(argv[++i]);
+    } else if (!arg.empty() && arg[0] != '-') {
+      sizeKB = std::stoull(arg);
+    } else {
+      return usage(argv[0]);
+    }
+  }
+  if (sizeKB == 0 || (sourceName != "malloc" && sourceName != "reserved")) {
+    return usage(argv[0]);
+  }
+  std::string source;
+  generateProgram(sizeKB << 10, source);
+
+  ReservedBlockSource reserved;
+  BlockSource *backing = &mallocBlockSource();
+  if (sourceName == "reserved") {
+    backing = &reserved;
+  }
+  CountingBlockSource blocks{*backing};
+  NodeMemPool mem{&blocks};
+  std::vector<Tokenizer> tokenizers;
+  tokenizers.emplace_back("bench.pr", std::move(source));
+  TlbMissCounter tlbMisses;
+  const long faultsBefore = minorFaults();
+  tlbMisses.start();
+  const auto start = std::chrono::steady_clock::now();
+
+  if (hint) {
+    mem.reserveForSource(tokenizers[0].content.size());
+  }
+  Parser parser{tokenizers[0], mem};
+  Checker checker{parser.program, tokenizers, mem};
+  parser.onGeneralDec = [&checker](GeneralDec& dec) {
+    checker.registerDec(dec);
+  };
+  parser.parse();
+  const double parseMs = millisecondsSince(start);
+  checker.fullScan();
+  const double checkMs = millisecondsSince(start) - parseMs;
+  NodeCounter counter;
+  Traversal<NodeCounter> traversal{counter};
+  for (uint32_t i = 0; i < walks; ++i) {
+    walkFunctions(parser.program, traversal);
+  }
+  const double totalMs = millisecondsSince(start);
+  const long long misses = tlbMisses.stop();
+  const long faults = minorFaults() - faultsBefore;
+
+  const size_t nodes = (counter.statements + counter.expressions) / std::max(walks, 1u);
+  std::cout << "input: " << tokenizers[0].newlinePositions.size() << " lines, " << (tokenizers[0].content.size() >> 10) << "KB\n";
+  std::cout << "source: " << sourceName << (sourceName == "reserved" && !reserved.isReserved() ? " (fell back to malloc)" : "");
+  std::cout << ", hint: " << (hint ? "on" : "off") << '\n';
+  std::cout << "block allocations: " << blocks.allocations << ", " << (blocks.bytes >> 10) << "KB\n";
+  std::cout << "time: parse " << parseMs << "ms, check " << checkMs << "ms, " << walks << " walks " << totalMs - parseMs - checkMs << "ms, total " << totalMs << "ms\n";
+  if (nodes) {
+    std::cout << "parse time per statement or expression: " << parseMs * 1e6 / nodes << "ns (" << nodes << " nodes)\n";
+  }
+  std::cout << "minor page faults: " << faults << '\n';
+  std::cout << "AnonHugePages: " << anonHugePagesKB() << "KB\n";
+  if (misses >= 0) {
+    std::cout << "dTLB load misses: " << misses << '\n';
+  } else {
+    std::cout << "dTLB load misses: unavailable (" << strerror(tlbMisses.error) << ")\n";
+  }
+  return 0;
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+#include "../src/parser/parser.hpp"
+
+// one copy of the generated program's functions, '$' is replaced by the copy's number so that every copy checks.
+// the functions are those of sampleCode/test.pr, plus a loop of arithmetic
+const char *const benchFunctions = R"(
+func reverseList$(head: ListNode ptr): ListNode ptr {
+  prev: ListNode ptr = nullptr;
+  curr: ListNode ptr = head;
+  while (curr != nullptr) {
+    next: ListNode ptr = curr->next;
+    curr->next = prev;
+    prev = curr;
+    curr = next;
+  }
+  return prev;
+}
+
+func reverseKGroup$(head: ListNode ptr, k: int32): ListNode ptr {
+  curr: ListNode ptr = head;
+  for (i: int32 = 0; i < k - 1; ++i) {
+    if (!curr) {
+      return head;
+    }
+    curr = curr->next;
+  }
+  next: ListNode ptr = curr->next;
+  curr->next = nullptr;
+  newHead: ListNode ptr = reverseList$(head);
+  head->next = next;
+  curr = next;
+  while (curr) {
+    for (i: int32 = 0; i < k - 1; ++i) {
+      if (!curr) {
+        return newHead;
+      }
+      curr = curr->next;
+    }
+    if (!curr) {
+      return newHead;
+    }
+    next = curr->next;
+    curr->next = nullptr;
+    temp: ListNode ptr = head;
+    head = head->next;
+    temp->next = reverseList$(head);
+    head->next = next;
+    curr = next;
+  }
+  return newHead;
+}
+
+func sum$(head: ListNode ptr, scale: int32): int32 {
+  total: int32 = 0;
+  for (curr: ListNode ptr = head; curr != nullptr; curr = curr->next) {
+    total = total + curr->val * scale - (total / 2) % 7;
+    if (total > 1000) {
+      total = total - 1000;
+    }
+  }
+  return total;
+}
+)";
+
+/**
+ * Builds a benchmark input of at least the given size that parses and checks without errors,
+ * from copies of benchFunctions
+*/
+inline void generateProgram(size_t bytes, std::string& out) {
+  const std::string functions = benchFunctions;
+  out = "struct ListNode {\n  val: int32;\n  next: ListNode ptr;\n}\n";
+  out.reserve(bytes + functions.size() * 2);
+  for (uint32_t copy = 0; out.size() < bytes; ++copy) {
+    const std::string number = std::to_string(copy);
+    for (const char c : functions) {
+      if (c == '$') {
+        out += number;
+      } else {
+        out += c;
+      }
+    }
+  }
+}
+
+inline double millisecondsSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
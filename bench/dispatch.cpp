@@ -0,0 +1,39 @@
+// Parse time of a statement heavy program, the cost that statement dispatch in Parser::parseStatement is part of.
+// Parses a generated program of the requested size several times and reports the fastest run.
+// Only uses the parser's constructor and parse, so it builds against older trees to compare them
+#include <algorithm>
+#include <iostream>
+#include "bench.hpp"
+
+int main(int argc, char *argv[]) {
+  if (argc < 2 || argc > 3) {
+    std::cerr << "Usage: " << argv[0] << " <size in KB> [runs]\n";
+    return 1;
+  }
+  const size_t sizeKB = std::stoull(argv[1]);
+  const uint32_t runs = argc == 3 ? std::stoul(argv[2]) : 10;
+  std::string source;
+  generateProgram(sizeKB << 10, source);
+
+  const size_t lines = std::count(source.begin(), source.end(), '\n');
+  double fastestMs = 0;
+  for (uint32_t run = 0; run < runs; ++run) {
+    Tokenizer tokenizer{"bench.pr", std::string{source}};
+    // a new pool for every run, older trees could not parse again into a pool that was reset
+    NodeMemPool mem;
+    Parser parser{tokenizer, mem};
+    const auto start = std::chrono::steady_clock::now();
+    if (!parser.parse()) {
+      std::cerr << "The generated program did not parse\n";
+      return 1;
+    }
+    const double ms = millisecondsSince(start);
+    if (run == 0 || ms < fastestMs) {
+      fastestMs = ms;
+    }
+  }
+  std::cout << "input: " << (source.size() >> 10) << "KB, " << lines << " lines\n";
+  std::cout << "fastest of " << runs << " parses: " << fastestMs << "ms, " << fastestMs * 1e6 / lines << "ns per line, ";
+  std::cout << source.size() / fastestMs / 1e3 << "MB/s\n";
+  return 0;
+}
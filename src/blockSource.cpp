@@ -0,0 +1,103 @@
+#include "blockSource.hpp"
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#endif
+
+namespace {
+
+const size_t pageSize = 4096;
+const size_t hugePageSize = 2 << 20;
+
+size_t roundUp(size_t size, size_t alignment) {
+  return (size + alignment - 1) & ~(alignment - 1);
+}
+
+}
+
+void *MallocBlockSource::allocate(size_t size) {
+  void *block = malloc(size);
+  if (!block) {
+    throw std::bad_alloc{};
+  }
+  return block;
+}
+
+void MallocBlockSource::deallocate(void *block, size_t) {
+  free(block);
+}
+
+MallocBlockSource& mallocBlockSource() {
+  static MallocBlockSource source;
+  return source;
+}
+
+ReservedBlockSource::ReservedBlockSource(size_t reserveBytes) {
+#if defined(__unix__) || defined(__APPLE__)
+  // reserve an extra huge page so the range can start on a huge page boundary
+  mappingSize = roundUp(reserveBytes, hugePageSize) + hugePageSize;
+  int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#ifdef MAP_NORESERVE
+  flags |= MAP_NORESERVE;
+#endif
+  mapping = mmap(nullptr, mappingSize, PROT_READ | PROT_WRITE, flags, -1, 0);
+  if (mapping == MAP_FAILED) {
+    mapping = nullptr;
+    return;
+  }
+  begin = (char *)roundUp((uintptr_t)mapping, hugePageSize);
+  end = begin + roundUp(reserveBytes, hugePageSize);
+  next = begin;
+#ifdef MADV_HUGEPAGE
+  madvise(begin, end - begin, MADV_HUGEPAGE);
+#endif
+#else
+  (void)reserveBytes;
+#endif
+}
+
+ReservedBlockSource::~ReservedBlockSource() {
+#if defined(__unix__) || defined(__APPLE__)
+  if (mapping) {
+    munmap(mapping, mappingSize);
+  }
+#endif
+}
+
+void *ReservedBlockSource::allocate(size_t size) {
+  size = roundUp(size, pageSize);
+  if (!begin || size > (size_t)(end - next)) {
+    return mallocBlockSource().allocate(size);
+  }
+  void *block = next;
+  next += size;
+  return block;
+}
+
+void ReservedBlockSource::deallocate(void *block, size_t size) {
+  char *data = (char *)block;
+  if (data < begin || data >= end) {
+    free(block);
+    return;
+  }
+#if defined(__unix__) || defined(__APPLE__)
+  size = roundUp(size, pageSize);
+  madvise(data, size, MADV_DONTNEED);
+  // pools give blocks back newest first, so the range can usually be handed out again
+  if (data + size == next) {
+    next = data;
+  }
+#endif
+}
+
+void ReservedBlockSource::discard(void *block, size_t size) {
+  char *data = (char *)block;
+  if (data < begin || data >= end) {
+    return;
+  }
+#if defined(__unix__) || defined(__APPLE__)
+  madvise(data, roundUp(size, pageSize), MADV_DONTNEED);
+#endif
+}
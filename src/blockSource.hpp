@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+
+/**
+ * Backing memory for pools. A pool takes whole blocks from a source and gives them back when it is trimmed or destroyed.
+ * allocate throws std::bad_alloc when there is no memory left
+*/
+struct BlockSource {
+  virtual ~BlockSource() = default;
+  virtual void *allocate(size_t size) = 0;
+  virtual void deallocate(void *block, size_t size) = 0;
+  // the pool keeps the block, but its contents are no longer needed (the pool was reset)
+  virtual void discard(void *, size_t) {}
+};
+
+/**
+ * Blocks from malloc, the default source. Discarded blocks are kept as they are
+*/
+struct MallocBlockSource: BlockSource {
+  void *allocate(size_t size) override;
+  void deallocate(void *block, size_t size) override;
+};
+
+MallocBlockSource& mallocBlockSource();
+
+/**
+ * Blocks carved one after another out of a single reserved range of virtual memory.
+ * Pages are only backed by physical memory once they are touched, and the range is marked for transparent huge pages,
+ * so a large AST is covered by few TLB entries. Blocks that are given back or discarded return their pages to the system.
+ * Falls back to malloc when the range cannot be reserved or is used up.
+ * Not thread safe
+*/
+struct ReservedBlockSource: BlockSource {
+  char *begin{nullptr};
+  char *end{nullptr};
+  char *next{nullptr}; // start of the part of the range that was not handed out
+  size_t mappingSize{0};
+  void *mapping{nullptr};
+
+  explicit ReservedBlockSource(size_t reserveBytes = (size_t)4 << 30);
+  ReservedBlockSource(const ReservedBlockSource&) = delete;
+  ReservedBlockSource& operator=(const ReservedBlockSource&) = delete;
+  ~ReservedBlockSource() override;
+
+  void *allocate(size_t size) override;
+  void deallocate(void *block, size_t size) override;
+  void discard(void *block, size_t size) override;
+  bool isReserved() const { return begin != nullptr; }
+};
@@ -1,5 +1,8 @@
 #include "checker.hpp"
+#include <algorithm>
+#include <atomic>
 #include <iostream>
+#include <thread>
 
 Token getTokenOfExpression(Expression& exp) {
   switch (exp.type) {
@@ -7,7 +10,11 @@ Token getTokenOfExpression(Expression& exp) {
       return exp.arrAccess->array;
     }
     case ExpressionType::ARRAY_OR_STRUCT_LITERAL: {
-      return getTokenOfExpression(exp.arrayOrStruct->values.curr);
+      if (exp.arrayOrStruct->values.empty()) {
+        std::cerr << "cannot get token of this expression\n";
+        exit(1);
+      }
+      return getTokenOfExpression(exp.arrayOrStruct->values[0]);
     }
     case ExpressionType::BINARY_OP: {
       return exp.binOp->op;
@@ -31,32 +38,17 @@ Token getTokenOfExpression(Expression& exp) {
   }
 }
 
-TokenList Checker::noneValue {Token{0,0,TokenType::NOTHING}};
-TokenList Checker::badValue {Token{0,0,TokenType::BAD_VALUE}};
-TokenList Checker::boolValue {Token{0,0,TokenType::BOOL}};
-TokenList Checker::int32Value {Token{0,0,TokenType::INT32_TYPE}};
-TokenList Checker::uint32Value {Token{0,0,TokenType::UINT32_TYPE}};
-TokenList Checker::int64Value {Token{0,0,TokenType::INT64_TYPE}};
-TokenList Checker::uint64Value {Token{0,0,TokenType::UINT64_TYPE}};
-TokenList Checker::charValue {Token{0,0,TokenType::CHAR_TYPE}};
-TokenList Checker::stringValue {Token{0,0,TokenType::POINTER}, &Checker::charValue};
-TokenList Checker::floatValue {Token{0,0,TokenType::FLOAT_TYPE}};
-TokenList Checker::doubleValue {Token{0,0,TokenType::DOUBLE_TYPE}};
-TokenList Checker::voidValue {Token{0,0,TokenType::VOID}};
-TokenList Checker::ptrValue {Token{0,0,TokenType::POINTER}, &Checker::voidValue};
-TokenList Checker::nullptrValue {Token{0,0,TokenType::NULL_PTR}};
-
-CheckerError::CheckerError(CheckerErrorType type, uint32_t tkIndex, Token token): token{token}, dec{nullptr}, tkIndex{tkIndex}, type{type}  {}
-CheckerError::CheckerError(CheckerErrorType type, uint32_t tkIndex, Token token, GeneralDec *decPtr): token{token}, dec{decPtr}, tkIndex{tkIndex}, type{type} {}
-CheckerError::CheckerError(CheckerErrorType type, uint32_t tkIndex, Expression *expression): dec{}, tkIndex{tkIndex}, type{type} {
+CheckerError::CheckerError(CheckerErrorType type, Token token): token{token}, dec{nullptr}, type{type}  {}
+CheckerError::CheckerError(CheckerErrorType type, Token token, GeneralDec *decPtr): token{token}, dec{decPtr}, type{type} {}
+CheckerError::CheckerError(CheckerErrorType type, Expression *expression): dec{}, type{type} {
   token = getTokenOfExpression(*expression);
 }
-CheckerError::CheckerError(CheckerErrorType type, uint32_t tkIndex, Expression *expression, GeneralDec *decPtr): dec{decPtr}, tkIndex{tkIndex}, type{type} {
+CheckerError::CheckerError(CheckerErrorType type, Expression *expression, GeneralDec *decPtr): dec{decPtr}, type{type} {
   token = getTokenOfExpression(*expression);
 }
 
 std::string CheckerError::getErrorMessage(std::vector<Tokenizer>& tokenizers) {
-  auto& tk = tokenizers[tkIndex];
+  auto& tk = tokenizerAt(tokenizers, token.position);
   TokenPositionInfo posInfo = tk.getTokenPositionInfo(token);
   std::string message = tk.filePath + ':' + std::to_string(posInfo.lineNum) + ':' + std::to_string(posInfo.linePos) + '\n';
   switch (type) {
@@ -101,13 +93,50 @@ std::string CheckerError::getErrorMessage(std::vector<Tokenizer>& tokenizers) {
   return message;
 }
 
-ResultingType::ResultingType(TokenList* type, bool isLValue): type{type}, isLValue{isLValue} {}
+ResultingType::ResultingType(TypeId type, bool isLValue, GeneralDec *dec): type{type}, isLValue{isLValue}, dec{dec} {}
+
+/**
+ * Opens a scope of locals for its lifetime. Locals declared while it is open are dropped when it closes
+*/
+struct LocalScope {
+  Checker &checker;
+  const uint32_t outerStart;
+  explicit LocalScope(Checker &checker): checker{checker}, outerStart{checker.scopeStart} {
+    checker.scopeStart = checker.locals.size();
+  }
+  LocalScope(const LocalScope&) = delete;
+  ~LocalScope() {
+    checker.locals.erase(checker.locals.begin() + checker.scopeStart, checker.locals.end());
+    checker.scopeStart = outerStart;
+  }
+};
 
 Checker::Checker(Program& prog, std::vector<Tokenizer>& tks, NodeMemPool& mem):
-structsLookUp{}, lookUp{}, errors{}, program{prog}, tokenizers{tks}, memPool{mem} {}
+ownTables{std::make_unique<CheckerTables>()}, names{ownTables->names}, memberTables{ownTables->memberTables},
+structsLookUp{ownTables->structsLookUp}, lookUp{ownTables->lookUp}, errors{}, program{prog}, tokenizers{tks},
+memPool{mem}, types{ownTables->types}, instances{ownTables->instances}, instanceCache{ownTables->instanceCache},
+createdInstances{ownTables->createdInstances}, expressionCount{ownTables->expressionCount}, threads{std::max(1u, std::thread::hardware_concurrency())} {}
+
+/**
+ * Checker for a worker thread of fullScan, sharing the tables of another checker.
+ * Declarations it makes while checking come from its own pool
+*/
+Checker::Checker(Checker& shared, NodeMemPool& mem):
+names{shared.names}, memberTables{shared.memberTables}, structsLookUp{shared.structsLookUp}, lookUp{shared.lookUp},
+errors{}, program{shared.program}, tokenizers{shared.tokenizers}, memPool{mem}, types{shared.types},
+instances{shared.instances}, instanceCache{shared.instanceCache}, createdInstances{shared.createdInstances},
+expressionCount{shared.expressionCount}, shadowing{shared.shadowing}, threads{1} {}
 
 bool Checker::check() {
   firstTopLevelScan();
+  return checkRegistered();
+}
+
+/**
+ * Runs every check after the first top level scan.
+ * Use directly when declarations were already registered with registerDec
+*/
+bool Checker::checkRegistered() {
   if (!errors.empty()) {
     return false;
   }
@@ -116,12 +145,12 @@ bool Checker::check() {
     return false;
   }
   std::vector<StructDec *> chain;
-  for (GeneralDecList *list = &program.decs; list; list = list->next) {
-    if (list->curr.type != GeneralDecType::STRUCT) {
+  for (GeneralDec *dec : program.decs) {
+    if (dec->type != GeneralDecType::STRUCT) {
       continue;
     }
-    if (!list->curr.structDec->checked) {
-      checkForStructCycles(list->curr, chain);
+    if (!dec->structDec->checked) {
+      checkForStructCycles(*dec, chain);
     }
   }
   if (!errors.empty()) {
@@ -139,95 +168,98 @@ bool Checker::check() {
  * Also registers struct members in the struct table
 */
 void Checker::firstTopLevelScan() {
-  for (GeneralDecList *list = &program.decs; list; list = list->next) {
-    Tokenizer& tk = tokenizers[list->curr.tokenizerIndex];
-    switch (list->curr.type) {
-      case GeneralDecType::FUNCTION: {
-        GeneralDec* &decPtr = lookUp[tk.extractToken(list->curr.funcDec->name)];
-        if (decPtr) {
-          errors.emplace_back(CheckerErrorType::NAME_ALREADY_IN_USE, tk.tokenizerIndex, list->curr.funcDec->name, decPtr);
-        } else {
-          decPtr = &list->curr;
-        }
-        break;
+  for (GeneralDec *dec : program.decs) {
+    registerDec(*dec);
+  }
+}
+
+/**
+ * Registers a single global declaration, the first top level scan step.
+ * Can be called as each declaration is parsed, followed by checkRegistered once parsing is done
+*/
+void Checker::registerDec(GeneralDec& dec) {
+  switch (dec.type) {
+    case GeneralDecType::FUNCTION: {
+      auto [decPtr, inserted] = lookUp.insert(tokenText(dec.funcDec->name), &dec);
+      if (!inserted) {
+        errors.emplace_back(CheckerErrorType::NAME_ALREADY_IN_USE, dec.funcDec->name, *decPtr);
       }
-      case GeneralDecType::VARIABLE: {
-        GeneralDec* &decPtr = lookUp[tk.extractToken(list->curr.varDec->name)];
-        if (decPtr) {
-          errors.emplace_back(CheckerErrorType::NAME_ALREADY_IN_USE, tk.tokenizerIndex, list->curr.varDec->name, decPtr);
-        } else {
-          decPtr = &list->curr;
-        }
-        break;
+      break;
+    }
+    case GeneralDecType::VARIABLE: {
+      auto [decPtr, inserted] = lookUp.insert(tokenText(dec.varDec->name), &dec);
+      if (!inserted) {
+        errors.emplace_back(CheckerErrorType::NAME_ALREADY_IN_USE, dec.varDec->name, *decPtr);
+      }
+      break;
+    }
+    case GeneralDecType::STRUCT: {
+      const SymbolKey structName{tokenText(dec.structDec->name)};
+      auto [decPtr, inserted] = lookUp.insert(structName, &dec);
+      if (!inserted) {
+        errors.emplace_back(CheckerErrorType::NAME_ALREADY_IN_USE, dec.structDec->name, *decPtr);
+      } else {
+        MemberTable &members = memberTables.emplace_back(names);
+        structsLookUp.insert(structName, &members);
+        registerStructMembers(*dec.structDec, members);
       }
-      case GeneralDecType::STRUCT: {
-        const std::string structName = tk.extractToken(list->curr.structDec->name);
-        GeneralDec* &decPtr = lookUp[structName];
-        if (decPtr) {
-          errors.emplace_back(CheckerErrorType::NAME_ALREADY_IN_USE, tk.tokenizerIndex, list->curr.structDec->name, decPtr);
-        } else {
-          decPtr = &list->curr;
-          auto& structDecLookUp = structsLookUp[structName];
-          if (list->curr.structDec->decs.type == StructDecType::NONE) {
-            errors.emplace_back(CheckerErrorType::EMPTY_STRUCT, tk.tokenizerIndex, list->curr.structDec->name);
-            break;
-          }
-          for (StructDecList* inner = &list->curr.structDec->decs; inner; inner = inner->next) {
-            StructDecList** innerStructDecPtr;
-            Token token;
-            if (inner->type == StructDecType::VAR) {
-              token = inner->varDec->name;
-              innerStructDecPtr = &structDecLookUp[tk.extractToken(inner->varDec->name)];
-            } else {
-              token = inner->funcDec->name;
-              innerStructDecPtr = &structDecLookUp[tk.extractToken(inner->funcDec->name)];
-            }
-            if (*innerStructDecPtr) {
-              GeneralDec *errorDec = memPool.makeGeneralDec();
-              if ((*innerStructDecPtr)->type == StructDecType::FUNC) {
-                errorDec->type = GeneralDecType::FUNCTION;
-                errorDec->funcDec = (*innerStructDecPtr)->funcDec;
-              } else {
-                errorDec->type = GeneralDecType::VARIABLE;
-                errorDec->varDec = (*innerStructDecPtr)->varDec;
-              }
-              errors.emplace_back(CheckerErrorType::NAME_ALREADY_IN_USE, tk.tokenizerIndex, token, errorDec);
-            } else {
-              *innerStructDecPtr = inner;
-            }
-          }
-        }
 
-        break;
+      break;
+    }
+    case GeneralDecType::TEMPLATE: {
+      Token token{0,0,TokenType::NOTHING};
+      if (dec.tempDec->isStruct) {
+        token = dec.tempDec->structDec.name;
+      } else {
+        // dec.temp->dec.decType == DecType::FUNCTION
+        token = dec.tempDec->funcDec.name;
       }
-      case GeneralDecType::TEMPLATE: {
-        Token token{0,0,TokenType::NOTHING};
-        if (list->curr.tempDec->isStruct) {
-          token = list->curr.tempDec->structDec.name;
-        } else {
-          // dec.temp->dec.decType == DecType::FUNCTION
-          token = list->curr.tempDec->funcDec.name;
-        }
-        GeneralDec* &decPtr = lookUp[tk.extractToken(token)];
-        if (decPtr) {
-          errors.emplace_back(CheckerErrorType::NAME_ALREADY_IN_USE, tk.tokenizerIndex, token, decPtr);
-        } else {
-          decPtr = &list->curr;
-        }
-        break;
+      const SymbolKey templateName{tokenText(token)};
+      auto [decPtr, inserted] = lookUp.insert(templateName, &dec);
+      if (!inserted) {
+        errors.emplace_back(CheckerErrorType::NAME_ALREADY_IN_USE, token, *decPtr);
+      } else if (dec.tempDec->isStruct) {
+        // members are shared by all instances
+        MemberTable &members = memberTables.emplace_back(names);
+        structsLookUp.insert(templateName, &members);
+        registerStructMembers(dec.tempDec->structDec, members);
       }
-      case GeneralDecType::TEMPLATE_CREATE: {
-        GeneralDec* &decPtr = lookUp[tk.extractToken(list->curr.tempCreate->typeName)];
-        if (decPtr) {
-          errors.emplace_back(CheckerErrorType::NAME_ALREADY_IN_USE, tk.tokenizerIndex, list->curr.tempCreate->typeName, decPtr);
-        } else {
-          decPtr = &list->curr;
-        }
-        break;
+      break;
+    }
+    case GeneralDecType::TEMPLATE_CREATE: {
+      auto [decPtr, inserted] = lookUp.insert(tokenText(dec.tempCreate->typeName), &dec);
+      if (!inserted) {
+        errors.emplace_back(CheckerErrorType::NAME_ALREADY_IN_USE, dec.tempCreate->typeName, *decPtr);
       }
-      default: {
-        break;
+      break;
+    }
+    default: {
+      break;
+    }
+  }
+}
+
+/**
+ * Registers the members of a struct in its member table, checking that each name is only used once
+*/
+void Checker::registerStructMembers(StructDec& structDec, MemberTable& members) {
+  if (structDec.decs.empty()) {
+    errors.emplace_back(CheckerErrorType::EMPTY_STRUCT, structDec.name);
+    return;
+  }
+  for (StructMember& inner : structDec.decs) {
+    const Token token = inner.type == StructDecType::VAR ? inner.varDec->name : inner.funcDec->name;
+    auto [innerStructDecPtr, inserted] = members.insert(tokenText(token), &inner);
+    if (!inserted) {
+      GeneralDec *errorDec = memPool.makeGeneralDec();
+      if ((*innerStructDecPtr)->type == StructDecType::FUNC) {
+        errorDec->type = GeneralDecType::FUNCTION;
+        errorDec->funcDec = (*innerStructDecPtr)->funcDec;
+      } else {
+        errorDec->type = GeneralDecType::VARIABLE;
+        errorDec->varDec = (*innerStructDecPtr)->varDec;
       }
+      errors.emplace_back(CheckerErrorType::NAME_ALREADY_IN_USE, token, errorDec);
     }
   }
 }
@@ -237,90 +269,58 @@ void Checker::firstTopLevelScan() {
  * Everything that was registered in the first pass
 */
 void Checker::secondTopLevelScan() {
-  for (GeneralDecList* list = &program.decs; list; list = list->next) {
-    Tokenizer& tk = tokenizers[list->curr.tokenizerIndex];
-    switch (list->curr.type) {
+  for (GeneralDec *globalDec : program.decs) {
+    switch (globalDec->type) {
       case GeneralDecType::FUNCTION: {
-        validateFunctionHeader(tk, *list->curr.funcDec);
+        validateFunctionHeader(*globalDec->funcDec);
         break;
       }
       case GeneralDecType::VARIABLE: {
-        checkType(tk, list->curr.varDec->type);
+        globalDec->varDec->typeId = checkType(globalDec->varDec->type);
         break;
       }
       case GeneralDecType::STRUCT: {
-        validateStructTopLevel(tk, list->curr.tempDec->structDec);
+        validateStructTopLevel(globalDec->tempDec->structDec);
         break;
       }
       case GeneralDecType::TEMPLATE: {
         // parser validates that there is at least one type
-        std::vector<std::string> templateTypes;
-        TokenList *templateIdentifiers = &list->curr.tempDec->templateTypes;
+        std::vector<SymbolKey> templateTypes;
+        TokenList *templateIdentifiers = &globalDec->tempDec->templateTypes;
         // add templated types to global lookup
         bool errorFound = false;
         do {
-          templateTypes.push_back(tk.extractToken(templateIdentifiers->token));
-          GeneralDec *&tempTypeDec = lookUp[templateTypes.back()];
-          if (tempTypeDec) {
-            errors.emplace_back(CheckerErrorType::NAME_ALREADY_IN_USE, tk.tokenizerIndex, templateIdentifiers->token, tempTypeDec);
+          templateTypes.emplace_back(tokenText(templateIdentifiers->token));
+          auto [tempTypeDec, inserted] = lookUp.insert(templateTypes.back(), nullptr);
+          if (!inserted) {
+            errors.emplace_back(CheckerErrorType::NAME_ALREADY_IN_USE, templateIdentifiers->token, *tempTypeDec);
             errorFound = true;
             break;
           }
-          tempTypeDec = memPool.makeGeneralDec();
-          tempTypeDec->type = GeneralDecType::STRUCT;
+          *tempTypeDec = memPool.makeGeneralDec();
+          (*tempTypeDec)->type = GeneralDecType::STRUCT;
           templateIdentifiers = templateIdentifiers->next;
         } while (templateIdentifiers);
         // validate top level types
         if (errorFound) {
           break;
         }
-        if (list->curr.tempDec->isStruct) {
-          validateStructTopLevel(tk, list->curr.tempDec->structDec);
+        if (globalDec->tempDec->isStruct) {
+          validateStructTopLevel(globalDec->tempDec->structDec);
         } else {
-          validateFunctionHeader(tk, list->curr.tempDec->funcDec);
+          validateFunctionHeader(globalDec->tempDec->funcDec);
         }
         // remove templated types
         while (!templateTypes.empty()) {
-          auto tempType = lookUp.find(templateTypes.back());
-          memPool.release(tempType->second);
-          lookUp.erase(tempType);
+          memPool.release(*lookUp.find(templateTypes.back()));
+          lookUp.erase(templateTypes.back());
           templateTypes.pop_back();
         }
         break;
       }
       case GeneralDecType::TEMPLATE_CREATE: {
-        // check that the template exists
-        GeneralDec* dec = lookUp[tk.extractToken(list->curr.tempCreate->templateName)];
-        if (!dec) {
-          errors.emplace_back(CheckerErrorType::NO_SUCH_TEMPLATE, tk.tokenizerIndex, list->curr.tempCreate->templateName);
-          break;
-        } else if (dec->type != GeneralDecType::TEMPLATE) {
-          errors.emplace_back(CheckerErrorType::NOT_A_TEMPLATE, tk.tokenizerIndex, list->curr.tempCreate->templateName, dec);
-          break;
-        }
-        // check that the number of types match and that the types exist
-        TokenList *tempList = &dec->tempDec->templateTypes, *createList = &list->curr.tempCreate->templateTypes;
-        for (;tempList && createList; tempList = tempList->next, createList = createList->next) {
-          if (createList->token.type == TokenType::IDENTIFIER) {
-            GeneralDec *templateType = lookUp[tk.extractToken(createList->token)];
-            if (!templateType) {
-              errors.emplace_back(CheckerErrorType::NO_SUCH_TYPE, tk.tokenizerIndex, createList->token);
-              tempList = nullptr;
-              createList = nullptr;
-              break;
-            }
-          }
-        }
-        if (tempList || createList) {
-          if (createList) {
-            errors.emplace_back(CheckerErrorType::WRONG_NUMBER_OF_ARGS, tk.tokenizerIndex, createList->token, dec);
-          } else {
-            errors.emplace_back(CheckerErrorType::WRONG_NUMBER_OF_ARGS, tk.tokenizerIndex, list->curr.tempCreate->templateTypes.token, dec);
-          }
-          break;
-        }
+        instantiate(*globalDec);
         break;
-        // have to deep copy the template declaration, replace all occurrences of templated types with the actual
       }
       default: break;
     }
@@ -329,22 +329,265 @@ void Checker::secondTopLevelScan() {
 }
 
 void Checker::fullScan() {
-  for (GeneralDecList* list = &program.decs; list; list = list->next) {
-    Tokenizer& tk = tokenizers[list->curr.tokenizerIndex];
-    switch (list->curr.type) {
+  if (threads > 1) {
+    uint32_t functionCount = 0;
+    for (GeneralDec *globalDec : program.decs) {
+      functionCount += globalDec->type == GeneralDecType::FUNCTION;
+    }
+    if (functionCount >= minParallelFunctions) {
+      parallelFullScan();
+      return;
+    }
+  }
+  for (GeneralDec *globalDec : program.decs) {
+    switch (globalDec->type) {
       case GeneralDecType::FUNCTION: {
-        checkFunction(tk, *list->curr.funcDec);
+        checkFunction(*globalDec->funcDec);
+        break;
+      }
+      case GeneralDecType::TEMPLATE_CREATE: {
+        const uint32_t index = instantiate(*globalDec);
+        if (index != noInstance) {
+          checkInstanceBody(instances[index]);
+        }
         break;
       }
-      
       default: break;
     }
   }
 }
-bool Checker::validateFunctionHeader(Tokenizer& tk, FunctionDec &funcDec) {
+
+/**
+ * fullScan on several threads. Each thread has its own checker, so its own locals, errors, and pool for the
+ * declarations it makes, and they share the global tables. Threads claim functions in batches, in declaration order.
+ * Instances of function templates share the template's nodes, so this thread checks their bodies one at a time,
+ * before the workers start. Checking a body adds to its instance's types, which the workers read when they call it.
+ * The errors are put back together in declaration order, the same as a scan on one thread
+*/
+void Checker::parallelFullScan() {
+  // errors of one declaration, in the errors of the checker that checked it
+  struct DecErrors {
+    uint32_t dec;
+    const Checker *checker;
+    uint32_t begin;
+    uint32_t end;
+  };
+  struct Worker {
+    NodeMemPool pool;
+    Checker checker;
+    std::vector<DecErrors> decErrors;
+    std::thread thread;
+    explicit Worker(Checker& shared): checker{shared, pool} {}
+  };
+
+  std::vector<uint32_t> functions;
+  for (uint32_t i = 0; i < program.decs.size(); ++i) {
+    if (program.decs[i]->type == GeneralDecType::FUNCTION) {
+      functions.push_back(i);
+    }
+  }
+  std::atomic<uint32_t> nextBatch{0};
+  auto checkFunctions = [&](Checker& checker, std::vector<DecErrors>& decErrors) {
+    uint32_t first;
+    while ((first = nextBatch.fetch_add(functionBatchSize, std::memory_order_relaxed)) < functions.size()) {
+      const uint32_t last = std::min<size_t>(first + functionBatchSize, functions.size());
+      for (uint32_t i = first; i < last; ++i) {
+        const uint32_t begin = checker.errors.size();
+        checker.checkFunction(*program.decs[functions[i]]->funcDec);
+        if (checker.errors.size() != begin) {
+          decErrors.push_back(DecErrors{functions[i], &checker, begin, (uint32_t)checker.errors.size()});
+        }
+      }
+    }
+  };
+  const uint32_t scanStart = errors.size();
+  std::vector<DecErrors> decErrors;
+  auto recordErrors = [&](uint32_t dec, uint32_t begin) {
+    if (errors.size() != begin) {
+      decErrors.push_back(DecErrors{dec, this, begin, (uint32_t)errors.size()});
+    }
+  };
+  // instances and their types are only added before the workers start, after that the instance tables are only read
+  for (uint32_t i = 0; i < program.decs.size(); ++i) {
+    if (program.decs[i]->type == GeneralDecType::TEMPLATE_CREATE) {
+      const uint32_t begin = errors.size();
+      const uint32_t index = instantiate(*program.decs[i]);
+      if (index != noInstance) {
+        checkInstanceBody(instances[index]);
+      }
+      recordErrors(i, begin);
+    }
+  }
+
+  std::deque<Worker> workers;
+  for (uint32_t i = 1; i < threads && (i - 1) * functionBatchSize < functions.size(); ++i) {
+    Worker& worker = workers.emplace_back(*this);
+    worker.thread = std::thread{checkFunctions, std::ref(worker.checker), std::ref(worker.decErrors)};
+  }
+  checkFunctions(*this, decErrors);
+
+  for (Worker& worker : workers) {
+    worker.thread.join();
+    decErrors.insert(decErrors.end(), worker.decErrors.begin(), worker.decErrors.end());
+  }
+  std::stable_sort(decErrors.begin(), decErrors.end(), [](const DecErrors& a, const DecErrors& b) {
+    return a.dec < b.dec;
+  });
+  std::vector<CheckerError> merged(errors.begin(), errors.begin() + scanStart);
+  for (const DecErrors& range : decErrors) {
+    merged.insert(merged.end(), range.checker->errors.begin() + range.begin, range.checker->errors.begin() + range.end);
+  }
+  errors = std::move(merged);
+  expressionTypes.resize(expressionCount);
+  for (Worker& worker : workers) {
+    for (auto& [index, info] : worker.checker.workerAnnotations) {
+      expressionTypes[index] = info;
+    }
+    // declarations made by the workers may be referred to by the errors and annotations
+    memPool.adopt(worker.pool);
+  }
+}
+
+TypeId TemplateInstance::typeOf(const TokenList& type) const {
+  auto found = resolved.find(&type);
+  return found == resolved.end() ? TypeTable::badType : found->second;
+}
+
+/**
+ * Gets where the validated type of a declaration is kept. Declarations in a template are shared by all of its instances,
+ * so while an instance is being resolved or checked, its types are kept in the instance instead of the declaration
+ * \param type the declared type
+ * \param typeId the declaration's own type slot, used outside of templates
+*/
+TypeId& Checker::declaredTypeSlot(const TokenList& type, TypeId& typeId) {
+  return typeInstance ? typeInstance->resolved[&type] : typeId;
+}
+
+/**
+ * Gets the validated type of a declaration, see declaredTypeSlot. Within a template instance, declarations of the
+ * template have the instance's type, declarations outside of it (globals) their own
+*/
+TypeId Checker::declaredType(const TokenList& type, TypeId typeId) const {
+  if (typeInstance) {
+    auto found = typeInstance->resolved.find(&type);
+    if (found != typeInstance->resolved.end()) {
+      return found->second;
+    }
+  }
+  return typeId;
+}
+
+/**
+ * Sets the substitution environment to the arguments of an instance, so that checkType resolves the template's
+ * type parameters to them
+*/
+void Checker::bindTypeArguments(TemplateInstance& instance) {
+  typeArguments.clear();
+  const TokenList *parameter = &instance.templateDec->tempDec->templateTypes;
+  for (TypeId argument : instance.arguments) {
+    typeArguments.emplace_back(extractToken(parameter->token), argument);
+    parameter = parameter->next;
+  }
+}
+
+/**
+ * Instantiates the template named by a create declaration.
+ * Templates are never copied, an instance only holds the template's declared types with the arguments substituted.
+ * Instances are cached by template and argument types, so creating the same instance again costs a lookup
+ * \returns the index of the instance, or noInstance if the declaration is invalid
+*/
+uint32_t Checker::instantiate(GeneralDec& createDec) {
+  auto created = createdInstances.find(&createDec);
+  if (created != createdInstances.end()) {
+    return created->second;
+  }
+  // a create that refers to itself while it is being instantiated fails instead of recursing
+  createdInstances[&createDec] = noInstance;
+  TemplateCreation& create = *createDec.tempCreate;
+  // check that the template exists
+  GeneralDec *dec = findSymbol(tokenText(create.templateName));
+  if (!dec) {
+    errors.emplace_back(CheckerErrorType::NO_SUCH_TEMPLATE, create.templateName);
+    return noInstance;
+  }
+  if (dec->type != GeneralDecType::TEMPLATE) {
+    errors.emplace_back(CheckerErrorType::NOT_A_TEMPLATE, create.templateName, dec);
+    return noInstance;
+  }
+  // check that the number of types match and that the types exist
+  std::vector<TypeId> arguments;
+  TokenList *tempList = &dec->tempDec->templateTypes, *createList = &create.templateTypes;
+  for (;tempList && createList; tempList = tempList->next, createList = createList->next) {
+    TokenList argument{createList->token};
+    arguments.push_back(checkType(argument));
+    if (arguments.back() == TypeTable::badType) {
+      return noInstance;
+    }
+  }
+  if (tempList || createList) {
+    if (createList) {
+      errors.emplace_back(CheckerErrorType::WRONG_NUMBER_OF_ARGS, createList->token, dec);
+    } else {
+      errors.emplace_back(CheckerErrorType::WRONG_NUMBER_OF_ARGS, create.templateTypes.token, dec);
+    }
+    return noInstance;
+  }
+
+  auto cached = instanceCache.emplace(std::make_pair(dec, arguments), (uint32_t)instances.size());
+  const uint32_t index = cached.first->second;
+  createdInstances[&createDec] = index;
+  if (!cached.second) {
+    return index;
+  }
+  instances.emplace_back();
+  TemplateInstance& instance = instances.back();
+  instance.templateDec = dec;
+  instance.arguments = std::move(arguments);
+
+  // resolve the declared types of the template with the arguments substituted, into the instance
+  std::vector<std::pair<std::string, TypeId>> outerArguments = std::move(typeArguments);
+  TemplateInstance *outerInstance = typeInstance;
+  bindTypeArguments(instance);
+  typeInstance = &instance;
+  TemplateDec& tempDec = *dec->tempDec;
+  if (tempDec.isStruct) {
+    instance.type = types.instanceType(dec, index);
+    validateStructTopLevel(tempDec.structDec);
+  } else {
+    validateFunctionHeader(tempDec.funcDec);
+  }
+  typeInstance = outerInstance;
+  typeArguments = std::move(outerArguments);
+  return index;
+}
+
+/**
+ * Checks the body of a function template once per instance, with the instance's types substituted
+*/
+void Checker::checkInstanceBody(TemplateInstance& instance) {
+  TemplateDec& tempDec = *instance.templateDec->tempDec;
+  if (tempDec.isStruct || instance.bodyChecked) {
+    return;
+  }
+  instance.bodyChecked = true;
+  // the declarations are shared by all instances, their types are read from and written to the instance
+  std::vector<std::pair<std::string, TypeId>> outerArguments = std::move(typeArguments);
+  TemplateInstance *outerInstance = typeInstance;
+  bindTypeArguments(instance);
+  bodyInstance = &instance;
+  typeInstance = &instance;
+  checkFunction(tempDec.funcDec);
+  bodyInstance = nullptr;
+  typeInstance = outerInstance;
+  typeArguments = std::move(outerArguments);
+}
+
+bool Checker::validateFunctionHeader(FunctionDec &funcDec) {
   bool valid = true;
   // check return type
-  if (!checkType(tk, funcDec.returnType)) {
+  TypeId& returnTypeId = declaredTypeSlot(funcDec.returnType, funcDec.returnTypeId);
+  returnTypeId = checkType(funcDec.returnType);
+  if (returnTypeId == TypeTable::badType) {
     if (errors.back().type == CheckerErrorType::VOID_TYPE) {
       errors.pop_back();
     } else {
@@ -352,42 +595,40 @@ bool Checker::validateFunctionHeader(Tokenizer& tk, FunctionDec &funcDec) {
     }
   }
   // check parameters
-  if (funcDec.params.curr.type != StatementType::NOTHING) {
-    StatementList* params = &funcDec.params;
-    do {
-      if (!checkType(tk, params->curr.varDec->type)) {
-        valid = false;
-      }
-      params = params->next;
-    } while (params);
+  for (Statement& param : funcDec.params) {
+    TypeId& typeId = declaredTypeSlot(param.varDec->type, param.varDec->typeId);
+    typeId = checkType(param.varDec->type);
+    if (typeId == TypeTable::badType) {
+      valid = false;
+    }
   }
   return valid;
 }
 
 void Checker::checkForStructCycles(GeneralDec &generalDec, std::vector<StructDec *>& structChain) {
   structChain.emplace_back(generalDec.structDec);
-  // get the tokenizer for this declaration
-  Tokenizer &tk = tokenizers[generalDec.tokenizerIndex];
-  for (StructDecList *list = &generalDec.structDec->decs; list; list = list->next) {
-    if (list->type != StructDecType::VAR) {
+  for (StructMember& member : generalDec.structDec->decs) {
+    if (member.type != StructDecType::VAR) {
       continue;
     }
     // check for cycle
-    TokenList* tokenList = &list->varDec->type;
+    TokenList* tokenList = &member.varDec->type;
+    TypeId typeId = member.varDec->typeId;
     if (tokenList->token.type == TokenType::REFERENCE) {
       tokenList = tokenList->next;
+      typeId = types[typeId].next;
     }
     if (tokenList->token.type != TokenType::IDENTIFIER) {
       continue;
     }
-    GeneralDec *dec = lookUp[tk.extractToken(tokenList->token)];
-    if (dec->structDec->checked) {
+    GeneralDec *dec = types[typeId].dec;
+    if (dec->type != GeneralDecType::STRUCT || dec->structDec->checked) {
       continue; // dec already checked
     }
     for (StructDec *chainLink : structChain) {
       if (chainLink == dec->structDec) {
         // cycle found
-        errors.emplace_back(CheckerErrorType::STRUCT_CYCLE, generalDec.tokenizerIndex, tokenList->token, dec);
+        errors.emplace_back(CheckerErrorType::STRUCT_CYCLE, tokenList->token, dec);
         chainLink->hasCycle = true;
         break;
       }
@@ -400,13 +641,13 @@ void Checker::checkForStructCycles(GeneralDec &generalDec, std::vector<StructDec
   structChain.pop_back();
 }
 
-void Checker::validateStructTopLevel(Tokenizer& tk, StructDec& structDec) {
-  for (StructDecList *inner = &structDec.decs; inner; inner = inner->next) {
-    if (inner->type == StructDecType::VAR) {
-      checkType(tk, inner->varDec->type);
+void Checker::validateStructTopLevel(StructDec& structDec) {
+  for (StructMember& inner : structDec.decs) {
+    if (inner.type == StructDecType::VAR) {
+      declaredTypeSlot(inner.varDec->type, inner.varDec->typeId) = checkType(inner.varDec->type);
     }
-    else if (inner->type == StructDecType::FUNC) {
-      validateFunctionHeader(tk, *inner->funcDec);
+    else if (inner.type == StructDecType::FUNC) {
+      validateFunctionHeader(*inner.funcDec);
     }
   }
 }
@@ -416,113 +657,110 @@ void Checker::validateStructTopLevel(Tokenizer& tk, StructDec& structDec) {
  * \param funcDec the function declaration to check
  * \returns true if the function is valid
  */
-void Checker::checkFunction(Tokenizer& tk, FunctionDec& funcDec) {
+void Checker::checkFunction(FunctionDec& funcDec) {
+  LocalScope paramScope{*this};
   // validate parameter names
-  std::vector<std::string> locals;
-  if (funcDec.params.curr.type != StatementType::NOTHING) {
-    StatementList *list = &funcDec.params;
-    while (list) {
-      locals.emplace_back(tk.extractToken(list->curr.varDec->name));
-      GeneralDec* &paramDec = lookUp[locals.back()];
-      if (paramDec) {
-        errors.emplace_back(CheckerErrorType::NAME_ALREADY_IN_USE, tk.tokenizerIndex, list->curr.varDec->name, paramDec);
-        return;
-      }
-      // type already checked on second top level scan, just add it
-      paramDec = memPool.makeGeneralDec();
-      paramDec->varDec = list->curr.varDec;
-      paramDec->type = GeneralDecType::VARIABLE;
-      list = list->next;
+  for (Statement& param : funcDec.params) {
+    const SymbolKey key{tokenText(param.varDec->name)};
+    if (GeneralDec *conflict = findConflict(key)) {
+      errors.emplace_back(CheckerErrorType::NAME_ALREADY_IN_USE, param.varDec->name, conflict);
+      return;
     }
+    // type already checked on second top level scan, just add it
+    GeneralDec *paramDec = memPool.makeGeneralDec();
+    paramDec->varDec = param.varDec;
+    paramDec->type = GeneralDecType::VARIABLE;
+    locals.push_back(LocalSymbol{key, paramDec});
   }
   bool requireReturn = funcDec.returnType.token.type != TokenType::VOID;
-  if (!checkScope(tk, funcDec.body, funcDec.returnType, false, false) && requireReturn) {
-    errors.emplace_back(CheckerErrorType::NOT_ALL_CODE_PATHS_RETURN, tk.tokenizerIndex, funcDec.name);
-  }
-  while (!locals.empty()) {
-    // remove locals from table
-    lookUp.erase(locals.back());
-    locals.pop_back();
+  const TypeId returnTypeId = declaredType(funcDec.returnType, funcDec.returnTypeId);
+  if (!checkScope(funcDec.body, returnTypeId, false, false) && requireReturn) {
+    errors.emplace_back(CheckerErrorType::NOT_ALL_CODE_PATHS_RETURN, funcDec.name);
   }
 }
 
 /**
  * \param scope The scope to check
- * \param locals name of all local variables allocated 
  * \param returnType the return type of the scope
  * \param isReturnRequired set to true if a return is required within this scope
  * \returns true if all code paths return a value
 */
-bool Checker::checkScope(Tokenizer& tk, Scope& scope, TokenList& returnType, bool isLoop, bool isSwitch) {
-  std::vector<std::string> locals;
-  StatementList* list = &scope.scopeStatements;
+bool Checker::checkScope(Scope& scope, TypeId returnType, bool isLoop, bool isSwitch) {
+  LocalScope localScope{*this};
   bool wasReturned = false;
-  do {
-    switch (list->curr.type) {
+  for (Statement& statement : scope.scopeStatements) {
+    switch (statement.type) {
       case StatementType::CONTROL_FLOW: {
-        switch (list->curr.controlFlow->type) {
+        switch (statement.controlFlow->type) {
           // ForLoop forLoop;
           case ControlFlowStatementType::FOR_LOOP: {
-            auto& forLoop = *list->curr.controlFlow->forLoop;
+            auto& forLoop = *statement.controlFlow->forLoop;
+            // the loop variable is only in scope within the loop
+            LocalScope loopScope{*this};
             if (forLoop.initialize.type == StatementType::VARIABLE_DEC) {
-              checkLocalVarDec(tk, *forLoop.initialize.varDec, locals);
+              checkLocalVarDec(*forLoop.initialize.varDec);
             } else if (forLoop.initialize.type == StatementType::EXPRESSION) {
-              checkExpression(tk, *forLoop.initialize.expression);
+              checkExpression(*forLoop.initialize.expression);
             } else if (forLoop.initialize.type != StatementType::NOTHING) {
               exit(1);
             }
-            ResultingType res = checkExpression(tk, forLoop.condition);
-            if (res.type->token.type != TokenType::BAD_VALUE && res.type->token.type != TokenType::NOTHING && !canBeConvertedToBool(*res.type)) {
-              errors.emplace_back(CheckerErrorType::CANNOT_BE_CONVERTED_TO_BOOL, tk.tokenizerIndex, &forLoop.condition);
-            }
-            checkExpression(tk, forLoop.iteration);
-            checkScope(tk, forLoop.body, returnType, isLoop, isSwitch);
-            if (forLoop.initialize.type == StatementType::VARIABLE_DEC) {
-              lookUp.erase(locals.back());
-              locals.pop_back();
+            ResultingType res = checkExpression(forLoop.condition);
+            if (res.type != TypeTable::badType && res.type != TypeTable::noneType && !types.canBeConvertedToBool(res.type)) {
+              errors.emplace_back(CheckerErrorType::CANNOT_BE_CONVERTED_TO_BOOL, &forLoop.condition);
             }
+            checkExpression(forLoop.iteration);
+            checkScope(forLoop.body, returnType, isLoop, isSwitch);
             break;
           }
           case ControlFlowStatementType::CONDITIONAL_STATEMENT: {
-            auto & cond = *list->curr.controlFlow->conditional;
+            auto & cond = *statement.controlFlow->conditional;
             {
-              ResultingType res = checkExpression(tk, cond.ifStatement.condition);
-              if (res.type->token.type != TokenType::BAD_VALUE && 
-              !canBeConvertedToBool(*res.type)) {
-                errors.emplace_back(CheckerErrorType::CANNOT_BE_CONVERTED_TO_BOOL, tk.tokenizerIndex, &cond.ifStatement.condition);
+              ResultingType res = checkExpression(cond.ifStatement.condition);
+              if (res.type != TypeTable::badType && !types.canBeConvertedToBool(res.type)) {
+                errors.emplace_back(CheckerErrorType::CANNOT_BE_CONVERTED_TO_BOOL, &cond.ifStatement.condition);
               }
             }
-            checkScope(tk, cond.ifStatement.body, returnType, isLoop, isSwitch);
+            checkScope(cond.ifStatement.body, returnType, isLoop, isSwitch);
             for(ElifStatementList* elifList = cond.elifStatement; elifList; elifList = elifList->next) {
-              ResultingType res = checkExpression(tk, elifList->elif.condition);
-              if (res.type->token.type != TokenType::BAD_VALUE && 
-              !canBeConvertedToBool(*res.type)) {
-                errors.emplace_back(CheckerErrorType::CANNOT_BE_CONVERTED_TO_BOOL, tk.tokenizerIndex, &cond.ifStatement.condition);
+              ResultingType res = checkExpression(elifList->elif.condition);
+              if (res.type != TypeTable::badType && !types.canBeConvertedToBool(res.type)) {
+                errors.emplace_back(CheckerErrorType::CANNOT_BE_CONVERTED_TO_BOOL, &cond.ifStatement.condition);
               }
-              checkScope(tk, elifList->elif.body, returnType, isLoop, isSwitch);
+              checkScope(elifList->elif.body, returnType, isLoop, isSwitch);
             }
             if (cond.elseStatement) {
-              checkScope(tk, *cond.elseStatement, returnType, isLoop, isSwitch);
+              checkScope(*cond.elseStatement, returnType, isLoop, isSwitch);
             }
             break;
           }
           case ControlFlowStatementType::RETURN_STATEMENT: {
             wasReturned = true;
-            ResultingType res = checkExpression(tk, list->curr.controlFlow->returnStatement->returnValue);
-            if (res.type->token.type == TokenType::NOTHING && returnType.token.type == TokenType::VOID) {
+            ResultingType res = checkExpression(statement.controlFlow->returnStatement->returnValue);
+            if (res.type == TypeTable::noneType && returnType == TypeTable::voidType) {
               break; // ok
             }
-            if (!checkAssignment(returnType, *res.type)) {
-              errors.emplace_back(CheckerErrorType::INCORRECT_RETURN_TYPE, tk.tokenizerIndex, &list->curr.controlFlow->returnStatement->returnValue);
+            if (!types.checkAssignment(returnType, res.type)) {
+              errors.emplace_back(CheckerErrorType::INCORRECT_RETURN_TYPE, &statement.controlFlow->returnStatement->returnValue);
             }
             break;
           }
           case ControlFlowStatementType::SWITCH_STATEMENT: {
+            // the types of the cases are not checked against the switched value yet
+            auto& switchStatement = *statement.controlFlow->switchStatement;
+            checkExpression(switchStatement.switched);
+            for (SwitchScopeStatementList *list = &switchStatement.body; list; list = list->next) {
+              if (list->caseExpression) {
+                checkExpression(*list->caseExpression);
+              }
+              if (list->caseBody) {
+                checkScope(*list->caseBody, returnType, isLoop, true);
+              }
+            }
             break;
           }
           case ControlFlowStatementType::WHILE_LOOP: {
-            checkExpression(tk, list->curr.controlFlow->whileLoop->statement.condition);
-            checkScope(tk, list->curr.controlFlow->whileLoop->statement.body, returnType, isLoop, isSwitch);
+            checkExpression(statement.controlFlow->whileLoop->statement.condition);
+            checkScope(statement.controlFlow->whileLoop->statement.body, returnType, isLoop, isSwitch);
             break;
           }
           case ControlFlowStatementType::NONE: {
@@ -533,20 +771,20 @@ bool Checker::checkScope(Tokenizer& tk, Scope& scope, TokenList& returnType, boo
       }
       
       case StatementType::EXPRESSION: {
-        checkExpression(tk, *list->curr.expression);
+        checkExpression(*statement.expression);
         break;
       }
       
       case StatementType::KEYWORD: {
-        if (list->curr.keyword.type == TokenType::CONTINUE) {
+        if (statement.keyword.type == TokenType::CONTINUE) {
           if (!isLoop) {
-            errors.emplace_back(CheckerErrorType::CANNOT_HAVE_CONTINUE_HERE, tk.tokenizerIndex, list->curr.keyword);
+            errors.emplace_back(CheckerErrorType::CANNOT_HAVE_CONTINUE_HERE, statement.keyword);
           }
           break;
         }
-        else if (list->curr.keyword.type == TokenType::BREAK) {
+        else if (statement.keyword.type == TokenType::BREAK) {
           if (!isLoop && !isSwitch) {
-            errors.emplace_back(CheckerErrorType::CANNOT_HAVE_BREAK_HERE, tk.tokenizerIndex, list->curr.keyword);
+            errors.emplace_back(CheckerErrorType::CANNOT_HAVE_BREAK_HERE, statement.keyword);
           }
           break;
         } else {
@@ -558,51 +796,49 @@ bool Checker::checkScope(Tokenizer& tk, Scope& scope, TokenList& returnType, boo
       }
       
       case StatementType::SCOPE: {
-        checkScope(tk, *list->curr.scope, returnType, isLoop, isSwitch);
+        checkScope(*statement.scope, returnType, isLoop, isSwitch);
         break;
       }
 
       case StatementType::VARIABLE_DEC: {
-        checkLocalVarDec(tk, *list->curr.varDec, locals);
+        checkLocalVarDec(*statement.varDec);
         break;
       }
 
-      case StatementType::NOTHING: {
+      case StatementType::NOTHING:
+      case StatementType::ERROR: {
         break;
       }
     }
-    list = list->next;
-  } while (list);
-  while (!locals.empty()) {
-    // remove locals from table
-    lookUp.erase(locals.back());
-    locals.pop_back();
   }
   return wasReturned;
 }
 
-bool Checker::checkLocalVarDec(Tokenizer& tk, VariableDec& varDec, std::vector<std::string>& locals) {
-  // add local to table
-  locals.emplace_back(tk.extractToken(varDec.name));
-  GeneralDec*& dec = lookUp[locals.back()];
-  if (dec) {
-    errors.emplace_back(CheckerErrorType::NAME_ALREADY_IN_USE, tk.tokenizerIndex, varDec.name, dec);
+/**
+ * Checks a local variable declaration and adds the variable to the innermost scope
+*/
+bool Checker::checkLocalVarDec(VariableDec& varDec) {
+  const SymbolKey key{tokenText(varDec.name)};
+  if (GeneralDec *conflict = findConflict(key)) {
+    errors.emplace_back(CheckerErrorType::NAME_ALREADY_IN_USE, varDec.name, conflict);
     return false;
   }
-  if (!checkType(tk, varDec.type)) {
+  TypeId& typeId = declaredTypeSlot(varDec.type, varDec.typeId);
+  typeId = checkType(varDec.type);
+  if (typeId == TypeTable::badType) {
     return false;
   }
-  dec = memPool.makeGeneralDec();
+  GeneralDec *dec = memPool.makeGeneralDec();
   dec->type = GeneralDecType::VARIABLE;
   dec->varDec = &varDec;
+  locals.push_back(LocalSymbol{key, dec});
   if (dec->varDec->initialAssignment) {
-    ResultingType expressionType = checkExpression(tk, *varDec.initialAssignment);
-    if (expressionType.type->token.type == TokenType::BAD_VALUE) {
+    ResultingType expressionType = checkExpression(*varDec.initialAssignment);
+    if (expressionType.type == TypeTable::badType) {
       return false;
     }
-    ResultingType varType {&varDec.type, true};
-    if (!checkAssignment(*varType.type, *expressionType.type)) {
-      errors.emplace_back(CheckerErrorType::CANNOT_ASSIGN, tk.tokenizerIndex, varDec.initialAssignment);
+    if (!types.checkAssignment(typeId, expressionType.type)) {
+      errors.emplace_back(CheckerErrorType::CANNOT_ASSIGN, varDec.initialAssignment);
       return false;
     }
   }
@@ -610,275 +846,405 @@ bool Checker::checkLocalVarDec(Tokenizer& tk, VariableDec& varDec, std::vector<s
 }
 
 /**
- * Returns the resulting type from an expression
+ * Resolves a name, innermost scope first, then the global declarations
+ * \returns the declaration, or nullptr if there is none
+*/
+GeneralDec *Checker::findSymbol(const SymbolKey& key) {
+  for (size_t i = locals.size(); i-- > 0;) {
+    if (locals[i].key.hash == key.hash && locals[i].key.name == key.name) {
+      return locals[i].dec;
+    }
+  }
+  GeneralDec **global = lookUp.find(key);
+  return global ? *global : nullptr;
+}
+
+/**
+ * Finds the declaration that a new local with the given name would clash with, following the shadowing rule.
+ * Names are never reused within the same scope
+ * \returns the declaration, or nullptr if the name is free
+*/
+GeneralDec *Checker::findConflict(const SymbolKey& key) {
+  const size_t end = shadowing == Shadowing::OUTER_SCOPES ? scopeStart : 0;
+  for (size_t i = locals.size(); i-- > end;) {
+    if (locals[i].key.hash == key.hash && locals[i].key.name == key.name) {
+      return locals[i].dec;
+    }
+  }
+  if (shadowing != Shadowing::NONE) {
+    return nullptr;
+  }
+  GeneralDec **global = lookUp.find(key);
+  return global ? *global : nullptr;
+}
+
+/**
+ * Returns the resulting type from an expression, and keeps it as the expression's annotation
  * the ResultingType always contains a valid pointer
  * \param structMap pointer to a struct's lookup map. only used for the right side of binary member access operators
 */
-ResultingType Checker::checkExpression(Tokenizer& tk, Expression& expression, std::map<std::string, StructDecList *>* structMap) {
-  switch(expression.type) {
-    case ExpressionType::BINARY_OP: {
-      ResultingType leftSide = checkExpression(tk, expression.binOp->leftSide);
+ResultingType Checker::checkExpression(Expression& expression, MemberTable* structMap) {
+  if (expression.type == ExpressionType::BINARY_OP) {
+    return checkOperatorChain(expression);
+  }
+  const ResultingType result = resolveExpression(expression, structMap);
+  annotate(expression, result);
+  return result;
+}
 
-      if (expression.binOp->op.type == TokenType::LOGICAL_AND || expression.binOp->op.type == TokenType::LOGICAL_OR) {
-        if (leftSide.type->token.type != TokenType::BAD_VALUE) {
-          if (!canBeConvertedToBool(*leftSide.type)) {
-            errors.emplace_back(CheckerErrorType::CANNOT_BE_CONVERTED_TO_BOOL, tk.tokenizerIndex, &expression.binOp->leftSide);
-          }
-        }
-        ResultingType rightSide = checkExpression(tk, expression.binOp->rightSide);
-        if (!canBeConvertedToBool(*rightSide.type)) {
-          errors.emplace_back(CheckerErrorType::CANNOT_BE_CONVERTED_TO_BOOL, tk.tokenizerIndex, &expression.binOp->rightSide);
-        }
-        return {&boolValue, false};
-      }
-      
-      if (isLogicalOp(expression.binOp->op.type)) {
-        if (leftSide.type->token.type == TokenType::IDENTIFIER || leftSide.type->token.type == TokenType::VOID) {
-          errors.emplace_back(CheckerErrorType::CANNOT_COMPARE_TYPE, tk.tokenizerIndex, &expression.binOp->leftSide);
-        }
-        ResultingType rightSide = checkExpression(tk, expression.binOp->leftSide);
-        if (rightSide.type->token.type == TokenType::IDENTIFIER || rightSide.type->token.type == TokenType::VOID) {
-          errors.emplace_back(CheckerErrorType::CANNOT_COMPARE_TYPE, tk.tokenizerIndex, &expression.binOp->rightSide);
-        }
-        return {&boolValue, false};
-      }
+/**
+ * Keeps the result of checking an expression, see annotation.
+ * Annotation indexes are taken from the shared count in blocks, so checkers on different threads never hand out
+ * the same index
+*/
+void Checker::annotate(Expression& expression, const ResultingType& result) {
+  const ExpressionInfo info{result.dec, result.type, result.isLValue};
+  if (bodyInstance) {
+    bodyInstance->expressions[&expression] = info;
+    return;
+  }
+  if (!expression.annotation) {
+    if (nextAnnotation == annotationEnd) {
+      nextAnnotation = expressionCount.fetch_add(annotationBlockSize, std::memory_order_relaxed);
+      annotationEnd = nextAnnotation + annotationBlockSize;
+    }
+    expression.annotation = nextAnnotation++;
+  }
+  if (!ownTables) {
+    workerAnnotations.emplace_back(expression.annotation, info);
+    return;
+  }
+  if (expression.annotation >= expressionTypes.size()) {
+    expressionTypes.resize(expression.annotation + 1);
+  }
+  expressionTypes[expression.annotation] = info;
+}
 
-      // member access or number with decimal
-      if (expression.binOp->op.type == TokenType::DOT) {
-        TokenType tkType = leftSide.type->token.type;
-        if (tkType == TokenType::DECIMAL_NUMBER || tkType == TokenType::HEX_NUMBER || tkType == TokenType::BINARY_NUMBER) {
-          if (expression.binOp->rightSide.type != ExpressionType::VALUE) {
-            errors.emplace_back(CheckerErrorType::EXPECTING_NUMBER, tk.tokenizerIndex, &expression.binOp->rightSide);
-          }
-          else {
-            tkType = expression.binOp->rightSide.value.type;
-            if (tkType != TokenType::DECIMAL_NUMBER && tkType != TokenType::HEX_NUMBER && tkType != TokenType::BINARY_NUMBER) {
-              errors.emplace_back(CheckerErrorType::EXPECTING_NUMBER, tk.tokenizerIndex, &expression.binOp->rightSide);
-            }
-          }
-          return {&doubleValue, false};
-        } else {
-          if (leftSide.type->token.type == TokenType::BAD_VALUE) {
-            return {&badValue, false};
-          }
-          return checkMemberAccess(tk, leftSide, expression);
-        }
-      }
-      
-      // pointer member access
-      if (expression.binOp->op.type == TokenType::PTR_MEMBER_ACCESS) {
-        if (leftSide.type->token.type == TokenType::BAD_VALUE) {
-          return {&badValue, false};
-        }
-        if (leftSide.type->token.type != TokenType::POINTER) {
-          errors.emplace_back(CheckerErrorType::CANNOT_DEREFERENCE_NON_POINTER_TYPE, tk.tokenizerIndex, expression.binOp->op);
-          return {&badValue, false};
-        }
-        leftSide.type = leftSide.type->next;
-        return checkMemberAccess(tk, leftSide, expression);
-      }
+/**
+ * What was found out about an expression when it was checked: its type, whether it is an lvalue, and the
+ * declaration it refers to if it is an identifier, function call or member access.
+ * Array accesses and array or struct literals are annotated with badType, since they have no type yet.
+ * Their offsets and values are annotated as usual.
+ * Expressions in function template bodies are annotated per instance, in TemplateInstance::expressions
+ * \returns nullptr if the expression was not checked
+*/
+const ExpressionInfo *Checker::annotation(const Expression& expression) const {
+  if (!expression.annotation || expression.annotation >= expressionTypes.size()) {
+    return nullptr;
+  }
+  return &expressionTypes[expression.annotation];
+}
 
-      ResultingType rightSide = checkExpression(tk, expression.binOp->rightSide);
-      if (isAssignment(expression.binOp->op.type)) {
-        if (leftSide.type->token.type == TokenType::BAD_VALUE || rightSide.type->token.type == TokenType::BAD_VALUE) {
-          return {&badValue, false};
-        }
-        if (!leftSide.isLValue) {
-          errors.emplace_back(CheckerErrorType::CANNOT_ASSIGN_TO_TEMPORARY, tk.tokenizerIndex, &expression.binOp->leftSide);
-        }
-        else if (!checkAssignment(*leftSide.type, *rightSide.type)) {
-          errors.emplace_back(CheckerErrorType::CANNOT_ASSIGN, tk.tokenizerIndex, &expression);
-        }
-        return {leftSide.type, true};
-      }
+/**
+ * Checks a binary operator and the chain of binary operators on its left side.
+ * Operators of the same precedence lean left, so a flat expression such as a + b + c ... is a chain as long as
+ * it is. The chain is walked in a loop instead of recursing once per operator, and is not limited by the parser
+*/
+ResultingType Checker::checkOperatorChain(Expression& expression) {
+  const size_t start = operatorChain.size();
+  Expression *leftmost = &expression;
+  while (leftmost->type == ExpressionType::BINARY_OP) {
+    operatorChain.push_back(leftmost);
+    leftmost = &leftmost->binOp->leftSide;
+  }
+  ResultingType result = checkExpression(*leftmost);
+  while (operatorChain.size() > start) {
+    Expression& operation = *operatorChain.back();
+    operatorChain.pop_back();
+    result = checkBinaryOp(operation, result);
+    annotate(operation, result);
+  }
+  return result;
+}
 
-      if (leftSide.type->token.type == TokenType::BAD_VALUE && rightSide.type->token.type == TokenType::BAD_VALUE) {
-        return {&badValue, false};
-      } else if (leftSide.type->token.type == TokenType::BAD_VALUE) {
-        return {rightSide.type, false};
-      } else if (rightSide.type->token.type == TokenType::BAD_VALUE) {
-        return {leftSide.type, false};
+/**
+ * Checks a binary operator whose left side is already checked
+ * \param leftSide the result of checking the left side
+*/
+ResultingType Checker::checkBinaryOp(Expression& expression, ResultingType leftSide) {
+  if (expression.binOp->op.type == TokenType::LOGICAL_AND || expression.binOp->op.type == TokenType::LOGICAL_OR) {
+    if (leftSide.type != TypeTable::badType) {
+      if (!types.canBeConvertedToBool(leftSide.type)) {
+        errors.emplace_back(CheckerErrorType::CANNOT_BE_CONVERTED_TO_BOOL, &expression.binOp->leftSide);
       }
+    }
+    ResultingType rightSide = checkExpression(expression.binOp->rightSide);
+    if (!types.canBeConvertedToBool(rightSide.type)) {
+      errors.emplace_back(CheckerErrorType::CANNOT_BE_CONVERTED_TO_BOOL, &expression.binOp->rightSide);
+    }
+    return {TypeTable::boolType, false};
+  }
+  
+  if (isLogicalOp(expression.binOp->op.type)) {
+    if (types[leftSide.type].kind == TokenType::IDENTIFIER || leftSide.type == TypeTable::voidType) {
+      errors.emplace_back(CheckerErrorType::CANNOT_COMPARE_TYPE, &expression.binOp->leftSide);
+    }
+    ResultingType rightSide = checkExpression(expression.binOp->rightSide);
+    if (types[rightSide.type].kind == TokenType::IDENTIFIER || rightSide.type == TypeTable::voidType) {
+      errors.emplace_back(CheckerErrorType::CANNOT_COMPARE_TYPE, &expression.binOp->rightSide);
+    }
+    return {TypeTable::boolType, false};
+  }
 
-      if (leftSide.type->token.type == TokenType::IDENTIFIER || rightSide.type->token.type == TokenType::IDENTIFIER) {
-        errors.emplace_back(CheckerErrorType::OPERATION_NOT_DEFINED, tk.tokenizerIndex, &expression);
-        return {&badValue, false};
+  // member access or number with decimal
+  if (expression.binOp->op.type == TokenType::DOT) {
+    TokenType tkType = types[leftSide.type].kind;
+    if (tkType == TokenType::DECIMAL_NUMBER || tkType == TokenType::HEX_NUMBER || tkType == TokenType::BINARY_NUMBER) {
+      if (expression.binOp->rightSide.type != ExpressionType::VALUE) {
+        errors.emplace_back(CheckerErrorType::EXPECTING_NUMBER, &expression.binOp->rightSide);
       }
-      if (leftSide.type->token.type == TokenType::VOID || rightSide.type->token.type == TokenType::VOID) {
-        errors.emplace_back(CheckerErrorType::OPERATION_ON_VOID, tk.tokenizerIndex, &expression);
-        return {&badValue, false};
+      else {
+        tkType = expression.binOp->rightSide.value.type;
+        if (tkType != TokenType::DECIMAL_NUMBER && tkType != TokenType::HEX_NUMBER && tkType != TokenType::BINARY_NUMBER) {
+          errors.emplace_back(CheckerErrorType::EXPECTING_NUMBER, &expression.binOp->rightSide);
+        }
       }
-      TokenList& largest = largestType(*leftSide.type, *rightSide.type);
-      if (largest.token.type < TokenType::INT32_TYPE) {
-        return {&int32Value, false};
+      return {TypeTable::doubleType, false};
+    } else {
+      if (leftSide.type == TypeTable::badType) {
+        return {TypeTable::badType, false};
       }
-      return {&largest, false};
+      return checkMemberAccess(leftSide, expression);
+    }
+  }
+  
+  // pointer member access
+  if (expression.binOp->op.type == TokenType::PTR_MEMBER_ACCESS) {
+    if (leftSide.type == TypeTable::badType) {
+      return {TypeTable::badType, false};
+    }
+    if (types[leftSide.type].kind != TokenType::POINTER) {
+      errors.emplace_back(CheckerErrorType::CANNOT_DEREFERENCE_NON_POINTER_TYPE, expression.binOp->op);
+      return {TypeTable::badType, false};
+    }
+    leftSide.type = types[leftSide.type].next;
+    return checkMemberAccess(leftSide, expression);
+  }
+
+  ResultingType rightSide = checkExpression(expression.binOp->rightSide);
+  if (isAssignment(expression.binOp->op.type)) {
+    if (leftSide.type == TypeTable::badType || rightSide.type == TypeTable::badType) {
+      return {TypeTable::badType, false};
+    }
+    if (!leftSide.isLValue) {
+      errors.emplace_back(CheckerErrorType::CANNOT_ASSIGN_TO_TEMPORARY, &expression.binOp->leftSide);
+    }
+    else if (!types.checkAssignment(leftSide.type, rightSide.type)) {
+      errors.emplace_back(CheckerErrorType::CANNOT_ASSIGN, &expression);
+    }
+    return {leftSide.type, true};
+  }
+
+  if (leftSide.type == TypeTable::badType && rightSide.type == TypeTable::badType) {
+    return {TypeTable::badType, false};
+  } else if (leftSide.type == TypeTable::badType) {
+    return {rightSide.type, false};
+  } else if (rightSide.type == TypeTable::badType) {
+    return {leftSide.type, false};
+  }
+
+  if (types[leftSide.type].kind == TokenType::IDENTIFIER || types[rightSide.type].kind == TokenType::IDENTIFIER) {
+    errors.emplace_back(CheckerErrorType::OPERATION_NOT_DEFINED, &expression);
+    return {TypeTable::badType, false};
+  }
+  if (leftSide.type == TypeTable::voidType || rightSide.type == TypeTable::voidType) {
+    errors.emplace_back(CheckerErrorType::OPERATION_ON_VOID, &expression);
+    return {TypeTable::badType, false};
+  }
+  const TypeId largest = types.largest(leftSide.type, rightSide.type);
+  if (types[largest].kind < TokenType::INT32_TYPE) {
+    return {TypeTable::int32Type, false};
+  }
+  return {largest, false};
+}
+
+ResultingType Checker::resolveExpression(Expression& expression, MemberTable* structMap) {
+  switch(expression.type) {
+    case ExpressionType::BINARY_OP: {
+      return checkBinaryOp(expression, checkExpression(expression.binOp->leftSide));
     }
     
     case ExpressionType::UNARY_OP: {
       if (expression.unOp->op.type == TokenType::DEREFERENCE) {
-        ResultingType res = checkExpression(tk, expression.unOp->operand);
-        if (res.type->token.type != TokenType::POINTER) {
-          errors.emplace_back(CheckerErrorType::CANNOT_DEREFERENCE_NON_POINTER_TYPE, tk.tokenizerIndex, expression.unOp->op);
-          return {&badValue, false};
+        ResultingType res = checkExpression(expression.unOp->operand);
+        if (types[res.type].kind != TokenType::POINTER) {
+          errors.emplace_back(CheckerErrorType::CANNOT_DEREFERENCE_NON_POINTER_TYPE, expression.unOp->op);
+          return {TypeTable::badType, false};
         }
-        return {res.type->next, true};
+        return {types[res.type].next, true};
       }
       if (expression.unOp->op.type == TokenType::NOT) {
-        ResultingType res = checkExpression(tk, expression.unOp->operand);
-        if (!canBeConvertedToBool(*res.type)) {
-          errors.emplace_back(CheckerErrorType::CANNOT_BE_CONVERTED_TO_BOOL, tk.tokenizerIndex, expression.unOp->op);
+        ResultingType res = checkExpression(expression.unOp->operand);
+        if (!types.canBeConvertedToBool(res.type)) {
+          errors.emplace_back(CheckerErrorType::CANNOT_BE_CONVERTED_TO_BOOL, expression.unOp->op);
         }
-        return {&boolValue, false};
+        return {TypeTable::boolType, false};
       }
       if (expression.unOp->op.type == TokenType::ADDRESS_OF || expression.unOp->op.type == TokenType::INCREMENT_POSTFIX || expression.unOp->op.type == TokenType::INCREMENT_PREFIX || expression.unOp->op.type == TokenType::DECREMENT_PREFIX || expression.unOp->op.type == TokenType::DECREMENT_POSTFIX) {
-        ResultingType res = checkExpression(tk, expression.unOp->operand);
+        ResultingType res = checkExpression(expression.unOp->operand);
         if (!res.isLValue) {
-          errors.emplace_back(CheckerErrorType::CANNOT_OPERATE_ON_TEMPORARY, tk.tokenizerIndex, expression.unOp->op);
+          errors.emplace_back(CheckerErrorType::CANNOT_OPERATE_ON_TEMPORARY, expression.unOp->op);
         }
         if (expression.unOp->op.type == TokenType::ADDRESS_OF) {
-          TokenList *ptrToType = memPool.makeTokenList();
-          ptrToType->token.type = TokenType::POINTER;
-          ptrToType->next = res.type;
-          return {ptrToType, false};
+          return {types.pointerTo(res.type), false};
         }
         return {res.type, false};
       }
       if (expression.unOp->op.type == TokenType::NEGATIVE) {
         // nothing for now
-        return {checkExpression(tk, expression.unOp->operand).type, false};
+        return {checkExpression(expression.unOp->operand).type, false};
       }
-      return {&badValue, false};
+      return {TypeTable::badType, false};
     }
     
     case ExpressionType::VALUE: {
       if (expression.value.type == TokenType::IDENTIFIER) {
         GeneralDec *decPtr;
+        TypeId typeId;
         if (structMap) {
-          StructDecList *structDec = (*structMap)[tk.extractToken(expression.value)];
-          if (!structDec) {
-            errors.emplace_back(CheckerErrorType::NO_SUCH_MEMBER_VARIABLE, tk.tokenizerIndex, expression.value);
-            return {&badValue, false};
+          StructMember **member = structMap->find(tokenText(expression.value));
+          if (!member) {
+            errors.emplace_back(CheckerErrorType::NO_SUCH_MEMBER_VARIABLE, expression.value);
+            return {TypeTable::badType, false};
           }
+          StructMember *structDec = *member;
           if (structDec->type != StructDecType::VAR) {
-            errors.emplace_back(CheckerErrorType::NOT_A_VARIABLE, tk.tokenizerIndex, expression.value);
-            return {&badValue, false};
+            errors.emplace_back(CheckerErrorType::NOT_A_VARIABLE, expression.value);
+            return {TypeTable::badType, false};
           }
           decPtr = memPool.makeGeneralDec();
           decPtr->type = GeneralDecType::VARIABLE;
           decPtr->varDec = structDec->varDec;
+          typeId = memberInstance ? memberInstance->typeOf(decPtr->varDec->type) : decPtr->varDec->typeId;
         } else {
-          decPtr = lookUp[tk.extractToken(expression.value)];
+          decPtr = findSymbol(tokenText(expression.value));
           if (!decPtr) {
-            errors.emplace_back(CheckerErrorType::NO_SUCH_VARIABLE, tk.tokenizerIndex, expression.value);
-            return {&badValue, false};
+            errors.emplace_back(CheckerErrorType::NO_SUCH_VARIABLE, expression.value);
+            return {TypeTable::badType, false};
           }
           if (decPtr->type != GeneralDecType::VARIABLE) {
-            errors.emplace_back(CheckerErrorType::NOT_A_VARIABLE, tk.tokenizerIndex, expression.value, decPtr);
-            return {&badValue, false};
+            errors.emplace_back(CheckerErrorType::NOT_A_VARIABLE, expression.value, decPtr);
+            return {TypeTable::badType, false};
           }
+          typeId = declaredType(decPtr->varDec->type, decPtr->varDec->typeId);
         }
-        if (decPtr->varDec->type.token.type == TokenType::REFERENCE) {
-          return {decPtr->varDec->type.next, true};
+        if (types[typeId].kind == TokenType::REFERENCE) {
+          return {types[typeId].next, true, decPtr};
         }
-        return {&decPtr->varDec->type, true};
+        return {typeId, true, decPtr};
       }
       if (expression.value.type == TokenType::DECIMAL_NUMBER) {
         // need to get the actual number and see if it fits in a 32bit int, if not, unsigned, if not, 64bit
         // for now, just dump all numbers as ints
-        return {&int32Value, false};
+        return {TypeTable::int32Type, false};
       }
       if (expression.value.type == TokenType::NULL_PTR) {
-        return {&nullptrValue, false};
+        return {TypeTable::nullptrType, false};
       }
       if (expression.value.type == TokenType::FALSE || expression.value.type == TokenType::TRUE) {
-        return {&boolValue, false};
+        return {TypeTable::boolType, false};
       }
       if (expression.value.type == TokenType::STRING_LITERAL) {
-        return {&stringValue, false};
+        return {TypeTable::stringType, false};
       }
-      return {&charValue, false};
+      return {TypeTable::charType, false};
     }
     
     case ExpressionType::FUNCTION_CALL: {
       GeneralDec *decPtr;
+      FunctionDec *funcDec;
+      // types of the declaration are substituted when calling a member of a template struct or a function template
+      TemplateInstance *instance = nullptr;
       // member function
       if (structMap) {
-        StructDecList *structDec = (*structMap)[tk.extractToken(expression.funcCall->name)];
-        if (!structDec) {
-          errors.emplace_back(CheckerErrorType::NO_SUCH_MEMBER_FUNCTION, tk.tokenizerIndex, expression.funcCall->name);
-          return {&badValue, false};
+        instance = memberInstance;
+        StructMember **member = structMap->find(tokenText(expression.funcCall->name));
+        if (!member) {
+          errors.emplace_back(CheckerErrorType::NO_SUCH_MEMBER_FUNCTION, expression.funcCall->name);
+          return {TypeTable::badType, false};
         }
+        StructMember *structDec = *member;
         if (structDec->type != StructDecType::FUNC) {
-          errors.emplace_back(CheckerErrorType::NOT_A_FUNCTION, tk.tokenizerIndex, expression.funcCall->name);
-          return {&badValue, false};
+          errors.emplace_back(CheckerErrorType::NOT_A_FUNCTION, expression.funcCall->name);
+          return {TypeTable::badType, false};
         }
         decPtr = memPool.makeGeneralDec();
         decPtr->type = GeneralDecType::FUNCTION;
         decPtr->funcDec = structDec->funcDec;
+        funcDec = structDec->funcDec;
       }
       // normal function call
       else {
-        decPtr = lookUp[tk.extractToken(expression.funcCall->name)];
+        decPtr = findSymbol(tokenText(expression.funcCall->name));
         if (!decPtr) {
           // dec does not exist
-          errors.emplace_back(CheckerErrorType::NO_SUCH_FUNCTION, tk.tokenizerIndex, expression.funcCall->name);
-          return {&badValue, false};
+          errors.emplace_back(CheckerErrorType::NO_SUCH_FUNCTION, expression.funcCall->name);
+          return {TypeTable::badType, false};
         }
-        if (decPtr->type != GeneralDecType::FUNCTION) {
+        if (decPtr->type == GeneralDecType::TEMPLATE_CREATE) {
+          const uint32_t index = instantiate(*decPtr);
+          if (index == noInstance) {
+            return {TypeTable::badType, false};
+          }
+          instance = &instances[index];
+          if (instance->templateDec->tempDec->isStruct) {
+            errors.emplace_back(CheckerErrorType::NOT_A_FUNCTION, expression.funcCall->name, decPtr);
+            return {TypeTable::badType, false};
+          }
+          funcDec = &instance->templateDec->tempDec->funcDec;
+        } else if (decPtr->type != GeneralDecType::FUNCTION) {
           // not a function
-          errors.emplace_back(CheckerErrorType::NOT_A_FUNCTION, tk.tokenizerIndex, expression.funcCall->name, decPtr);
-          return {&badValue, false};
+          errors.emplace_back(CheckerErrorType::NOT_A_FUNCTION, expression.funcCall->name, decPtr);
+          return {TypeTable::badType, false};
+        } else {
+          funcDec = decPtr->funcDec;
         }
       }
       // valid function, now check parameters
       // parameters are already validated on second top level scan. so assume the statements are all varDecs and valid
-      StatementList* paramList = &decPtr->funcDec->params;
-      ExpressionList* argList = &expression.funcCall->args;
-      do {
-        ResultingType resultingType = checkExpression(tk, argList->curr);
-        if (resultingType.type->token.type != TokenType::BAD_VALUE) {
-          if (!paramList->curr.varDec) {
-            if (resultingType.type->token.type != TokenType::VOID) {
-              errors.emplace_back(CheckerErrorType::WRONG_NUMBER_OF_ARGS, tk.tokenizerIndex, expression.funcCall->name, decPtr);
-            }
-          }
-          else if (argList->curr.type == ExpressionType::NONE) {
-            argList = nullptr;
-            break;
-          }
-          else if (!checkAssignment(paramList->curr.varDec->type, *resultingType.type)) {
-            // types dont match
-            errors.emplace_back(CheckerErrorType::TYPE_DOES_NOT_MATCH, tk.tokenizerIndex, &argList->curr, decPtr);
-          }
+      StatementList& params = funcDec->params;
+      ExpressionList& args = expression.funcCall->args;
+      if (args.size() != params.size()) {
+        errors.emplace_back(CheckerErrorType::WRONG_NUMBER_OF_ARGS, expression.funcCall->name, decPtr);
+      }
+      for (uint32_t i = 0; i < args.size(); ++i) {
+        ResultingType resultingType = checkExpression(args[i]);
+        if (i >= params.size() || resultingType.type == TypeTable::badType) {
+          continue;
+        }
+        const TypeId paramType = instance ? instance->typeOf(params[i].varDec->type) : params[i].varDec->typeId;
+        if (!types.checkAssignment(paramType, resultingType.type)) {
+          // types dont match
+          errors.emplace_back(CheckerErrorType::TYPE_DOES_NOT_MATCH, &args[i], decPtr);
         }
-        // type matches
-        paramList = paramList->next;
-        argList = argList->next;
-      } while (argList && paramList);
-      if (argList || paramList) {
-        errors.emplace_back(CheckerErrorType::WRONG_NUMBER_OF_ARGS, tk.tokenizerIndex, expression.funcCall->name, decPtr);
       }
-      if (decPtr->funcDec->returnType.token.type == TokenType::REFERENCE) {
-        return {decPtr->funcDec->returnType.next, true};
+      const TypeId returnType = instance ? instance->typeOf(funcDec->returnType) : funcDec->returnTypeId;
+      if (types[returnType].kind == TokenType::REFERENCE) {
+        return {types[returnType].next, true, decPtr};
       }
-      return {&decPtr->funcDec->returnType, false};
+      return {returnType, false, decPtr};
     }
     
     case ExpressionType::ARRAY_ACCESS: {
-      return {&badValue, false};
+      // arrays have no type yet, only the offset is checked
+      checkExpression(expression.arrAccess->offset);
+      return {TypeTable::badType, false};
     }
     
     case ExpressionType::WRAPPED: {
-      return checkExpression(tk, *expression.wrapped);
+      return checkExpression(*expression.wrapped);
     }
     
     case ExpressionType::ARRAY_OR_STRUCT_LITERAL: {
-      return {&badValue, false};
+      // the literal itself has no type yet, only its values are checked
+      for (Expression& value : expression.arrayOrStruct->values) {
+        checkExpression(value);
+      }
+      return {TypeTable::badType, false};
     }
 
     case ExpressionType::NONE: {
-      return {&noneValue, false};
+      return {TypeTable::noneType, false};
     }
     
     default: {
@@ -888,13 +1254,13 @@ ResultingType Checker::checkExpression(Tokenizer& tk, Expression& expression, st
 }
 
 /**
- * Validates a type
+ * Validates a type and interns it
  * \param type the type to check
- * \returns true if the type is a valid type, false otherwise (adds the error to errors)
+ * \returns the id of the type if it is a valid type, TypeTable::badType otherwise (adds the error to errors)
  * \note in the case of the type being just 'void', will return false even though it is valid for function return types.
  *  check if the emplaced error is 'void' and remove it if called for a function return type
 */
-bool Checker::checkType(Tokenizer& tk, TokenList& type) {
+TypeId Checker::checkType(TokenList& type) {
   /**
    * Used to track the type info. 0 means we can have a ref, 0-2 means pointer, and 3 means an actual type was found
    * Can go forward, but cant go back. 
@@ -917,6 +1283,9 @@ bool Checker::checkType(Tokenizer& tk, TokenList& type) {
    * 
   */
   uint8_t typeType = 0;
+  uint32_t pointerDepth = 0;
+  // a bare 'ptr' is a void pointer
+  TypeId typeId = TypeTable::voidType;
 
   CheckerErrorType errorType = CheckerErrorType::NONE;
   TokenList *list = &type;
@@ -929,6 +1298,7 @@ bool Checker::checkType(Tokenizer& tk, TokenList& type) {
           break;
         }
         typeType = 2;
+        ++pointerDepth;
       }
       else {
         if (typeType == 3) {
@@ -936,6 +1306,7 @@ bool Checker::checkType(Tokenizer& tk, TokenList& type) {
           break;
         }
         typeType = 3;
+        typeId = builtinType(tokenType);
       }
     }
     else if (list->token.type == TokenType::REFERENCE) {
@@ -956,101 +1327,98 @@ bool Checker::checkType(Tokenizer& tk, TokenList& type) {
         errorType = CheckerErrorType::CANNOT_HAVE_MULTI_TYPE;
         break;
       }
-      GeneralDec* &typeDec = lookUp[tk.extractToken(list->token)];
-      if (!typeDec) {
-        errorType = CheckerErrorType::NO_SUCH_TYPE;
-        break;
+      const std::string_view typeName = tokenText(list->token);
+      TypeId namedType = TypeTable::badType;
+      // template parameters of the instance being checked
+      for (auto& argument : typeArguments) {
+        if (argument.first == typeName) {
+          namedType = argument.second;
+          break;
+        }
       }
-      if (typeDec->type != GeneralDecType::STRUCT) {
-        errors.emplace_back(CheckerErrorType::EXPECTING_TYPE, tk.tokenizerIndex, list->token, typeDec);
-        return false;
+      if (namedType == TypeTable::badType) {
+        GeneralDec *typeDec = findSymbol(typeName);
+        if (!typeDec) {
+          errorType = CheckerErrorType::NO_SUCH_TYPE;
+          break;
+        }
+        if (typeDec->type == GeneralDecType::STRUCT) {
+          namedType = types.structType(typeDec);
+        } else if (typeDec->type == GeneralDecType::TEMPLATE_CREATE) {
+          const uint32_t index = instantiate(*typeDec);
+          if (index == noInstance) {
+            return TypeTable::badType;
+          }
+          namedType = instances[index].type;
+        }
+        if (namedType == TypeTable::badType) {
+          errors.emplace_back(CheckerErrorType::EXPECTING_TYPE, list->token, typeDec);
+          return TypeTable::badType;
+        }
       }
       if (list->next) {
         errorType = CheckerErrorType::CANNOT_HAVE_MULTI_TYPE;
         break;
       }
-      list->next = memPool.makeTokenList();
-      list->next->token.type = TokenType::DEC_PTR;
-      list->next->next = (TokenList *)&typeDec;
-      return true;
+      typeType = 3;
+      typeId = namedType;
     }
     list = list->next;
   } while (list);
-  if (errorType == CheckerErrorType::NONE) {
-    return true;
+  if (errorType != CheckerErrorType::NONE) {
+    errors.emplace_back(errorType, list->token);
+    return TypeTable::badType;
+  }
+  for (; pointerDepth; --pointerDepth) {
+    typeId = types.pointerTo(typeId);
   }
-  errors.emplace_back(errorType, tk.tokenizerIndex, list->token);
-  return false;
+  if (type.token.type == TokenType::REFERENCE) {
+    typeId = types.referenceTo(typeId);
+  }
+  return typeId;
 }
 
-ResultingType Checker::checkMemberAccess(Tokenizer& tk, ResultingType& leftSide, Expression& expression) {
+ResultingType Checker::checkMemberAccess(ResultingType& leftSide, Expression& expression) {
   if (expression.binOp->rightSide.type == ExpressionType::VALUE) {
     if (expression.binOp->rightSide.value.type != TokenType::IDENTIFIER) {
-      errors.emplace_back(CheckerErrorType::EXPECTED_IDENTIFIER, tk.tokenizerIndex, expression.binOp->rightSide.value);
-      return {&badValue, false};
+      errors.emplace_back(CheckerErrorType::EXPECTED_IDENTIFIER, expression.binOp->rightSide.value);
+      return {TypeTable::badType, false};
     }
   }
   else if (expression.binOp->rightSide.type != ExpressionType::FUNCTION_CALL && expression.binOp->rightSide.type != ExpressionType::ARRAY_ACCESS) {
-    errors.emplace_back(CheckerErrorType::EXPECTED_IDENTIFIER, tk.tokenizerIndex, expression.binOp->rightSide.value);
-    return {&badValue, false};
+    errors.emplace_back(CheckerErrorType::EXPECTED_IDENTIFIER, expression.binOp->rightSide.value);
+    return {TypeTable::badType, false};
   }
-  auto dec = lookUp[tk.extractToken(leftSide.type->token)];
-  if (!dec || dec->type != GeneralDecType::STRUCT)  {
-    errors.emplace_back(CheckerErrorType::NOT_A_STRUCT, tk.tokenizerIndex, &expression.binOp->leftSide);
-    return {&badValue, false};
+  const TypeInfo& typeInfo = types[leftSide.type];
+  GeneralDec *dec = typeInfo.dec;
+  StructDec *structDec = nullptr;
+  TemplateInstance *instance = nullptr;
+  if (dec && dec->type == GeneralDecType::STRUCT) {
+    structDec = dec->structDec;
+  } else if (dec && dec->type == GeneralDecType::TEMPLATE && dec->tempDec->isStruct) {
+    structDec = &dec->tempDec->structDec;
+    instance = &instances[typeInfo.instance];
   }
-  auto& structMap = structsLookUp.at(tk.extractToken(leftSide.type->token));
-  return checkExpression(tk, expression.binOp->rightSide, &structMap);
-}
-
-bool checkAssignment(const TokenList& leftSide, const TokenList& rightSide) {
-  if (leftSide.token.type == TokenType::VOID || rightSide.token.type == TokenType::VOID
-    || leftSide.token.type == TokenType::BAD_VALUE || rightSide.token.type == TokenType::BAD_VALUE) {
-    return false;
+  if (!structDec)  {
+    errors.emplace_back(CheckerErrorType::NOT_A_STRUCT, &expression.binOp->leftSide);
+    return {TypeTable::badType, false};
   }
-  if (leftSide.token.type == TokenType::POINTER) {
-    if (rightSide.token.type != TokenType::POINTER) {
-      return rightSide.token.type == TokenType::NULL_PTR;
-    }
-    const TokenList* rType = &rightSide;
-    const TokenList* lType = &leftSide;
-    do {
-      if (rType->token.type != lType->token.type) {
-        if (rType->token.type == TokenType::VOID || lType->token.type == TokenType::VOID) {
-          return true;
-        }
-        return false;
-      }
-      if (rType->token.type == TokenType::DEC_PTR) {
-        return rType->next == lType->next;
-      }
-      rType = rType->next;
-      lType = lType->next;
-    } while (rType && lType);
-  }
-  else if (leftSide.token.type == TokenType::IDENTIFIER || rightSide.token.type == TokenType::IDENTIFIER) {
-    if (leftSide.token.type != TokenType::IDENTIFIER || rightSide.token.type != TokenType::IDENTIFIER) {
-      return false;
-    }
-    if (leftSide.next->token.type == TokenType::DEC_PTR || rightSide.next->token.type == TokenType::DEC_PTR) {
-      return leftSide.next->next == rightSide.next->next;
-    }
-    return false;
-  }
-  return true;
+  MemberTable& structMap = **structsLookUp.find(tokenText(structDec->name));
+  TemplateInstance *outerInstance = memberInstance;
+  memberInstance = instance;
+  ResultingType member = checkExpression(expression.binOp->rightSide, &structMap);
+  memberInstance = outerInstance;
+  return member;
 }
 
-// only builtin types can be converted to bool, except for void.
-bool canBeConvertedToBool(TokenList& type) {
-  return isBuiltInType(type.token.type) && type.token.type != TokenType::VOID;
+std::string Checker::extractToken(const Token& token) {
+  return tokenizerAt(tokenizers, token.position).extractToken(token);
 }
 
-TokenList& Checker::largestType(TokenList& typeA, TokenList& typeB) {
-  if (typeA.token.type == TokenType::POINTER || typeB.token.type == TokenType::POINTER) {
-    return ptrValue;
-  }
-  if (typeA.token.type > typeB.token.type) {
-    return typeA;
-  }
-  return typeB;
+/**
+ * Text of a token without copying it, valid until another file is loaded
+*/
+std::string_view Checker::tokenText(const Token& token) {
+  const Tokenizer& tk = tokenizerAt(tokenizers, token.position);
+  return std::string_view{tk.content}.substr(token.position - tk.baseLocation, token.length);
 }
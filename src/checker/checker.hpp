@@ -2,7 +2,12 @@
 
 #include "../nodes.hpp"
 #include "../nodeMemPool.hpp"
+#include "typeTable.hpp"
+#include "symbolTable.hpp"
+#include <atomic>
+#include <deque>
 #include <map>
+#include <memory>
 
 enum class CheckerErrorType: uint8_t {
   NONE,
@@ -57,60 +62,154 @@ enum class CheckerErrorType: uint8_t {
 struct CheckerError {
   Token token{0,0,TokenType::NOTHING};
   GeneralDec *dec;
-  uint32_t tkIndex;
   CheckerErrorType type;
   CheckerError() = delete;
-  CheckerError(CheckerErrorType, uint32_t, Token );
-  CheckerError(CheckerErrorType, uint32_t, Token, GeneralDec*);
-  CheckerError(CheckerErrorType, uint32_t, Expression*);
-  CheckerError(CheckerErrorType, uint32_t, Expression*, GeneralDec*);
+  CheckerError(CheckerErrorType, Token );
+  CheckerError(CheckerErrorType, Token, GeneralDec*);
+  CheckerError(CheckerErrorType, Expression*);
+  CheckerError(CheckerErrorType, Expression*, GeneralDec*);
   std::string getErrorMessage(std::vector<Tokenizer>&);
 };
 
 struct ResultingType {
-  TokenList *type{nullptr};
+  TypeId type{TypeTable::badType};
   bool isLValue{false};
-  ResultingType(TokenList*, bool);
+  GeneralDec *dec{nullptr}; // declaration an identifier or function call resolved to
+  ResultingType(TypeId, bool, GeneralDec * = nullptr);
+};
+
+/**
+ * The result of checking an expression, kept after the check so that later stages don't need to check it again
+*/
+struct ExpressionInfo {
+  GeneralDec *dec{nullptr}; // declaration of an identifier, function call or member access
+  TypeId type{TypeTable::badType};
+  bool isLValue{false};
+};
+
+/**
+ * A template created with a list of type arguments.
+ * All instances share the template's AST, only the types that depend on the arguments are stored per instance
+*/
+struct TemplateInstance {
+  GeneralDec *templateDec{nullptr};
+  std::vector<TypeId> arguments;
+  // declared types in the template (parameters, return types, members and locals), with the arguments substituted
+  std::unordered_map<const TokenList *, TypeId> resolved;
+  TypeId type{TypeTable::badType}; // the instance type, for struct templates
+  // the types of expressions in the body of a function template depend on the instance, so they are kept here
+  std::unordered_map<const Expression *, ExpressionInfo> expressions;
+  bool bodyChecked{false};
+  TypeId typeOf(const TokenList&) const;
+};
+
+const uint32_t noInstance = UINT32_MAX;
+
+/**
+ * A parameter or local variable in scope
+*/
+struct LocalSymbol {
+  SymbolKey key;
+  GeneralDec *dec;
+};
+
+// which names a local variable or parameter may reuse
+enum class Shadowing: uint8_t {
+  NONE, // no name in scope
+  GLOBALS, // names of global declarations
+  OUTER_SCOPES, // names of global declarations and of locals in enclosing scopes
+};
+
+using MemberTable = SymbolTable<StructMember *>;
+
+/**
+ * Global declarations, types and template instances of a program.
+ * The top level scans fill them in, after which function bodies only read them, except for the type table
+ * which can be added to from any thread. So the checkers of all threads in fullScan share one set
+*/
+struct CheckerTables {
+  ArrayPool names{1 << 12}; // names in the symbol tables
+  std::deque<MemberTable> memberTables;
+  SymbolTable<MemberTable *> structsLookUp{names};
+  SymbolTable<GeneralDec *> lookUp{names};
+  TypeTable types;
+  std::deque<TemplateInstance> instances;
+  std::map<std::pair<GeneralDec *, std::vector<TypeId>>, uint32_t> instanceCache;
+  std::unordered_map<const GeneralDec *, uint32_t> createdInstances; // create declaration -> instance
+  std::atomic<uint32_t> expressionCount{1}; // annotation indexes handed out, 0 is not an index
 };
 
 struct Checker {
-  std::map<std::string, std::map<std::string, StructDecList *>> structsLookUp;
-  std::map<std::string, GeneralDec *> lookUp;
+  // fullScan checks function bodies on several threads once a program has at least this many functions
+  static constexpr uint32_t minParallelFunctions = 256;
+  // functions a thread claims at a time
+  static constexpr uint32_t functionBatchSize = 32;
+  // annotation indexes a checker takes at a time, so that the checkers of several threads don't share any
+  static constexpr uint32_t annotationBlockSize = 1 << 12;
+
+  std::unique_ptr<CheckerTables> ownTables; // null for the checker of a worker thread
+  ArrayPool& names;
+  std::deque<MemberTable>& memberTables;
+  SymbolTable<MemberTable *>& structsLookUp;
+  SymbolTable<GeneralDec *>& lookUp;
   std::vector<CheckerError> errors;
   Program& program;
   std::vector<Tokenizer>& tokenizers;
   NodeMemPool &memPool;
-  static TokenList noneValue;
-  static TokenList badValue;
-  static TokenList boolValue;
-  static TokenList int32Value;
-  static TokenList uint32Value;
-  static TokenList int64Value;
-  static TokenList uint64Value;
-  static TokenList charValue;
-  static TokenList stringValue;
-  static TokenList floatValue;
-  static TokenList doubleValue;
-  static TokenList ptrValue;
-  static TokenList nullptrValue;
-  static TokenList voidValue;
+  TypeTable& types;
+  std::deque<TemplateInstance>& instances;
+  std::map<std::pair<GeneralDec *, std::vector<TypeId>>, uint32_t>& instanceCache;
+  std::unordered_map<const GeneralDec *, uint32_t>& createdInstances;
+  std::atomic<uint32_t>& expressionCount;
+  // what was found out about each checked expression, at Expression::annotation. Filled in by the main checker only
+  std::vector<ExpressionInfo> expressionTypes;
+  // annotations made by the checker of a worker thread, moved into the main checker's expressionTypes once it is done
+  std::vector<std::pair<uint32_t, ExpressionInfo>> workerAnnotations;
+  uint32_t nextAnnotation{0};
+  uint32_t annotationEnd{0};
+  TemplateInstance *bodyInstance{nullptr}; // instance whose function body is being checked
+  // instance whose declared types are being resolved or read, see declaredType. set while instantiating and while checking a body
+  TemplateInstance *typeInstance{nullptr};
+  std::vector<std::pair<std::string, TypeId>> typeArguments; // substitutions while checking an instance
+  TemplateInstance *memberInstance{nullptr}; // instance whose members are being accessed
+  // locals of the function being checked, innermost scope last. a scope is dropped by truncating to where it started
+  std::vector<LocalSymbol> locals;
+  uint32_t scopeStart{0}; // index in locals where the innermost scope starts
+  std::vector<Expression *> operatorChain; // binary operators waiting for their left side, see checkOperatorChain
+  Shadowing shadowing{Shadowing::NONE};
+  uint32_t threads; // most threads fullScan uses, defaults to the number of cores
 
   Checker(Program&, std::vector<Tokenizer>&, NodeMemPool&);
+  Checker(Checker& shared, NodeMemPool&);
   bool check();
+  bool checkRegistered();
   void firstTopLevelScan();
+  void registerDec(GeneralDec&);
+  void registerStructMembers(StructDec&, MemberTable&);
   void secondTopLevelScan();
   void fullScan();
-  void checkFunction(Tokenizer&, FunctionDec&);
-  bool validateFunctionHeader(Tokenizer&, FunctionDec&);
-  void validateStructTopLevel(Tokenizer&, StructDec&);
+  void parallelFullScan();
+  void checkFunction(FunctionDec&);
+  uint32_t instantiate(GeneralDec&);
+  void checkInstanceBody(TemplateInstance&);
+  void bindTypeArguments(TemplateInstance&);
+  TypeId& declaredTypeSlot(const TokenList&, TypeId&);
+  TypeId declaredType(const TokenList&, TypeId) const;
+  bool validateFunctionHeader(FunctionDec&);
+  void validateStructTopLevel(StructDec&);
   void checkForStructCycles(GeneralDec&, std::vector<StructDec *>&);
-  bool checkScope(Tokenizer&, Scope&, TokenList&, bool, bool);
-  bool checkLocalVarDec(Tokenizer&, VariableDec&, std::vector<std::string>&);
-  ResultingType checkExpression(Tokenizer&, Expression&, std::map<std::string, StructDecList *> *structMap = nullptr);
-  ResultingType checkMemberAccess(Tokenizer&, ResultingType&, Expression&);
-  bool checkType(Tokenizer&, TokenList&);
-  static TokenList& largestType(TokenList&, TokenList&);
+  bool checkScope(Scope&, TypeId, bool, bool);
+  bool checkLocalVarDec(VariableDec&);
+  GeneralDec *findSymbol(const SymbolKey&);
+  GeneralDec *findConflict(const SymbolKey&);
+  ResultingType checkExpression(Expression&, MemberTable *structMap = nullptr);
+  ResultingType resolveExpression(Expression&, MemberTable *structMap);
+  ResultingType checkOperatorChain(Expression&);
+  ResultingType checkBinaryOp(Expression&, ResultingType);
+  void annotate(Expression&, const ResultingType&);
+  const ExpressionInfo *annotation(const Expression&) const;
+  ResultingType checkMemberAccess(ResultingType&, Expression&);
+  TypeId checkType(TokenList&);
+  std::string extractToken(const Token&);
+  std::string_view tokenText(const Token&);
 };
-
-bool canBeConvertedToBool(TokenList&);
-bool checkAssignment(const TokenList&, const TokenList&);
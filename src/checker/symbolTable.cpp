@@ -0,0 +1,27 @@
+#include "symbolTable.hpp"
+#include <cstring>
+
+/**
+ * Hashes 8 bytes at a time, mixing each word in with a multiplication.
+ * The low 7 bits go in the control bytes and the bits above them pick the group, so all of the bits are mixed at the end
+*/
+uint64_t hashName(std::string_view name) {
+  uint64_t hash = 0x9E3779B97F4A7C15ull ^ name.size();
+  size_t i = 0;
+  for (; i + 8 <= name.size(); i += 8) {
+    uint64_t word;
+    memcpy(&word, name.data() + i, 8);
+    hash = (hash ^ word) * 0xBF58476D1CE4E5B9ull;
+    hash ^= hash >> 31;
+  }
+  if (i < name.size()) {
+    uint64_t word = 0;
+    memcpy(&word, name.data() + i, name.size() - i);
+    hash = (hash ^ word) * 0x94D049BB133111EBull;
+    hash ^= hash >> 29;
+  }
+  hash ^= hash >> 32;
+  hash *= 0xD6E8FEB86659FD93ull;
+  hash ^= hash >> 32;
+  return hash;
+}
@@ -0,0 +1,196 @@
+#pragma once
+
+#include "../memPool.hpp"
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+uint64_t hashName(std::string_view);
+
+/**
+ * A name with its hash, so that the hash is computed once per name however many times it is looked up
+*/
+struct SymbolKey {
+  std::string_view name;
+  uint64_t hash;
+  SymbolKey(std::string_view name): name{name}, hash{hashName(name)} {}
+  SymbolKey(const char *name): SymbolKey{std::string_view{name}} {}
+  SymbolKey(const std::string &name): SymbolKey{std::string_view{name}} {}
+};
+
+/**
+ * Open addressing hash table from names to values, laid out like a SwissTable.
+ * Slots are split in groups of 16, each slot has a control byte holding 7 bits of its hash, or marking it empty or deleted.
+ * A probe compares the control bytes of a whole group at once (with SSE2 when available) and only compares the names
+ * of slots whose 7 bits match, stopping at the first group with an empty slot.
+ * Lookups never insert, and names are never copied on lookup. Inserted names are copied into the given pool,
+ * so they outlive the strings they were looked up with.
+ * Pointers to values are invalidated by inserting
+*/
+template<typename V>
+class SymbolTable {
+  static constexpr uint32_t groupSize = 16;
+  static constexpr uint8_t emptyControl = 0x80;
+  static constexpr uint8_t deletedControl = 0xFE;
+
+  struct Slot {
+    std::string_view name;
+    uint64_t hash;
+    V value;
+  };
+
+  std::vector<uint8_t> control; // one byte per slot: emptyControl, deletedControl, or the low 7 bits of the hash
+  std::vector<Slot> slots;
+  uint32_t count{0};
+  uint32_t deleted{0};
+  ArrayPool *names;
+
+  static uint8_t controlOf(uint64_t hash) { return hash & 0x7F; }
+  uint32_t groupMask() const { return slots.size() / groupSize - 1; }
+
+  // bit i is set if control byte i of the group equals c
+  uint32_t match(uint32_t group, uint8_t c) const {
+    const uint8_t *bytes = control.data() + group * groupSize;
+#if defined(__SSE2__)
+    const __m128i ctrl = _mm_loadu_si128((const __m128i *)bytes);
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8((char)c)));
+#else
+    uint32_t mask = 0;
+    for (uint32_t i = 0; i < groupSize; ++i) {
+      mask |= (uint32_t)(bytes[i] == c) << i;
+    }
+    return mask;
+#endif
+  }
+
+  // bit i is set if slot i of the group is empty or deleted. both have the high bit set, full slots do not
+  uint32_t matchFree(uint32_t group) const {
+    const uint8_t *bytes = control.data() + group * groupSize;
+#if defined(__SSE2__)
+    return _mm_movemask_epi8(_mm_loadu_si128((const __m128i *)bytes));
+#else
+    uint32_t mask = 0;
+    for (uint32_t i = 0; i < groupSize; ++i) {
+      mask |= (uint32_t)(bytes[i] >> 7) << i;
+    }
+    return mask;
+#endif
+  }
+
+  // index of the slot holding the key, or UINT32_MAX
+  uint32_t findIndex(const SymbolKey &key) const {
+    if (slots.empty()) {
+      return UINT32_MAX;
+    }
+    const uint32_t mask = groupMask();
+    uint32_t group = (key.hash >> 7) & mask;
+    // triangular probing visits every group once when the number of groups is a power of 2
+    for (uint32_t step = 1;; group = (group + step++) & mask) {
+      for (uint32_t bits = match(group, controlOf(key.hash)); bits; bits &= bits - 1) {
+        const Slot &slot = slots[group * groupSize + __builtin_ctz(bits)];
+        if (slot.hash == key.hash && slot.name == key.name) {
+          return &slot - slots.data();
+        }
+      }
+      if (match(group, emptyControl)) {
+        return UINT32_MAX;
+      }
+    }
+  }
+
+  // first empty or deleted slot on the probe sequence of the hash. there always is one, see insert
+  uint32_t freeIndex(uint64_t hash) const {
+    const uint32_t mask = groupMask();
+    uint32_t group = (hash >> 7) & mask;
+    for (uint32_t step = 1;; group = (group + step++) & mask) {
+      if (const uint32_t bits = matchFree(group)) {
+        return group * groupSize + __builtin_ctz(bits);
+      }
+    }
+  }
+
+  void rehash(size_t slotCount) {
+    std::vector<uint8_t> oldControl;
+    std::vector<Slot> oldSlots;
+    oldControl.swap(control);
+    oldSlots.swap(slots);
+    control.assign(slotCount, emptyControl);
+    slots.resize(slotCount);
+    deleted = 0;
+    for (size_t i = 0; i < oldSlots.size(); ++i) {
+      if (!(oldControl[i] & 0x80)) {
+        const uint32_t index = freeIndex(oldSlots[i].hash);
+        control[index] = oldControl[i];
+        slots[index] = std::move(oldSlots[i]);
+      }
+    }
+  }
+
+public:
+  /**
+   * \param names where inserted names are copied to. It must outlive the table
+  */
+  explicit SymbolTable(ArrayPool &names): names{&names} {}
+
+  uint32_t size() const { return count; }
+
+  V *find(const SymbolKey &key) {
+    const uint32_t index = findIndex(key);
+    return index == UINT32_MAX ? nullptr : &slots[index].value;
+  }
+
+  const V *find(const SymbolKey &key) const {
+    const uint32_t index = findIndex(key);
+    return index == UINT32_MAX ? nullptr : &slots[index].value;
+  }
+
+  /**
+   * Adds the name with the value, unless the name is already in the table
+   * \returns the value of the name, and whether it was added
+  */
+  std::pair<V *, bool> insert(const SymbolKey &key, V value) {
+    const uint32_t existing = findIndex(key);
+    if (existing != UINT32_MAX) {
+      return {&slots[existing].value, false};
+    }
+    // at most 7/8 of the slots are full or deleted, so probes always reach an empty slot
+    if ((count + deleted + 1) * 8 > slots.size() * 7) {
+      // only deleted slots are reclaimed if the table is less than half full
+      rehash(slots.empty() ? groupSize : count * 2 >= slots.size() ? slots.size() * 2 : slots.size());
+    }
+    const uint32_t index = freeIndex(key.hash);
+    if (control[index] == deletedControl) {
+      --deleted;
+    }
+    control[index] = controlOf(key.hash);
+    char *name = key.name.empty() ? nullptr : names->get(key.name.data(), key.name.size());
+    slots[index] = Slot{std::string_view{name, key.name.size()}, key.hash, std::move(value)};
+    ++count;
+    return {&slots[index].value, true};
+  }
+
+  /**
+   * \returns false if the name was not in the table
+  */
+  bool erase(const SymbolKey &key) {
+    const uint32_t index = findIndex(key);
+    if (index == UINT32_MAX) {
+      return false;
+    }
+    // a probe stops at a group with an empty slot, so the slot can only be emptied if its group already has one.
+    // otherwise other names may have been placed past this group
+    if (match(index / groupSize, emptyControl)) {
+      control[index] = emptyControl;
+    } else {
+      control[index] = deletedControl;
+      ++deleted;
+    }
+    slots[index] = Slot{};
+    --count;
+    return true;
+  }
+};
@@ -1,6 +1,7 @@
 #include <catch2/catch_test_macros.hpp>
 #include "checker.hpp"
 #include "../parser/parser.hpp"
+#include <thread>
 
 NodeMemPool mem3;
 
@@ -15,13 +16,14 @@ TEST_CASE("scanTopLevel", "[checker]") {
   Checker tc{pr.program, tks, mem3};
   tc.firstTopLevelScan();
   CHECK(tc.errors.empty());
-  CHECK(tc.lookUp["funcName"]);
-  CHECK(tc.lookUp["var"]);
-  CHECK(tc.lookUp["thing"]);
-  auto &r = tc.structsLookUp["thing"];
+  CHECK(tc.lookUp.find("funcName"));
+  CHECK(tc.lookUp.find("var"));
+  CHECK(tc.lookUp.find("thing"));
+  REQUIRE(tc.structsLookUp.find("thing"));
+  MemberTable &r = **tc.structsLookUp.find("thing");
   CHECK(r.size() == 1);
-  CHECK(r["var"]);
-  CHECK_FALSE(tc.lookUp["other"]);
+  CHECK(r.find("var"));
+  CHECK_FALSE(tc.lookUp.find("other"));
 }
 
 TEST_CASE("checkType", "[checker]") {
@@ -39,22 +41,22 @@ TEST_CASE("checkType", "[checker]") {
     tokenList.token.length = 5;
     tokenList.token.position = 7;
     tokenList.token.type = TokenType::IDENTIFIER;
-    CHECK(tc.checkType(tks.back(),tokenList));
+    CHECK(tc.checkType(tokenList));
     tokenList.next = nullptr;
     TokenList nextType = tokenList;
     tokenList.next = &nextType;
     tokenList.token.type = TokenType::POINTER;
-    CHECK(tc.checkType(tks.back(),tokenList));
+    CHECK(tc.checkType(tokenList));
     nextType.next = nullptr;
     TokenList nextNextType = tokenList;
     tokenList.next = &nextNextType;
     tokenList.token.type = TokenType::REFERENCE;
-    CHECK(tc.checkType(tks.back(),tokenList));
+    CHECK(tc.checkType(tokenList));
     nextType.next = nullptr;
     TokenList nextNextNextType = tokenList;
     tokenList.next = &nextNextNextType;
     tokenList.token.type = TokenType::POINTER;
-    CHECK_FALSE(tc.checkType(tks.back(),tokenList));
+    CHECK_FALSE(tc.checkType(tokenList));
   }
 
   {
@@ -62,7 +64,7 @@ TEST_CASE("checkType", "[checker]") {
     notAType.token.length = 7;
     notAType.token.position = 38;
     notAType.token.type = TokenType::IDENTIFIER;
-    CHECK_FALSE(tc.checkType(tks.back(), notAType));
+    CHECK_FALSE(tc.checkType(notAType));
   }
 }
 
@@ -144,4 +146,537 @@ struct customType {
   tc.secondTopLevelScan();
   tc.fullScan();
   CHECK(tc.errors.empty());
-}
\ No newline at end of file
+}
+
+TEST_CASE("registerDec while parsing", "[checker]") {
+  const std::string str = "func funcName(): int32 { return 0; } var: int32; struct thing { var: int32; } var: char;";
+  std::vector<Tokenizer> tks;
+  tks.emplace_back("./src/checker/test_checker.cpp", str);
+  Parser pr{tks.back(), mem3};
+  Checker tc{pr.program, tks, mem3};
+  uint32_t registered = 0;
+  pr.onGeneralDec = [&tc, &registered](GeneralDec& dec) {
+    tc.registerDec(dec);
+    ++registered;
+  };
+  REQUIRE(pr.parse());
+  CHECK(registered == 4);
+  CHECK(tc.lookUp.find("funcName"));
+  CHECK(tc.lookUp.find("thing"));
+  REQUIRE(tc.structsLookUp.find("thing"));
+  CHECK((*tc.structsLookUp.find("thing"))->size() == 1);
+  REQUIRE(tc.errors.size() == 1);
+  CHECK(tc.errors[0].type == CheckerErrorType::NAME_ALREADY_IN_USE);
+  CHECK_FALSE(tc.checkRegistered());
+}
+
+TEST_CASE("function call argument count", "[checker]") {
+  const std::string str = "func none(): int32 { return 0; } func two(a: int32, b: int32): int32 { return none(); } func main(): int32 { two(1); return two(1, 2); }";
+  std::vector<Tokenizer> tks;
+  tks.emplace_back("./src/checker/test_checker.cpp", str);
+  Parser pr{tks.back(), mem3};
+  REQUIRE(pr.parse());
+  Checker tc{pr.program, tks, mem3};
+  tc.firstTopLevelScan();
+  tc.secondTopLevelScan();
+  tc.fullScan();
+  REQUIRE(tc.errors.size() == 1);
+  CHECK(tc.errors[0].type == CheckerErrorType::WRONG_NUMBER_OF_ARGS);
+}
+
+TEST_CASE("type interning", "[checker]") {
+  const std::string str = "struct node { next: node ptr; } func f(a: node ptr ptr, b: node ptr ptr, c: char ptr, d: ptr): int32 { return 0; }";
+  std::vector<Tokenizer> tks;
+  tks.emplace_back("./src/checker/test_checker.cpp", str);
+  Parser pr{tks.back(), mem3};
+  REQUIRE(pr.parse());
+  Checker tc{pr.program, tks, mem3};
+  tc.firstTopLevelScan();
+  tc.secondTopLevelScan();
+  REQUIRE(tc.errors.empty());
+  StatementList& params = pr.program.decs[1]->funcDec->params;
+  const TypeId a = params[0].varDec->typeId, c = params[2].varDec->typeId, d = params[3].varDec->typeId;
+  CHECK(a == params[1].varDec->typeId);
+  CHECK(c == TypeTable::stringType);
+  CHECK(d == TypeTable::ptrType);
+  CHECK(pr.program.decs[1]->funcDec->returnTypeId == TypeTable::int32Type);
+
+  TypeTable& types = tc.types;
+  REQUIRE(types[a].kind == TokenType::POINTER);
+  const TypeId nodePtr = types[a].next;
+  CHECK(nodePtr == pr.program.decs[0]->structDec->decs[0].varDec->typeId);
+  CHECK(types[types[nodePtr].next].dec == pr.program.decs[0]);
+  CHECK(types[TypeTable::int32Type].isIntegral);
+  CHECK(types[TypeTable::int64Type].width == 8);
+
+  CHECK(types.checkAssignment(a, a));
+  CHECK(types.checkAssignment(a, TypeTable::nullptrType));
+  CHECK(types.checkAssignment(nodePtr, d));
+  CHECK_FALSE(types.checkAssignment(a, c));
+  CHECK_FALSE(types.checkAssignment(a, nodePtr));
+}
+
+TEST_CASE("type table from several threads", "[checker]") {
+  TypeTable types;
+  GeneralDec decs[8];
+  std::vector<TypeId> found[4];
+  std::vector<std::thread> workers;
+  for (std::vector<TypeId>& ids : found) {
+    workers.emplace_back([&types, &decs, &ids]() {
+      for (uint32_t i = 0; i < 1000; ++i) {
+        const TypeId structId = types.structType(&decs[i % 8]);
+        ids.push_back(structId);
+        ids.push_back(types.referenceTo(types.pointerTo(structId)));
+      }
+    });
+  }
+  for (std::thread& worker : workers) {
+    worker.join();
+  }
+  // every thread gets the same id for the same type, whichever one added it
+  for (const std::vector<TypeId>& ids : found) {
+    CHECK(ids == found[0]);
+  }
+  const TypeId reference = found[0][1];
+  REQUIRE(types[reference].kind == TokenType::REFERENCE);
+  CHECK(types[types[reference].next].kind == TokenType::POINTER);
+  CHECK(types[types[types[reference].next].next].dec == &decs[0]);
+  CHECK(types.pointerTo(TypeTable::voidType) == TypeTable::ptrType);
+  CHECK(types.pointerTo(TypeTable::charType) == TypeTable::stringType);
+}
+
+TEST_CASE("template instances", "[checker]") {
+  const std::string str =
+R"(
+template [T] struct Box {
+  item: T;
+  next: T ptr;
+}
+template [T] func identity(value: T): T {
+  copy: T = value;
+  return copy;
+}
+create Box [int32] as IntBox;
+create Box [int32] as SameBox;
+create Box [char] as CharBox;
+create identity [int32] as intIdentity;
+func main(): int32 {
+  a: IntBox;
+  b: SameBox;
+  c: CharBox;
+  a = b;
+  a.item = intIdentity(a.item);
+  letter: char = c.item;
+  p: int32 ptr = a.next;
+  c = a;
+  return a.item;
+}
+)";
+  std::vector<Tokenizer> tks;
+  tks.emplace_back("./src/checker/test_checker.cpp", str);
+  Parser pr{tks.back(), mem3};
+  REQUIRE(pr.parse());
+  Checker tc{pr.program, tks, mem3};
+  tc.firstTopLevelScan();
+  tc.secondTopLevelScan();
+  REQUIRE(tc.errors.empty());
+  // creating the same instance twice reuses it
+  CHECK(tc.instances.size() == 3);
+  CHECK(tc.createdInstances[*tc.lookUp.find("IntBox")] == tc.createdInstances[*tc.lookUp.find("SameBox")]);
+  CHECK(tc.createdInstances[*tc.lookUp.find("IntBox")] != tc.createdInstances[*tc.lookUp.find("CharBox")]);
+  tc.fullScan();
+  REQUIRE(tc.errors.size() == 1);
+  CHECK(tc.errors[0].type == CheckerErrorType::CANNOT_ASSIGN);
+  CHECK(tc.instances[tc.createdInstances[*tc.lookUp.find("intIdentity")]].bodyChecked);
+
+  // the types of the template's declarations are kept per instance, the shared AST is left as it was
+  GeneralDec *identity = *tc.lookUp.find("identity");
+  FunctionDec &funcDec = identity->tempDec->funcDec;
+  VariableDec &param = *funcDec.params[0].varDec;
+  VariableDec &copy = *funcDec.body.scopeStatements[0].varDec;
+  // T, as validated with the template itself
+  CHECK(param.typeId != TypeTable::int32Type);
+  CHECK(funcDec.returnTypeId == param.typeId);
+  CHECK(copy.typeId == 0);
+  const TemplateInstance &ints = tc.instances[tc.createdInstances[*tc.lookUp.find("intIdentity")]];
+  CHECK(ints.typeOf(param.type) == TypeTable::int32Type);
+  CHECK(ints.typeOf(copy.type) == TypeTable::int32Type);
+  CHECK(ints.typeOf(funcDec.returnType) == TypeTable::int32Type);
+}
+
+TEST_CASE("Symbol table", "[checker]") {
+  ArrayPool names;
+  SymbolTable<uint32_t> table{names};
+  std::vector<std::string> keys;
+  for (uint32_t i = 0; i < 5000; ++i) {
+    keys.push_back("name" + std::to_string(i));
+  }
+  uint32_t added = 0;
+  for (uint32_t i = 0; i < keys.size(); ++i) {
+    added += table.insert(keys[i], i).second;
+  }
+  CHECK(added == keys.size());
+  CHECK(table.size() == keys.size());
+  // names are copied, so the table does not depend on the strings it was given
+  for (std::string &key : keys) {
+    key[0] = 'N';
+  }
+  CHECK_FALSE(table.find("Name0"));
+  REQUIRE(table.find("name42"));
+  CHECK(*table.find("name42") == 42);
+  auto [value, inserted] = table.insert("name42", 7);
+  CHECK_FALSE(inserted);
+  CHECK(*value == 42);
+
+  // erase every other name, the rest stay reachable past the deleted slots
+  uint32_t erased = 0;
+  for (uint32_t i = 0; i < 5000; i += 2) {
+    erased += table.erase("name" + std::to_string(i));
+  }
+  CHECK(erased == 2500);
+  CHECK_FALSE(table.erase("name0"));
+  CHECK(table.size() == 2500);
+  uint32_t found = 0;
+  for (uint32_t i = 0; i < 5000; ++i) {
+    const uint32_t *v = table.find("name" + std::to_string(i));
+    found += i % 2 ? v && *v == i : !v;
+  }
+  CHECK(found == 5000);
+  // inserting and erasing over and over, as locals do, leaves the other names alone
+  for (uint32_t cycle = 0; cycle < 10000; ++cycle) {
+    table.insert("scoped", cycle);
+    table.erase("scoped");
+  }
+  CHECK(table.size() == 2500);
+  CHECK(*table.find("name4999") == 4999);
+  CHECK(table.insert("", 1).second);
+  CHECK(*table.find("") == 1);
+}
+
+TEST_CASE("Scope stack", "[checker]") {
+  const std::string str =
+R"(
+g: int32;
+func clash(): int32 {
+  g: int32 = 1;
+  return g;
+}
+func useGlobal(): int32 {
+  return g;
+}
+func nested(x: int32): int32 {
+  if (x < 1) {
+    x: int64 = 2;
+    return 0;
+  }
+  for (i: int32 = 0; i < x; i += 1) {
+    y: int32 = i;
+  }
+  y: int32 = x;
+  return y;
+}
+func sameScope(): int32 {
+  z: int32 = 1;
+  z: int32 = 2;
+  return z;
+}
+func outOfScope(): int32 {
+  return i;
+}
+)";
+  std::vector<std::vector<CheckerErrorType>> results;
+  for (Shadowing shadowing : {Shadowing::NONE, Shadowing::GLOBALS, Shadowing::OUTER_SCOPES}) {
+    std::vector<Tokenizer> tks;
+    tks.emplace_back("./src/checker/test_checker.cpp", str);
+    Parser pr{tks.back(), mem3};
+    REQUIRE(pr.parse());
+    Checker tc{pr.program, tks, mem3};
+    tc.shadowing = shadowing;
+    tc.firstTopLevelScan();
+    tc.secondTopLevelScan();
+    tc.fullScan();
+    CHECK(tc.locals.empty());
+    CHECK(tc.lookUp.find("g"));
+    results.emplace_back();
+    for (const CheckerError &error : tc.errors) {
+      results.back().push_back(error.type);
+    }
+  }
+  // the global survives the clashing local, locals of a scope are gone once it ends,
+  // and a name is never reused within one scope
+  CHECK(results[0] == std::vector<CheckerErrorType>{
+    CheckerErrorType::NAME_ALREADY_IN_USE, CheckerErrorType::NAME_ALREADY_IN_USE,
+    CheckerErrorType::NAME_ALREADY_IN_USE, CheckerErrorType::NO_SUCH_VARIABLE,
+    CheckerErrorType::INCORRECT_RETURN_TYPE
+  });
+  CHECK(results[1] == std::vector<CheckerErrorType>{
+    CheckerErrorType::NAME_ALREADY_IN_USE, CheckerErrorType::NAME_ALREADY_IN_USE, CheckerErrorType::NO_SUCH_VARIABLE,
+    CheckerErrorType::INCORRECT_RETURN_TYPE
+  });
+  CHECK(results[2] == std::vector<CheckerErrorType>{
+    CheckerErrorType::NAME_ALREADY_IN_USE, CheckerErrorType::NO_SUCH_VARIABLE,
+    CheckerErrorType::INCORRECT_RETURN_TYPE
+  });
+}
+
+TEST_CASE("Parallel fullScan", "[checker]") {
+  std::string str =
+R"(
+struct Node { next: Node ptr; }
+template [T] struct Box { item: T; }
+template [T] func bad(value: T): T { return missing; }
+create Box [int32] as IntBox;
+)";
+  const uint32_t functionCount = 1000;
+  for (uint32_t i = 0; i < functionCount; ++i) {
+    const std::string name = "f" + std::to_string(i);
+    str += "func " + name + "(a: int32, s: Node ptr): int32 {\n";
+    // pointer types are added to the shared type table as the bodies are checked
+    str += "  p: int32";
+    for (uint32_t depth = 0; depth <= i % 4; ++depth) {
+      str += " ptr";
+    }
+    str += " = nullptr;\n";
+    str += "  b: IntBox;\n  b.item = a;\n";
+    if (i % 7 == 0) {
+      str += "  missing" + std::to_string(i) + " = 1;\n";
+    }
+    if (i % 11 == 0) {
+      str += "  return b;\n";
+    }
+    str += "  return f" + std::to_string((i + 1) % functionCount) + "(a, s);\n}\n";
+    if (i == functionCount / 2) {
+      str += "create bad [int32] as badInt;\n";
+    }
+  }
+  std::vector<std::vector<std::pair<CheckerErrorType, uint32_t>>> results;
+  std::vector<std::vector<TypeId>> returnTypes;
+  for (uint32_t threads : {1, 4}) {
+    std::vector<Tokenizer> tks;
+    tks.emplace_back("./src/checker/test_checker.cpp", str);
+    Parser pr{tks.back(), mem3};
+    REQUIRE(pr.parse());
+    Checker tc{pr.program, tks, mem3};
+    tc.threads = threads;
+    tc.firstTopLevelScan();
+    tc.secondTopLevelScan();
+    REQUIRE(tc.errors.empty());
+    tc.fullScan();
+    results.emplace_back();
+    for (const CheckerError &error : tc.errors) {
+      results.back().emplace_back(error.type, error.token.position - tks.back().baseLocation);
+    }
+    // types of the last return of every function, read from the annotations
+    returnTypes.emplace_back();
+    for (GeneralDec *dec : pr.program.decs) {
+      if (dec->type == GeneralDecType::FUNCTION) {
+        StatementList &body = dec->funcDec->body.scopeStatements;
+        const ExpressionInfo *info = tc.annotation(body[body.size() - 1].controlFlow->returnStatement->returnValue);
+        returnTypes.back().push_back(info ? info->type : TypeTable::badType);
+      }
+    }
+  }
+  // the errors of each function, in declaration order, whichever thread checked it
+  CHECK(results[0].size() == 143 + 91 + 2);
+  CHECK(results[0] == results[1]);
+  CHECK(returnTypes[0] == std::vector<TypeId>(functionCount, TypeTable::int32Type));
+  CHECK(returnTypes[0] == returnTypes[1]);
+}
+
+TEST_CASE("Parallel fullScan with function templates", "[checker]") {
+  // the instance bodies have locals, whose types are kept in the instance that the workers read when they call it
+  std::string str =
+R"(
+template [T] func twice(value: T): T {
+  copy: T = value;
+  sum: T = copy + value;
+  return sum;
+}
+template [T] func first(values: T ptr): T {
+  item: T = *values;
+  return item;
+}
+create twice [int32] as twiceInt;
+create twice [int64] as twiceLong;
+create first [int32] as firstInt;
+)";
+  const uint32_t functionCount = 1000;
+  for (uint32_t i = 0; i < functionCount; ++i) {
+    str += "func f" + std::to_string(i) + "(a: int32, p: int32 ptr, l: int64): int64 {\n";
+    str += "  b: int32 = twiceInt(a) + firstInt(p);\n";
+    if (i % 9 == 0) {
+      str += "  c: int32 ptr = twiceLong(l);\n";
+    }
+    str += "  return twiceLong(l) + b;\n}\n";
+  }
+  std::vector<std::vector<CheckerErrorType>> results;
+  std::vector<std::vector<TypeId>> returnTypes;
+  for (uint32_t threads : {1, 4}) {
+    std::vector<Tokenizer> tks;
+    tks.emplace_back("./src/checker/test_checker.cpp", str);
+    Parser pr{tks.back(), mem3};
+    REQUIRE(pr.parse());
+    Checker tc{pr.program, tks, mem3};
+    tc.threads = threads;
+    tc.firstTopLevelScan();
+    tc.secondTopLevelScan();
+    REQUIRE(tc.errors.empty());
+    tc.fullScan();
+    results.emplace_back();
+    for (const CheckerError &error : tc.errors) {
+      results.back().push_back(error.type);
+    }
+    returnTypes.emplace_back();
+    for (GeneralDec *dec : pr.program.decs) {
+      if (dec->type == GeneralDecType::FUNCTION) {
+        StatementList &body = dec->funcDec->body.scopeStatements;
+        const ExpressionInfo *info = tc.annotation(body[body.size() - 1].controlFlow->returnStatement->returnValue);
+        returnTypes.back().push_back(info ? info->type : TypeTable::badType);
+      }
+    }
+  }
+  CHECK(results[0] == std::vector<CheckerErrorType>((functionCount + 8) / 9, CheckerErrorType::CANNOT_ASSIGN));
+  CHECK(results[0] == results[1]);
+  CHECK(returnTypes[0] == std::vector<TypeId>(functionCount, TypeTable::int64Type));
+  CHECK(returnTypes[0] == returnTypes[1]);
+}
+
+TEST_CASE("Long operator chains", "[checker]") {
+  // not limited by the parser's nesting depth, and checked without recursing once per operator
+  std::string str = "func f(a: int32, b: int64): int64 {\n  return a";
+  const uint32_t termCount = 200000;
+  for (uint32_t i = 0; i < termCount; ++i) {
+    str += i == termCount / 2 ? " + b" : " + a";
+  }
+  str += ";\n}\n";
+  std::vector<Tokenizer> tks;
+  tks.emplace_back("./src/checker/test_checker.cpp", str);
+  Parser pr{tks.back(), mem3};
+  REQUIRE(pr.parse());
+  Checker tc{pr.program, tks, mem3};
+  CHECK(tc.check());
+  Expression *sum = &pr.program.decs[0]->funcDec->body.scopeStatements[0].controlFlow->returnStatement->returnValue;
+  REQUIRE(tc.annotation(*sum));
+  CHECK(tc.annotation(*sum)->type == TypeTable::int64Type);
+  // the operators before the int64 term are int32
+  for (uint32_t i = 0; i < termCount / 2 + 1; ++i) {
+    sum = &sum->binOp->leftSide;
+  }
+  REQUIRE(tc.annotation(*sum));
+  CHECK(tc.annotation(*sum)->type == TypeTable::int32Type);
+  CHECK(tc.operatorChain.empty());
+}
+
+TEST_CASE("Expression annotations", "[checker]") {
+  const std::string str =
+R"(
+struct Point { x: int32; y: int32; }
+template [T] func identity(value: T): T { return value; }
+create identity [int32] as intIdentity;
+create identity [char] as charIdentity;
+func area(p: Point ptr, scale: int64): int64 {
+  copy: Point = *p;
+  copy.x = intIdentity(copy.y);
+  return area(p, scale) * scale;
+}
+)";
+  std::vector<Tokenizer> tks;
+  tks.emplace_back("./src/checker/test_checker.cpp", str);
+  Parser pr{tks.back(), mem3};
+  REQUIRE(pr.parse());
+  Checker tc{pr.program, tks, mem3};
+  REQUIRE(tc.check());
+  FunctionDec &area = *pr.program.decs[4]->funcDec;
+  StatementList &body = area.body.scopeStatements;
+
+  // copy.x = intIdentity(copy.y)
+  Expression &assignment = *body[1].expression;
+  const ExpressionInfo *info = tc.annotation(assignment);
+  REQUIRE(info);
+  CHECK(info->type == TypeTable::int32Type);
+  const ExpressionInfo *member = tc.annotation(assignment.binOp->leftSide);
+  REQUIRE(member);
+  CHECK(member->type == TypeTable::int32Type);
+  CHECK(member->isLValue);
+  REQUIRE(member->dec);
+  CHECK(member->dec->varDec == pr.program.decs[0]->structDec->decs[0].varDec);
+  const ExpressionInfo *call = tc.annotation(assignment.binOp->rightSide);
+  REQUIRE(call);
+  CHECK(call->dec == *tc.lookUp.find("intIdentity"));
+  CHECK_FALSE(call->isLValue);
+  const ExpressionInfo *variable = tc.annotation(assignment.binOp->leftSide.binOp->leftSide);
+  REQUIRE(variable);
+  CHECK(variable->dec->varDec == body[0].varDec);
+
+  // area(p, scale) * scale
+  Expression &product = body[2].controlFlow->returnStatement->returnValue;
+  REQUIRE(tc.annotation(product));
+  CHECK(tc.annotation(product)->type == TypeTable::int64Type);
+  CHECK_FALSE(tc.annotation(product)->dec);
+  const ExpressionInfo *recursion = tc.annotation(product.binOp->leftSide);
+  REQUIRE(recursion);
+  CHECK(recursion->dec == pr.program.decs[4]);
+  const ExpressionInfo *parameter = tc.annotation(product.binOp->leftSide.funcCall->args[0]);
+  REQUIRE(parameter);
+  CHECK(parameter->type == tc.types.pointerTo(tc.types.structType(pr.program.decs[0])));
+  CHECK(parameter->dec->varDec == area.params[0].varDec);
+
+  // the body of a function template is annotated once per instance
+  FunctionDec &identity = pr.program.decs[1]->tempDec->funcDec;
+  const Expression *value = &identity.body.scopeStatements[0].controlFlow->returnStatement->returnValue;
+  CHECK_FALSE(tc.annotation(*value));
+  const TemplateInstance &ints = tc.instances[tc.createdInstances[*tc.lookUp.find("intIdentity")]];
+  const TemplateInstance &chars = tc.instances[tc.createdInstances[*tc.lookUp.find("charIdentity")]];
+  REQUIRE(ints.expressions.count(value));
+  REQUIRE(chars.expressions.count(value));
+  CHECK(ints.expressions.at(value).type == TypeTable::int32Type);
+  CHECK(chars.expressions.at(value).type == TypeTable::charType);
+}
+
+TEST_CASE("Checking every part of an expression", "[checker]") {
+  const std::string str =
+R"(
+struct Point { x: int32; y: int32; }
+func f(p: Point, n: int32): bool {
+  list: int32 ptr = [n, missingA];
+  list[missingB];
+  switch n {
+    case missingC { return true; }
+    default { missingD; }
+  }
+  return n == p;
+}
+)";
+  std::vector<Tokenizer> tks;
+  tks.emplace_back("./src/checker/test_checker.cpp", str);
+  Parser pr{tks.back(), mem3};
+  REQUIRE(pr.parse());
+  Checker tc{pr.program, tks, mem3};
+  CHECK_FALSE(tc.check());
+  // names used in literals, array offsets and switch statements are looked up
+  const char *missing[] = {"missingA", "missingB", "missingC", "missingD"};
+  REQUIRE(tc.errors.size() == 5);
+  for (uint32_t i = 0; i < 4; ++i) {
+    CHECK(tc.errors[i].type == CheckerErrorType::NO_SUCH_VARIABLE);
+    CHECK(tks.back().extractToken(tc.errors[i].token) == missing[i]);
+  }
+  // the right side of a comparison is checked, not the left side twice
+  CHECK(tc.errors[4].type == CheckerErrorType::CANNOT_COMPARE_TYPE);
+  CHECK(tks.back().extractToken(tc.errors[4].token) == "p");
+
+  StatementList &body = pr.program.decs[1]->funcDec->body.scopeStatements;
+  Expression &literal = *body[0].varDec->initialAssignment;
+  REQUIRE(tc.annotation(literal));
+  CHECK(tc.annotation(literal)->type == TypeTable::badType);
+  REQUIRE(tc.annotation(literal.arrayOrStruct->values[0]));
+  CHECK(tc.annotation(literal.arrayOrStruct->values[0])->type == TypeTable::int32Type);
+  CHECK(tc.annotation(body[1].expression->arrAccess->offset));
+  SwitchStatement &switchStatement = *body[2].controlFlow->switchStatement;
+  REQUIRE(tc.annotation(switchStatement.switched));
+  CHECK(tc.annotation(switchStatement.switched)->type == TypeTable::int32Type);
+  REQUIRE(switchStatement.body.next);
+  CHECK(tc.annotation(*switchStatement.body.next->caseBody->scopeStatements[0].expression));
+  const ExpressionInfo *point = tc.annotation(body[3].controlFlow->returnStatement->returnValue.binOp->rightSide);
+  REQUIRE(point);
+  CHECK(point->type == tc.types.structType(pr.program.decs[0]));
+}
@@ -0,0 +1,153 @@
+#include "typeTable.hpp"
+
+namespace {
+
+uint8_t builtinWidth(TokenType type) {
+  switch (type) {
+    case TokenType::BOOL:
+    case TokenType::CHAR_TYPE:
+    case TokenType::INT8_TYPE:
+    case TokenType::UINT8_TYPE: return 1;
+    case TokenType::INT16_TYPE:
+    case TokenType::UINT16_TYPE: return 2;
+    case TokenType::INT32_TYPE:
+    case TokenType::UINT32_TYPE:
+    case TokenType::FLOAT_TYPE: return 4;
+    case TokenType::INT64_TYPE:
+    case TokenType::UINT64_TYPE:
+    case TokenType::POINTER:
+    case TokenType::DOUBLE_TYPE: return 8;
+    default: return 0;
+  }
+}
+
+}
+
+TypeTable::TypeTable() {
+  add(TypeInfo{nullptr, 0, 0, TokenType::BAD_VALUE, 0, false});
+  add(TypeInfo{nullptr, 0, 0, TokenType::NOTHING, 0, false});
+  add(TypeInfo{nullptr, 0, 0, TokenType::NULL_PTR, 8, false});
+  for (TypeId kind = (TypeId)TokenType::BOOL; kind <= (TypeId)TokenType::VOID; ++kind) {
+    const TokenType type = (TokenType)kind;
+    const bool isIntegral = type >= TokenType::CHAR_TYPE && type <= TokenType::UINT64_TYPE;
+    add(TypeInfo{nullptr, 0, 0, type, builtinWidth(type), isIntegral});
+  }
+  // the builtin pointer slot is void ptr
+  at(ptrType).next = voidType;
+  slot(voidType).pointer = ptrType;
+  pointerTo(charType);
+}
+
+/**
+ * Stores a new type. The caller holds addLock, or is the only user of the table
+*/
+TypeId TypeTable::add(const TypeInfo& info) {
+  const uint32_t biased = count + firstChunkSize;
+  const uint32_t chunk = 31 - __builtin_clz(biased);
+  if (biased == 1u << chunk) {
+    chunks[chunk - firstChunkBits].reset(new Slot[1u << chunk]);
+  }
+  at(count) = info;
+  return count++;
+}
+
+/**
+ * \param cached the pointer or reference slot of next.
+ * The new type is stored before its id is published with release order, so a thread that reads the id also sees the type
+*/
+TypeId TypeTable::derived(std::atomic<TypeId>& cached, TokenType kind, TypeId next) {
+  TypeId id = cached.load(std::memory_order_acquire);
+  if (id) {
+    return id;
+  }
+  std::lock_guard<std::mutex> guard{addLock};
+  // another thread may have added it while this one waited
+  id = cached.load(std::memory_order_relaxed);
+  if (!id) {
+    id = add(TypeInfo{nullptr, next, 0, kind, builtinWidth(kind), false});
+    cached.store(id, std::memory_order_release);
+  }
+  return id;
+}
+
+TypeId TypeTable::pointerTo(TypeId id) {
+  return derived(slot(id).pointer, TokenType::POINTER, id);
+}
+
+TypeId TypeTable::referenceTo(TypeId id) {
+  return derived(slot(id).reference, TokenType::REFERENCE, id);
+}
+
+TypeId TypeTable::structType(GeneralDec *dec) {
+  {
+    std::shared_lock<std::shared_mutex> guard{structLock};
+    const auto found = structTypes.find(dec);
+    if (found != structTypes.end()) {
+      return found->second;
+    }
+  }
+  std::lock_guard<std::shared_mutex> guard{structLock};
+  TypeId &id = structTypes[dec];
+  if (!id) {
+    std::lock_guard<std::mutex> addGuard{addLock};
+    id = add(TypeInfo{dec, 0, 0, TokenType::IDENTIFIER, 0, false});
+  }
+  return id;
+}
+
+/**
+ * Each instance of a template struct is a distinct type. Instances are deduplicated by the checker, so this always adds a type
+*/
+TypeId TypeTable::instanceType(GeneralDec *templateDec, uint32_t instance) {
+  std::lock_guard<std::mutex> guard{addLock};
+  return add(TypeInfo{templateDec, 0, instance, TokenType::IDENTIFIER, 0, false});
+}
+
+/**
+ * Type of an arithmetic operation between two builtin types
+*/
+TypeId TypeTable::largest(TypeId a, TypeId b) const {
+  if (at(a).kind == TokenType::POINTER || at(b).kind == TokenType::POINTER) {
+    return ptrType;
+  }
+  if (at(a).kind > at(b).kind) {
+    return a;
+  }
+  return b;
+}
+
+// only builtin types can be converted to bool, except for void.
+bool TypeTable::canBeConvertedToBool(TypeId id) const {
+  return isBuiltInType(at(id).kind) && at(id).kind != TokenType::VOID;
+}
+
+/**
+ * \returns true if a value of type rightSide can be assigned to a variable of type leftSide
+*/
+bool TypeTable::checkAssignment(TypeId leftSide, TypeId rightSide) const {
+  const TokenType left = at(leftSide).kind, right = at(rightSide).kind;
+  if (left == TokenType::VOID || right == TokenType::VOID || leftSide == badType || rightSide == badType) {
+    return false;
+  }
+  if (left == TokenType::POINTER) {
+    if (right != TokenType::POINTER) {
+      return right == TokenType::NULL_PTR;
+    }
+    // strip matching pointer levels, void ptr converts to and from any pointer
+    while (at(leftSide).kind == TokenType::POINTER && at(rightSide).kind == TokenType::POINTER) {
+      leftSide = at(leftSide).next;
+      rightSide = at(rightSide).next;
+    }
+    if (leftSide == rightSide) {
+      return true;
+    }
+    if (at(leftSide).kind != at(rightSide).kind) {
+      return at(leftSide).kind == TokenType::VOID || at(rightSide).kind == TokenType::VOID;
+    }
+    return at(leftSide).kind != TokenType::IDENTIFIER;
+  }
+  if (left == TokenType::IDENTIFIER || right == TokenType::IDENTIFIER) {
+    return leftSide == rightSide;
+  }
+  return true;
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "../nodes.hpp"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
+/**
+ * Properties of an interned type
+ * kind is the builtin type token, POINTER, REFERENCE, IDENTIFIER for struct types,
+ * or one of the checker only kinds: NOTHING (no value), BAD_VALUE (error already reported), NULL_PTR
+*/
+struct TypeInfo {
+  GeneralDec *dec{nullptr}; // declaration of a struct type, or the template of a template struct instance
+  TypeId next{0}; // pointee of a pointer, referred type of a reference
+  uint32_t instance{0}; // index of the checker's template instance, for template struct instances
+  TokenType kind{TokenType::BAD_VALUE};
+  uint8_t width{0}; // size in bytes, 0 if not known
+  bool isIntegral{false};
+};
+
+// builtin types have fixed ids, in the order of their tokens
+constexpr TypeId builtinType(TokenType type) {
+  return 3 + (TypeId)type - (TypeId)TokenType::BOOL;
+}
+
+/**
+ * Interns every distinct type to a dense TypeId, so that types are compared with a single integer compare.
+ * Builtin types have fixed ids, derived types are created on first use and live as long as the table.
+ * Several threads can add and read types at once. Types never move once added, so reading a type by id takes no lock.
+ * Looking up a type that already exists takes no lock for pointers and references, and a shared lock for structs.
+ * Only adding a type takes addLock
+*/
+class TypeTable {
+  // a type, and the ids of the pointer and reference to it once they exist (0 until then)
+  struct Slot {
+    TypeInfo info;
+    std::atomic<TypeId> pointer{0};
+    std::atomic<TypeId> reference{0};
+  };
+  // chunk i holds firstChunkSize << i types, so the chunks never need to be reallocated
+  static constexpr uint32_t firstChunkBits = 6;
+  static constexpr uint32_t firstChunkSize = 1 << firstChunkBits;
+  static constexpr uint32_t chunkCount = 32 - firstChunkBits;
+  std::unique_ptr<Slot[]> chunks[chunkCount];
+  uint32_t count{0};
+  std::unordered_map<const GeneralDec *, TypeId> structTypes;
+  std::shared_mutex structLock; // guards structTypes
+  std::mutex addLock;
+
+  Slot& slot(TypeId id) const {
+    const uint32_t biased = id + firstChunkSize;
+    const uint32_t chunk = 31 - __builtin_clz(biased);
+    return chunks[chunk - firstChunkBits][biased - (1u << chunk)];
+  }
+  TypeInfo& at(TypeId id) const { return slot(id).info; }
+  TypeId add(const TypeInfo&);
+  TypeId derived(std::atomic<TypeId>&, TokenType, TypeId);
+
+public:
+  static constexpr TypeId badType = 0;
+  static constexpr TypeId noneType = 1;
+  static constexpr TypeId nullptrType = 2;
+  static constexpr TypeId boolType = builtinType(TokenType::BOOL);
+  static constexpr TypeId charType = builtinType(TokenType::CHAR_TYPE);
+  static constexpr TypeId int32Type = builtinType(TokenType::INT32_TYPE);
+  static constexpr TypeId uint32Type = builtinType(TokenType::UINT32_TYPE);
+  static constexpr TypeId int64Type = builtinType(TokenType::INT64_TYPE);
+  static constexpr TypeId uint64Type = builtinType(TokenType::UINT64_TYPE);
+  static constexpr TypeId ptrType = builtinType(TokenType::POINTER); // void ptr
+  static constexpr TypeId floatType = builtinType(TokenType::FLOAT_TYPE);
+  static constexpr TypeId doubleType = builtinType(TokenType::DOUBLE_TYPE);
+  static constexpr TypeId voidType = builtinType(TokenType::VOID);
+  static constexpr TypeId stringType = voidType + 1; // char ptr
+
+  TypeTable();
+  TypeTable(const TypeTable&) = delete;
+  TypeTable& operator=(const TypeTable&) = delete;
+
+  const TypeInfo& operator[](TypeId id) const { return at(id); }
+  TypeId pointerTo(TypeId);
+  TypeId referenceTo(TypeId);
+  TypeId structType(GeneralDec *);
+  TypeId instanceType(GeneralDec *, uint32_t);
+  TypeId largest(TypeId, TypeId) const;
+  bool canBeConvertedToBool(TypeId) const;
+  bool checkAssignment(TypeId, TypeId) const;
+};
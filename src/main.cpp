@@ -3,8 +3,11 @@
 #include <string>
 #include <sstream>
 #include <iterator>
+#include <iomanip>
+#include <memory>
 #include "./parser/parser.hpp"
 #include "./checker/checker.hpp"
+#include "./serializer/serializer.hpp"
 
 bool openAndReadFile(const std::string& file, std::string& buffer) {
   std::ifstream t(file);
@@ -34,22 +37,95 @@ void splitFilePath(const std::string& filePath, std::vector<std::string>& split)
   split.push_back(filePath.substr(last));
 }
 
+/**
+ * Writes a precompiled module for every file that was parsed from source
+ * \returns false if a module could not be written
+*/
+bool emitModules(Parser& parser, std::vector<Tokenizer>& tokenizers, const std::vector<std::unique_ptr<ModuleFile>>& modules) {
+  std::vector<std::vector<GeneralDec *>> decsPerFile(tokenizers.size());
+  for (GeneralDec *dec : parser.program.decs) {
+    decsPerFile[tokenizerAt(tokenizers, dec->location()).tokenizerIndex].push_back(dec);
+  }
+  std::string bytes;
+  for (uint32_t i = 0; i < tokenizers.size(); ++i) {
+    if (modules[i]) {
+      // loaded from an up to date module already
+      continue;
+    }
+    const std::string path = modulePath(tokenizers[i].filePath);
+    if (!serializeModule(tokenizers[i], decsPerFile[i], bytes)) {
+      // the file has declarations that modules cannot hold, such as enums. it is parsed from source every time
+      std::cerr << "Module skipped, declarations cannot be precompiled: " << tokenizers[i].filePath << '\n';
+      continue;
+    }
+    if (!writeModuleFile(path, bytes)) {
+      std::cerr << "Could not write module: " << path << '\n';
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * Prints the memory used by the node pool, and the allocation counters of each node type that was allocated
+*/
+void printMemStats(const char *phase, const NodeMemPool& mem) {
+  std::cout << "Memory " << phase << ": " << mem.usedBytes() << " bytes used of " << mem.retainedBytes()
+    << " reserved, " << mem.blockAllocations() << " block allocations\n";
+  if (!MEM_STATS_ENABLED) {
+    std::cout << "  allocation counters are disabled in this build, define MEM_STATS to enable them\n";
+    return;
+  }
+  std::cout << std::left << std::setw(26) << "  type" << std::right << std::setw(12) << "live" << std::setw(12) << "high water"
+    << std::setw(12) << "allocated" << std::setw(12) << "released" << std::setw(12) << "bytes" << '\n';
+  for (uint32_t row = 0; row < NodeMemPool::statsRowCount; ++row) {
+    const AllocationStats& stats = mem.allocationStats(row);
+    if (!stats.allocations) {
+      continue;
+    }
+    std::cout << "  " << std::left << std::setw(24) << NodeMemPool::statsNames[row] << std::right << std::setw(12) << stats.live
+      << std::setw(12) << stats.highWater << std::setw(12) << stats.allocations << std::setw(12) << stats.releases
+      << std::setw(12) << stats.bytes << '\n';
+  }
+}
+
 /**
  * General design and details:
  * - Every parsed file has it's own Tokenizer. When an 'include' declaration is encountered, a new Tokenizer is created
- * for the included file and swapped into the Parser object. This allows for good error message details
- * since position and file information can easily be extracted even during the Checker phase.
+ * for the included file and swapped into the Parser object. Files are given consecutive ranges of one location space,
+ * so a token alone identifies its file, line and column, even during the Checker phase.
  * 
  * - The file path is stored in the Tokenizer object. Paths are kept minimized by spliting paths
  * and removing or adding directories only when required from 'include's
+ * 
+ * - Declarations are streamed from the Parser to the Checker as they are parsed, so the Checker's first
+ * top level scan (name registration) is done while the declaration is still hot instead of in a separate pass
+ *
+ * - With --emit-modules, the declarations of each file are written to a precompiled module next to it (file.pr -> file.prm).
+ * An included file with an up to date module is not tokenized or parsed; its declarations are decoded from the module instead
+ *
+ * - With --mem-stats, the memory used by the nodes is printed after parsing and after checking
 */
 int main(int argc, char **argv) {
-  if (argc != 2) {
-    std::cout << "Usage: " << argv[0] << " <Filepath>\n";
+  bool shouldEmitModules = false;
+  bool shouldPrintMemStats = false;
+  int arg = 1;
+  for (; arg < argc - 1; ++arg) {
+    const std::string flag{argv[arg]};
+    if (flag == "--emit-modules") {
+      shouldEmitModules = true;
+    } else if (flag == "--mem-stats") {
+      shouldPrintMemStats = true;
+    } else {
+      break;
+    }
+  }
+  if (arg != argc - 1) {
+    std::cout << "Usage: " << argv[0] << " [--emit-modules] [--mem-stats] <Filepath>\n";
     return 1;
   }
   // try to open the cl argument
-  std::string mainFile = argv[1];
+  std::string mainFile = argv[argc - 1];
   std::cout << "Filepath: " << mainFile << '\n';
   std::string buffer;
   if (!openAndReadFile(mainFile, buffer)) {
@@ -64,16 +140,36 @@ int main(int argc, char **argv) {
 
   std::vector<Tokenizer> tokenizers;
   tokenizers.emplace_back(std::move(mainFile), std::move(buffer)); // create a tokenizer for the main file
-  NodeMemPool mem;
+  // parallel to tokenizers. set for files whose declarations come from a precompiled module
+  std::vector<std::unique_ptr<ModuleFile>> modules(1);
+  std::vector<uint32_t> nextModuleDec(1, 0);
+  ReservedBlockSource nodeMemory;
+  NodeMemPool mem{&nodeMemory};
+  mem.reserveForSource(tokenizers[0].content.size());
   Parser parser{tokenizers[0], mem};
+  Checker checker{parser.program, tokenizers, mem};
+  parser.onGeneralDec = [&checker](GeneralDec& dec) {
+    checker.registerDec(dec);
+  };
   uint32_t tokenizerIndex = 0;
   while (true) {
-    GeneralDec* dec = parser.parseNext();
+    GeneralDec* dec;
+    ModuleFile *module = modules[tokenizerIndex].get();
+    if (module && nextModuleDec[tokenizerIndex] < module->decCount()) {
+      const uint32_t baseLocation = tokenizers[tokenizerIndex].baseLocation;
+      if (!module->decodeDec(nextModuleDec[tokenizerIndex]++, *parser.current, mem, baseLocation)) {
+        std::cerr << "Corrupt module: " << modulePath(tokenizers[tokenizerIndex].filePath) << '\n';
+        return 1;
+      }
+      dec = parser.appendGeneralDec();
+    } else {
+      dec = parser.parseNext();
+    }
     if (!dec) {
-      // there was some error
-      break;
+      // syntax error, skip to the next declaration so that all errors get reported
+      parser.synchronizeGlobal();
+      continue;
     }
-    dec->tokenizerIndex = tokenizerIndex;
     if (dec->type == GeneralDecType::NOTHING) {
       // end of file for current tokenizer. find next valid tokenizer, swap, and continue parsing
       if (tokenizerIndex == 0) {
@@ -81,7 +177,10 @@ int main(int argc, char **argv) {
         break;
       }
       while (tokenizerIndex > 0) {
-        if (tokenizers[--tokenizerIndex].peekNext().type != TokenType::END_OF_FILE) {
+        --tokenizerIndex;
+        const ModuleFile *pending = modules[tokenizerIndex].get();
+        if (tokenizers[tokenizerIndex].peekNext().type != TokenType::END_OF_FILE ||
+          (pending && nextModuleDec[tokenizerIndex] < pending->decCount())) {
           parser.swapTokenizer(tokenizers[tokenizerIndex]);
           currentFileDirectory.clear();
           splitFilePath(tokenizers[tokenizerIndex].filePath, currentFileDirectory);
@@ -137,28 +236,37 @@ int main(int argc, char **argv) {
         std::cerr << tk.filePath << ':' << posInfo.lineNum << ':' << posInfo.linePos << '\n';
         return 1;
       }
-      tokenizers.emplace_back(std::move(relativePath), std::move(buffer));
+      std::unique_ptr<ModuleFile> includedModule = std::make_unique<ModuleFile>();
+      if (!includedModule->open(modulePath(relativePath)) || !includedModule->matches(buffer)) {
+        includedModule.reset();
+      }
+      const uint32_t baseLocation = tokenizers.back().endLocation();
+      tokenizers.emplace_back(std::move(relativePath), std::move(buffer), baseLocation);
       tokenizerIndex = tokenizers.size() - 1;
       tokenizers.back().tokenizerIndex = tokenizerIndex;
+      mem.reserveForSource(tokenizers.back().content.size());
+      if (includedModule) {
+        includedModule->loadNewlines(tokenizers.back());
+      }
+      modules.emplace_back(std::move(includedModule));
+      nextModuleDec.emplace_back(0);
       parser.swapTokenizer(tokenizers.back());
     }
   }
-  if (parser.globalPrev) {
-    mem.release(parser.globalPrev->next);
-    parser.globalPrev->next = nullptr;
+  if (shouldPrintMemStats) {
+    printMemStats("after parsing", mem);
   }
-
-  if (!parser.expected.empty() || !parser.unexpected.empty()) {
-    for (auto& error : parser.expected) {
-      std::cerr << error.getErrorMessage(tokenizers);
-    }
-    for (auto& error : parser.unexpected) {
-      std::cerr << error.getErrorMessage(tokenizers);
-    }
+  if (!parser.expected.empty() || !parser.unexpected.empty() || !parser.nestingTooDeep.empty()) {
+    std::cerr << parser.getErrorMessages(tokenizers);
     return 1;
   }
-  Checker checker{parser.program, tokenizers, mem};
-  checker.check();
+  if (shouldEmitModules && !emitModules(parser, tokenizers, modules)) {
+    return 1;
+  }
+  checker.checkRegistered();
+  if (shouldPrintMemStats) {
+    printMemStats("after checking", mem);
+  }
   if (!checker.errors.empty()) {
     int i = 0;
     for (auto& error : checker.errors) {
@@ -1,108 +1,196 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
-#include <cstdlib>
+#include <new>
+#include <vector>
+#include "blockSource.hpp"
 
 /**
- * Template memory pool. Allocations are not reallocated, so the memory address of data is permanent.
- * Memory is not freed when reset; only on destruction.
- * Not thread safe
+ * Memory pool for arrays of varying length. Arrays are carved out of large blocks one after another,
+ * so the memory address of data is permanent. Arrays cannot be released individually.
+ * Blocks grow geometrically, each new block is as large as all of the blocks before it within the min and max,
+ * so small pools stay small and large ones need few allocations. reserve allocates for a known size up front.
+ * Blocks come from a BlockSource, malloc by default.
+ * Blocks are not freed when reset unless they are over the limit given to it, only on destruction.
+ * A reserved source still returns the pages of the blocks that were used on reset.
+ * Not thread safe. Each thread uses its own pool, and blocks are handed to another pool with adopt
 */
-template<typename T>
-struct MemPool {
-  uint32_t j; // index of last array that was used
-  uint32_t n; // how many arrays have been allocated
-  uint32_t mainArraySize; // number of slots available for arrays to be allocated
-  const uint32_t arraySize; // number of units available per array
-  struct Obj {
-    union {
-      T val;
-      Obj *next;
-    };
+struct ArrayPool {
+  struct Block {
+    char *data;
+    size_t size;
+    BlockSource *source; // adopted blocks can come from another source
   };
-  Obj *freeObj;
-  Obj **mem;
-
-  MemPool(uint32_t arraySize = 500): j{0}, n{0}, mainArraySize{10}, arraySize{arraySize} {
-    mem = (Obj**)malloc(sizeof (Obj*) * mainArraySize);
-    mem[0] = (Obj*)malloc(sizeof (Obj) * (arraySize));
-    initializeList(mem[0]);
-    freeObj = mem[0];
-  }
+  std::vector<Block> blocks;
+  uint32_t j{0}; // index of the block in use
+  size_t used{0}; // bytes used in the block in use
+  size_t retained{0}; // total size of the blocks
+  size_t blockAllocations{0}; // blocks taken from the source over the lifetime of the pool
+  const size_t minBlockSize; // size of the first block in bytes
+  const size_t maxBlockSize; // size that blocks stop growing at, arrays larger than it still get a block of their own
+  BlockSource *const source;
+
+  ArrayPool(size_t minBlockSize = 1 << 16, BlockSource *source = nullptr, size_t maxBlockSize = 1 << 26):
+    minBlockSize{minBlockSize}, maxBlockSize{maxBlockSize < minBlockSize ? minBlockSize : maxBlockSize},
+    source{source ? source : &mallocBlockSource()} {}
 
-  MemPool(const MemPool &) = delete;
-  MemPool(MemPool&&) = delete;
+  ArrayPool(const ArrayPool &) = delete;
+  ArrayPool(ArrayPool&&) = delete;
 
-  ~MemPool() {
-    for (uint32_t i = 0; i <= n; ++i) {
-      free(mem[i]);
+  ~ArrayPool() {
+    // newest first, so that a reserved range can be handed out again
+    for (size_t i = blocks.size(); i-- > 0;) {
+      blocks[i].source->deallocate(blocks[i].data, blocks[i].size);
     }
-    free(mem);
   }
 
-  void reset() {
-    initializeList(mem[0]);
-    freeObj = mem[0];
+  /**
+   * Makes all of the pool available again. Blocks are kept and reused in order, the ones that were used are
+   * discarded by their source (a reserved source returns their pages, malloc blocks are not touched)
+   * \param maxRetainedBytes memory to keep for reuse, blocks past it are freed
+  */
+  void reset(size_t maxRetainedBytes = SIZE_MAX) {
+    const size_t usedBlocks = j < blocks.size() ? j + 1 : blocks.size();
     j = 0;
+    used = 0;
+    if (retained <= maxRetainedBytes) {
+      discard(usedBlocks);
+      return;
+    }
+    retained = 0;
+    size_t keep = 0;
+    for (; keep < blocks.size() && retained + blocks[keep].size <= maxRetainedBytes; ++keep) {
+      retained += blocks[keep].size;
+    }
+    for (size_t i = blocks.size(); i-- > keep;) {
+      blocks[i].source->deallocate(blocks[i].data, blocks[i].size);
+    }
+    blocks.resize(keep);
+    discard(usedBlocks < keep ? usedBlocks : keep);
   }
 
-  void addList() {
-    if (++j > n) {
-      if (++n >= mainArraySize) {
-        mainArraySize += mainArraySize;
-        mem = (Obj**)realloc(mem, sizeof (Obj*) * (mainArraySize));
-      }
-      mem[n] = (Obj*)malloc(sizeof (Obj) * (arraySize));
+  // lets the source of each of the first count blocks drop their contents
+  void discard(size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+      blocks[i].source->discard(blocks[i].data, blocks[i].size);
     }
-    initializeList(mem[j]);
   }
 
-  void initializeList(Obj* list) {
-    for (uint32_t i = 0; i < arraySize - 1; ++i) {
-      list[i].next = &list[i + 1];
+  size_t retainedBytes() const {
+    return retained;
+  }
+
+  /**
+   * Bytes up to where the next array goes, including the ends of blocks that were too small for the array after them
+  */
+  size_t usedBytes() const {
+    size_t bytes = used;
+    for (uint32_t i = 0; i < j && i < blocks.size(); ++i) {
+      bytes += blocks[i].size;
     }
-    list[arraySize - 1].next = nullptr;
+    return bytes;
   }
 
-  void release(T *obj) {
-    ((Obj*)obj)->next = freeObj;
-    freeObj = (Obj *)obj;
+  // position of the next allocation, see rollback
+  struct Mark {
+    uint32_t j;
+    size_t used;
+  };
+
+  Mark mark() const {
+    return Mark{j, used};
   }
 
-  T *get(T&& t) {
-    if (!freeObj->next) {
-      addList();
-      freeObj->next = mem[n];
+  /**
+   * Gives back every array allocated since the mark was taken, in constant time. Blocks are kept and reused in order.
+   * The pool must not have been reset or have adopted blocks since
+  */
+  void rollback(const Mark& mark) {
+    j = mark.j;
+    used = mark.used;
+  }
+
+  /**
+   * Makes sure that the next bytes of arrays fit in the blocks the pool already has, allocating one block for the
+   * rest if they do not. Used as a hint when the amount of data is known ahead, alignment padding is not counted
+  */
+  void reserve(size_t bytes) {
+    size_t available = j < blocks.size() ? blocks[j].size - used : 0;
+    for (size_t i = j + 1; i < blocks.size() && available < bytes; ++i) {
+      available += blocks[i].size;
+    }
+    if (available >= bytes) {
+      return;
     }
+    // spare blocks are used in order, so this one is used once the ones before it are full
+    const size_t newBlockSize = bytes - available > minBlockSize ? bytes - available : minBlockSize;
+    blocks.push_back(Block{(char *)source->allocate(newBlockSize), newBlockSize, source});
+    retained += newBlockSize;
+    ++blockAllocations;
+  }
 
-    T *curr = &freeObj->val;
-    freeObj = freeObj->next;
-    new (curr) T{std::move(t)};
-    return curr;
+  /**
+   * Takes over the blocks of another pool, so that the arrays allocated from it outlive it.
+   * Blocks in use stay in use until this pool is reset, spare blocks become spare blocks of this pool.
+   * No memory is copied. The other pool must not be in use by another thread, and is left empty
+  */
+  void adopt(ArrayPool& other) {
+    const size_t inUse = other.j < other.blocks.size() ? other.j + 1 : other.blocks.size();
+    // blocks before j are full, so the adopted blocks go in front of the block in use
+    blocks.insert(blocks.begin() + j, other.blocks.begin(), other.blocks.begin() + inUse);
+    blocks.insert(blocks.end(), other.blocks.begin() + inUse, other.blocks.end());
+    j += inUse;
+    retained += other.retained;
+    blockAllocations += other.blockAllocations;
+    other.blockAllocations = 0;
+    other.blocks.clear();
+    other.j = 0;
+    other.used = 0;
+    other.retained = 0;
   }
 
-  T *get(const T& t) {
-    if (!freeObj->next) {
-      addList();
-      freeObj->next = mem[n];
+  void *allocate(size_t size, size_t alignment) {
+    for (; j < blocks.size(); ++j, used = 0) {
+      size_t offset = (used + alignment - 1) & ~(alignment - 1);
+      if (offset + size <= blocks[j].size) {
+        used = offset + size;
+        return blocks[j].data + offset;
+      }
     }
-
-    T *curr = &freeObj->val;
-    freeObj = freeObj->next;
-    new (curr) T{t};
-    return curr;
+    size_t newBlockSize = retained < minBlockSize ? minBlockSize : retained > maxBlockSize ? maxBlockSize : retained;
+    // arrays larger than a block get a block of their own
+    if (size > newBlockSize) {
+      newBlockSize = size;
+    }
+    blocks.push_back(Block{(char *)source->allocate(newBlockSize), newBlockSize, source});
+    retained += newBlockSize;
+    ++blockAllocations;
+    used = size;
+    return blocks[j].data;
   }
 
-  T *get() {
-    if (!freeObj->next) {
-      addList();
-      freeObj->next = mem[n];
+  template<typename T>
+  T *get(const T *values, uint32_t count) {
+    if (count == 0) {
+      return nullptr;
+    }
+    T *arr = (T *)allocate(sizeof (T) * count, alignof (T));
+    for (uint32_t i = 0; i < count; ++i) {
+      new (arr + i) T{values[i]};
     }
+    return arr;
+  }
 
-    T *curr = &freeObj->val;
-    freeObj = freeObj->next;
-    new (curr) T{};
-    return curr;
+  template<typename T>
+  T *get(uint32_t count) {
+    if (count == 0) {
+      return nullptr;
+    }
+    T *arr = (T *)allocate(sizeof (T) * count, alignof (T));
+    for (uint32_t i = 0; i < count; ++i) {
+      new (arr + i) T{};
+    }
+    return arr;
   }
-  
 };
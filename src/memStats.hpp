@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// allocation counters are kept in debug builds, or in any build with MEM_STATS defined.
+// otherwise the calls that update them compile to nothing, so they can stay in the allocation paths
+#if !defined(NDEBUG) || defined(MEM_STATS)
+#define MEM_STATS_ENABLED 1
+#else
+#define MEM_STATS_ENABLED 0
+#endif
+
+/**
+ * Allocation counters for one kind of object in a pool. Arrays count as one object each.
+ * Counters stay at zero when MEM_STATS_ENABLED is 0
+*/
+struct AllocationStats {
+  size_t allocations{0}; // objects handed out, including reused ones
+  size_t releases{0}; // objects given back individually
+  size_t live{0}; // objects handed out and not given back since the last reset
+  size_t highWater{0}; // most objects live at once
+  size_t bytes{0}; // bytes handed out, not counting alignment
+
+  void allocated(size_t size) {
+#if MEM_STATS_ENABLED
+    ++allocations;
+    bytes += size;
+    if (++live > highWater) {
+      highWater = live;
+    }
+#else
+    (void)size;
+#endif
+  }
+
+  void released() {
+#if MEM_STATS_ENABLED
+    ++releases;
+    --live;
+#endif
+  }
+
+  // everything live was given back at once
+  void cleared() {
+#if MEM_STATS_ENABLED
+    live = 0;
+#endif
+  }
+
+  // counts the objects of another pool as this pool's, the other pool's counters are cleared
+  void merge(AllocationStats& other) {
+#if MEM_STATS_ENABLED
+    allocations += other.allocations;
+    releases += other.releases;
+    live += other.live;
+    bytes += other.bytes;
+    if (other.highWater > highWater) {
+      highWater = other.highWater;
+    }
+    if (live > highWater) {
+      highWater = live;
+    }
+    other = AllocationStats{};
+#else
+    (void)other;
+#endif
+  }
+};
+
+/**
+ * Position of T in a list of types, at compile time. Fails to compile if T is not in the list
+*/
+template<typename T, typename... Ts>
+struct TypeIndex;
+
+template<typename T, typename... Ts>
+struct TypeIndex<T, T, Ts...> {
+  static constexpr uint32_t value = 0;
+};
+
+template<typename T, typename U, typename... Ts>
+struct TypeIndex<T, U, Ts...> {
+  static constexpr uint32_t value = 1 + TypeIndex<T, Ts...>::value;
+};
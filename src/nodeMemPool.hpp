@@ -2,123 +2,269 @@
 
 #include "nodes.hpp"
 #include "memPool.hpp"
+#include "memStats.hpp"
+#include <algorithm>
 
 /**
- * Memory pool for all nodes that require dynamic allocations
+ * Memory pool for all nodes that require dynamic allocations.
+ * Nodes of every type and the child spans are carved out of one arena in allocation order, so a node and
+ * the nodes parsed right after it (its children, mostly) are next to each other in memory.
+ * Released nodes are kept on free lists by size, and reused for nodes of the same size.
+ * Not thread safe. Threads that build nodes each use their own pool, without locking, and the pool that
+ * outlives them takes over their memory with adopt once they are done. Memory is only freed all at once,
+ * or given back to a Checkpoint.
+ * Allocations are counted per node type, and per type of child span, when MEM_STATS_ENABLED
 */
 class NodeMemPool {
-  MemPool<UnOp> unOps;
-  MemPool<BinOp> binOps;
-  MemPool<GeneralDec> decs;
-  MemPool<GeneralDecList> decLists;
-  MemPool<VariableDec> varDecs;
-  MemPool<FunctionCall> funcCalls;
-  MemPool<ElifStatementList> elifs;
-  MemPool<ControlFlowStatement> controlFlows;
-  MemPool<ArrayAccess> arrayAccesses;
-  MemPool<TokenList> tokenLists;
-  MemPool<Expression> expressions;
-  MemPool<ExpressionList> expressionLists;
-  MemPool<Scope> scopes;
-  MemPool<StatementList> statementLists;
-  MemPool<StructDecList> structDecLists;
-  MemPool<ArrayOrStructLiteral> arraysOrStructs;
-  MemPool<FunctionDec> functionDecs;
-  MemPool<StructDec> structDecs;
-  MemPool<TemplateDec> templateDecs;
-  MemPool<ConditionalStatement> conditionalStatements;
-  MemPool<ReturnStatement> returnStatements;
-  MemPool<ForLoop> forLoops;
-  MemPool<WhileLoop> whileLoops;
-  MemPool<SwitchStatement> switchStatements;
-  MemPool<SwitchScopeStatementList> switchScopeStatementLists;
-  MemPool<TemplateCreation> templateCreations;
-  MemPool<IncludeDec> includeDecs;
+  static constexpr size_t slotSize = sizeof (void *);
+  static constexpr size_t sizeClassCount = 32;
+  static inline void *const noFloor[sizeClassCount]{};
+  ArrayPool arena;
+  void *freeLists[sizeClassCount]{}; // released nodes by size in slots, linked through their first word
+  // free list heads when the innermost checkpoint was taken. nodes from there on down are not handed out, see Checkpoint
+  void *const *floor{noFloor};
+
+  template<typename T>
+  static constexpr size_t sizeClass() {
+    static_assert(alignof (T) <= slotSize, "nodes are aligned to pointers");
+    static_assert(sizeof (T) <= slotSize * (sizeClassCount - 1), "node too large for the free lists");
+    return (sizeof (T) + slotSize - 1) / slotSize;
+  }
 
 public:
-  void reset() {
-    unOps.reset();
-    binOps.reset();
-    decs.reset();
-    decLists.reset();
-    varDecs.reset();
-    funcCalls.reset();
-    elifs.reset();
-    controlFlows.reset();
-    arrayAccesses.reset();
-    tokenLists.reset();
-    expressions.reset();
-    expressionLists.reset();
-    scopes.reset();
-    statementLists.reset();
-    structDecLists.reset();
-    arraysOrStructs.reset();
-    functionDecs.reset();
-    structDecs.reset();
-    templateDecs.reset();
-    conditionalStatements.reset();
-    returnStatements.reset();
-    forLoops.reset();
-    whileLoops.reset();
-    switchStatements.reset();
-    switchScopeStatementLists.reset();
-    templateCreations.reset();
-    includeDecs.reset();
+  // rows of the allocation statistics, in the order of statsNames: node types, then spans by child type
+  static constexpr uint32_t nodeTypeCount = 23;
+  static constexpr uint32_t statsRowCount = nodeTypeCount + 3;
+  static constexpr const char *statsNames[statsRowCount] = {
+    "GeneralDec", "VariableDec", "FunctionDec", "StructDec", "TemplateDec", "TemplateCreation", "IncludeDec",
+    "Scope", "ControlFlowStatement", "ConditionalStatement", "ElifStatementList", "ReturnStatement", "ForLoop",
+    "WhileLoop", "SwitchStatement", "SwitchScopeStatementList", "Expression", "BinOp", "UnOp", "FunctionCall",
+    "ArrayAccess", "ArrayOrStructLiteral", "TokenList", "Statement[]", "Expression[]", "StructMember[]"
+  };
+
+private:
+  AllocationStats stats[statsRowCount];
+
+  template<typename T>
+  static constexpr uint32_t nodeRow() {
+    return TypeIndex<T, GeneralDec, VariableDec, FunctionDec, StructDec, TemplateDec, TemplateCreation, IncludeDec,
+      Scope, ControlFlowStatement, ConditionalStatement, ElifStatementList, ReturnStatement, ForLoop,
+      WhileLoop, SwitchStatement, SwitchScopeStatementList, Expression, BinOp, UnOp, FunctionCall,
+      ArrayAccess, ArrayOrStructLiteral, TokenList>::value;
+  }
+
+  template<typename T>
+  static constexpr uint32_t spanRow() {
+    return nodeTypeCount + TypeIndex<T, Statement, Expression, StructMember>::value;
   }
 
-  UnOp* makeUnOp(const UnOp& ref) {return unOps.get(ref);}
-  BinOp* makeBinOp(const BinOp& ref) {return binOps.get(ref);}
-  GeneralDec* makeGeneralDec() {return decs.get();}
-  GeneralDecList* makeGeneralDecList() {return decLists.get();}
-  VariableDec* makeVariableDec(const VariableDec& ref) {return varDecs.get(ref);}
-  FunctionCall* makeFunctionCall(const FunctionCall& ref) {return funcCalls.get(ref);}
-  ElifStatementList* makeElifStatementList() {return elifs.get();}
-  ControlFlowStatement* makeControlFlowStatement() {return controlFlows.get();}
-  ArrayAccess* makeArrayAccess(const ArrayAccess& ref) {return arrayAccesses.get(ref);}
-  TokenList* makeTokenList() {return tokenLists.get();}
-  Expression* makeExpression() {return expressions.get();}
-  ExpressionList* makeExpressionList() {return expressionLists.get();}
-  Scope* makeScope() {return scopes.get();}
-  StatementList* makeStatementList() {return statementLists.get();}
-  StructDecList* makeStructDecList() {return structDecLists.get();}
-  ArrayOrStructLiteral* makeArrayOrStruct() {return arraysOrStructs.get();}
-  FunctionDec* makeFunctionDec() {return functionDecs.get();}
-  StructDec* makeStructDec() {return structDecs.get();}
-  TemplateDec* makeTemplateDec() {return templateDecs.get();}
-  ConditionalStatement* makeConditionalStatement() {return conditionalStatements.get();}
-  ReturnStatement* makeReturnStatement() {return returnStatements.get();}
-  ForLoop* makeForLoop() {return forLoops.get();}
-  WhileLoop* makeWhileLoop() {return whileLoops.get();}
-  SwitchStatement* makeSwitchStatement() {return switchStatements.get();}
-  SwitchScopeStatementList* makeSwitchScopeStatementList() {return switchScopeStatementLists.get();}
-  TemplateCreation* makeTemplateCreation() {return templateCreations.get();}
-  IncludeDec* makeIncludeDec() {return includeDecs.get();}
-
-  void release(UnOp* ptr) { unOps.release(ptr);}
-  void release(BinOp* ptr) { binOps.release(ptr);}
-  void release(GeneralDec* ptr) { decs.release(ptr);}
-  void release(GeneralDecList* ptr) { decLists.release(ptr);}
-  void release(VariableDec* ptr) { varDecs.release(ptr);}
-  void release(FunctionCall* ptr) { funcCalls.release(ptr);}
-  void release(ElifStatementList* ptr) { elifs.release(ptr);}
-  void release(ControlFlowStatement* ptr) { controlFlows.release(ptr);}
-  void release(ArrayAccess* ptr) { arrayAccesses.release(ptr);}
-  void release(TokenList* ptr) { tokenLists.release(ptr);}
-  void release(Expression* ptr) { expressions.release(ptr);}
-  void release(ExpressionList* ptr) { expressionLists.release(ptr);}
-  void release(Scope* ptr) { scopes.release(ptr);}
-  void release(StatementList* ptr) { statementLists.release(ptr);}
-  void release(StructDecList* ptr) { structDecLists.release(ptr);}
-  void release(ArrayOrStructLiteral* ptr) { arraysOrStructs.release(ptr);}
-  void release(FunctionDec* ptr) { functionDecs.release(ptr);}
-  void release(StructDec* ptr) { structDecs.release(ptr);}
-  void release(TemplateDec* ptr) { templateDecs.release(ptr);}
-  void release(ConditionalStatement* ptr) { conditionalStatements.release(ptr);}
-  void release(ReturnStatement* ptr) { returnStatements.release(ptr);}
-  void release(ForLoop* ptr) {forLoops.release(ptr);}
-  void release(WhileLoop* ptr) { whileLoops.release(ptr);}
-  void release(SwitchStatement* ptr) { switchStatements.release(ptr);}
-  void release(SwitchScopeStatementList* ptr) { switchScopeStatementLists.release(ptr);}
-  void release(TemplateCreation* ptr) { templateCreations.release(ptr);}
-  void release(IncludeDec* ptr) { includeDecs.release(ptr);}
+public:
+  /**
+   * \param source where the arena gets its memory from, malloc if null. It must outlive the pool
+  */
+  explicit NodeMemPool(BlockSource *source = nullptr): arena{1 << 12, source} {}
+  NodeMemPool(const NodeMemPool&) = delete;
+  NodeMemPool& operator=(const NodeMemPool&) = delete;
+
+  /**
+   * Marks the pool so that everything allocated while the checkpoint is alive can be given back at once with rollback,
+   * such as the partial tree of a failed or speculative parse. Nodes released before the checkpoint are not reused
+   * while it is alive, so that rolling back leaves the free lists as they were. Nodes from before the checkpoint
+   * that are released while it is alive are lost until the next reset if it is rolled back.
+   * Checkpoints nest, and are kept (not rolled back) when they go out of scope.
+   * Cheaper marks within a checkpoint give back only what was allocated after them, see Mark.
+   * The pool must not be reset or adopt another pool while a checkpoint is alive
+  */
+  class Checkpoint {
+    NodeMemPool &pool;
+    const ArrayPool::Mark arena;
+    void *freeLists[sizeClassCount];
+    void *const *outerFloor;
+#if MEM_STATS_ENABLED
+    size_t live[statsRowCount];
+#endif
+
+  public:
+    explicit Checkpoint(NodeMemPool &pool): pool{pool}, arena{pool.arena.mark()}, outerFloor{pool.floor} {
+      std::copy(pool.freeLists, pool.freeLists + sizeClassCount, freeLists);
+      pool.floor = freeLists;
+#if MEM_STATS_ENABLED
+      for (uint32_t i = 0; i < statsRowCount; ++i) {
+        live[i] = pool.stats[i].live;
+      }
+#endif
+    }
+    Checkpoint(const Checkpoint&) = delete;
+    Checkpoint& operator=(const Checkpoint&) = delete;
+    ~Checkpoint() { pool.floor = outerFloor; }
+
+    /**
+     * Gives back every node and span allocated since the checkpoint was taken, in constant time.
+     * Nothing allocated since may be used afterwards. The checkpoint stays in place and can be rolled back to again
+    */
+    void rollback() {
+      pool.arena.rollback(arena);
+      std::copy(freeLists, freeLists + sizeClassCount, pool.freeLists);
+#if MEM_STATS_ENABLED
+      for (uint32_t i = 0; i < statsRowCount; ++i) {
+        pool.stats[i].live = live[i];
+      }
+#endif
+    }
+
+    /**
+     * A later position within the checkpoint. Taking one does not copy the free lists, so it is cheap enough
+     * to take per statement while the checkpoint covers a whole scope
+    */
+    struct Mark {
+      ArrayPool::Mark arena;
+#if MEM_STATS_ENABLED
+      size_t live[statsRowCount];
+#endif
+    };
+
+    Mark mark() const {
+      Mark mark;
+      mark.arena = pool.arena.mark();
+#if MEM_STATS_ENABLED
+      for (uint32_t i = 0; i < statsRowCount; ++i) {
+        mark.live[i] = pool.stats[i].live;
+      }
+#endif
+      return mark;
+    }
+
+    /**
+     * Gives back every node and span allocated since the mark was taken, in constant time.
+     * The checkpoint must be the innermost one. The free lists are restored to how they were at the checkpoint.
+     * That is safe, since nodes on them then are not handed out while it is alive. Nodes released since the checkpoint
+     * are lost until the next reset
+    */
+    void rollback(const Mark& mark) {
+      pool.arena.rollback(mark.arena);
+      std::copy(freeLists, freeLists + sizeClassCount, pool.freeLists);
+#if MEM_STATS_ENABLED
+      for (uint32_t i = 0; i < statsRowCount; ++i) {
+        pool.stats[i].live = mark.live[i];
+      }
+#endif
+    }
+  };
+
+  /**
+   * Makes the whole pool available again. Memory is kept for reuse up to maxRetainedBytes
+  */
+  void reset(size_t maxRetainedBytes = SIZE_MAX) {
+    arena.reset(maxRetainedBytes);
+    for (void *&list : freeLists) {
+      list = nullptr;
+    }
+    for (AllocationStats &row : stats) {
+      row.cleared();
+    }
+  }
+
+  size_t retainedBytes() const {
+    return arena.retainedBytes();
+  }
+
+  size_t usedBytes() const {
+    return arena.usedBytes();
+  }
+
+  size_t blockAllocations() const {
+    return arena.blockAllocations;
+  }
+
+  const AllocationStats& allocationStats(uint32_t row) const {
+    return stats[row];
+  }
+
+  // bytes of nodes per byte of source, measured on sampleCode (3.8 to 4.1). dense code runs up to twice that,
+  // the rest then comes from the arena growing
+  static constexpr size_t nodeBytesPerSourceByte = 4;
+
+  /**
+   * Hint that a source file of the given size is about to be parsed, so that its nodes are allocated at once
+  */
+  void reserveForSource(size_t sourceBytes) {
+    arena.reserve(sourceBytes * nodeBytesPerSourceByte);
+  }
+
+  /**
+   * Takes over the memory of another pool, typically one used by a worker thread. Nodes allocated from it
+   * stay valid for the lifetime of this pool. The other pool must be done being used, and is left empty;
+   * nodes it had released are not reused until the next reset
+  */
+  void adopt(NodeMemPool& other) {
+    arena.adopt(other.arena);
+    for (void *&list : other.freeLists) {
+      list = nullptr;
+    }
+    for (uint32_t i = 0; i < statsRowCount; ++i) {
+      stats[i].merge(other.stats[i]);
+    }
+  }
+
+  /**
+   * Constructs a node directly in the pool, forwarding the arguments to its constructor
+  */
+  template<typename T, typename... Args>
+  T* make(Args&&... args) {
+    constexpr size_t index = sizeClass<T>();
+    void *slot = freeLists[index];
+    // the floor is null when there is no checkpoint, so this also catches an empty list
+    if (slot != floor[index]) {
+      freeLists[index] = *(void **)slot;
+    } else {
+      slot = arena.allocate(index * slotSize, slotSize);
+    }
+    stats[nodeRow<T>()].allocated(sizeof (T));
+    return new (slot) T{std::forward<Args>(args)...};
+  }
+
+  GeneralDec* makeGeneralDec() {return make<GeneralDec>();}
+  ElifStatementList* makeElifStatementList() {return make<ElifStatementList>();}
+  ControlFlowStatement* makeControlFlowStatement() {return make<ControlFlowStatement>();}
+  TokenList* makeTokenList() {return make<TokenList>();}
+  Expression* makeExpression() {return make<Expression>();}
+  Scope* makeScope() {return make<Scope>();}
+  ArrayOrStructLiteral* makeArrayOrStruct() {return make<ArrayOrStructLiteral>();}
+  FunctionDec* makeFunctionDec() {return make<FunctionDec>();}
+  StructDec* makeStructDec() {return make<StructDec>();}
+  TemplateDec* makeTemplateDec() {return make<TemplateDec>();}
+  ConditionalStatement* makeConditionalStatement() {return make<ConditionalStatement>();}
+  ReturnStatement* makeReturnStatement() {return make<ReturnStatement>();}
+  ForLoop* makeForLoop() {return make<ForLoop>();}
+  WhileLoop* makeWhileLoop() {return make<WhileLoop>();}
+  SwitchStatement* makeSwitchStatement() {return make<SwitchStatement>();}
+  SwitchScopeStatementList* makeSwitchScopeStatementList() {return make<SwitchScopeStatementList>();}
+  TemplateCreation* makeTemplateCreation() {return make<TemplateCreation>();}
+  IncludeDec* makeIncludeDec() {return make<IncludeDec>();}
+  template<typename T>
+  NodeSpan<T> makeSpan(const T *values, uint32_t count) {
+    countSpan<T>(count);
+    return NodeSpan<T>{arena.get(values, count), count};
+  }
+  template<typename T>
+  NodeSpan<T> makeSpan(uint32_t count) {
+    countSpan<T>(count);
+    return NodeSpan<T>{arena.get<T>(count), count};
+  }
+
+  template<typename T>
+  void release(T* ptr) {
+    constexpr size_t index = sizeClass<T>();
+    *(void **)ptr = freeLists[index];
+    freeLists[index] = ptr;
+    stats[nodeRow<T>()].released();
+  }
+
+private:
+  template<typename T>
+  void countSpan(uint32_t count) {
+    if (count) {
+      stats[spanRow<T>()].allocated(sizeof (T) * count);
+    }
+  }
 };
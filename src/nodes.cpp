@@ -13,16 +13,15 @@ bool notFirstOfExpression(TokenType type) {
 }
 
 Expression::Expression(): binOp{nullptr}, type{ExpressionType::NONE} {}
-Expression::Expression(const Expression& ref): binOp{ref.binOp}, type{ref.type} {}
+Expression::Expression(const Expression& ref): binOp{ref.binOp}, type{ref.type}, annotation{ref.annotation} {}
 Expression::Expression(Token tk): value{tk}, type{ExpressionType::VALUE} {}
 Expression& Expression::operator=(const Expression&ref) {
   binOp = ref.binOp;
   type = ref.type;
+  annotation = ref.annotation;
   return *this;
 }
 
-ExpressionList::ExpressionList(): curr{}, next{nullptr} {}
-
 Statement::Statement(): expression{}, type{StatementType::NOTHING} {}
 Statement::Statement(const Statement& ref): expression{ref.expression}, type{ref.type} {}
 Statement& Statement::operator=(const Statement& ref) {
@@ -53,16 +52,15 @@ FunctionDec::FunctionDec(const Token& token): name{token} {}
 
 StructDec::StructDec(const Token& token): name{token} {}
 
-StructDecList::StructDecList(): funcDec{} {}
-StructDecList::StructDecList(const StructDecList& ref): next{ref.next}, type{ref.type} {
+StructMember::StructMember(): funcDec{} {}
+StructMember::StructMember(const StructMember& ref): type{ref.type} {
   if (type == StructDecType::VAR) {
     varDec = ref.varDec;
   } else if (type == StructDecType::FUNC) {
     funcDec = ref.funcDec;
   }
 }
-StructDecList& StructDecList::operator=(const StructDecList& other) {
-  next = other.next;
+StructMember& StructMember::operator=(const StructMember& other) {
   type = other.type;
   varDec = other.varDec;
   return *this;
@@ -74,6 +72,22 @@ TemplateDec::TemplateDec(): funcDec{} {}
 
 GeneralDec::GeneralDec(): tempDec{nullptr} {}
 
+/**
+ * A location within the declaration, used to find the file it was declared in
+*/
+uint32_t GeneralDec::location() const {
+  switch (type) {
+    case GeneralDecType::STRUCT: return structDec->name.position;
+    case GeneralDecType::VARIABLE: return varDec->name.position;
+    case GeneralDecType::FUNCTION: return funcDec->name.position;
+    case GeneralDecType::ENUM: return enumDec->name.position;
+    case GeneralDecType::TEMPLATE: return tempDec->templateTypes.token.position;
+    case GeneralDecType::TEMPLATE_CREATE: return tempCreate->typeName.position;
+    case GeneralDecType::INCLUDE_DEC: return includeDec->file.position;
+    default: return 0;
+  }
+}
+
 bool TokenList::operator==(const TokenList& ref) const {
   const TokenList* refCurr = &ref;
   const TokenList* thisCurr = this;
@@ -95,20 +109,19 @@ bool TokenList::operator==(const TokenList& ref) const {
 //             deep copy             //
 ///////////////////////////////////////
 
-GeneralDec* TemplateDec::deepCopy(NodeMemPool& mem, Token name) {
-  GeneralDec *copy = mem.makeGeneralDec();
-  if (isStruct) {
-    copy->type = GeneralDecType::STRUCT;
-    copy->structDec = structDec.deepCopy(mem);
-    copy->structDec->name = name;
-  } else {
-    copy->type = GeneralDecType::FUNCTION;
-    copy->funcDec = funcDec.deepCopy(mem);
-    copy->funcDec->name = name;
+template<typename T>
+NodeSpan<T> NodeSpan<T>::deepCopy(NodeMemPool& mem) const {
+  NodeSpan<T> copy = mem.makeSpan<T>(count);
+  for (uint32_t i = 0; i < count; ++i) {
+    copy[i] = data[i].deepCopy(mem);
   }
   return copy;
 }
 
+template struct NodeSpan<Expression>;
+template struct NodeSpan<Statement>;
+template struct NodeSpan<StructMember>;
+
 StructDec* StructDec::deepCopy(NodeMemPool& mem) {
   StructDec *copy = mem.makeStructDec();
   copy->name = name;
@@ -116,20 +129,14 @@ StructDec* StructDec::deepCopy(NodeMemPool& mem) {
   return copy;
 }
 
-StructDecList StructDecList::deepCopy(NodeMemPool& mem) {
-  StructDecList copy;
-  StructDecList *copiedList = &copy;
-  for (StructDecList *list = this; list; list = list->next, copiedList = copiedList->next) {
-    copiedList->type = list->type;
-    if (list->type == StructDecType::FUNC) {
-      copiedList->funcDec = list->funcDec->deepCopy(mem);
-    } else if (list->type == StructDecType::VAR) {
-      copiedList->varDec = mem.makeVariableDec(VariableDec{list->varDec->name});
-      *copiedList->varDec = list->varDec->deepCopy(mem);
-    }
-    copiedList->next = mem.makeStructDecList();
+StructMember StructMember::deepCopy(NodeMemPool& mem) {
+  StructMember copy;
+  copy.type = type;
+  if (type == StructDecType::FUNC) {
+    copy.funcDec = funcDec->deepCopy(mem);
+  } else if (type == StructDecType::VAR) {
+    copy.varDec = mem.make<VariableDec>(varDec->deepCopy(mem));
   }
-  mem.release(copiedList);
   return copy;
 }
 
@@ -148,17 +155,6 @@ Scope Scope::deepCopy(NodeMemPool& mem) {
   return copied;
 }
 
-StatementList StatementList::deepCopy(NodeMemPool& mem) {
-  StatementList copy;
-  StatementList *copiedList = &copy;
-  for (StatementList *list = this; list; list = list->next, copiedList = copiedList->next) {
-    copiedList->curr = list->curr.deepCopy(mem);
-    copiedList->next = mem.makeStatementList();
-  }
-  mem.release(copiedList);
-  return copy;
-}
-
 Statement Statement::deepCopy(NodeMemPool& mem) {
   Statement copy;
   copy.type = type;
@@ -166,8 +162,9 @@ Statement Statement::deepCopy(NodeMemPool& mem) {
     case StatementType::CONTROL_FLOW: copy.controlFlow = controlFlow->deepCopy(mem); break;
     case StatementType::EXPRESSION: copy.expression = mem.makeExpression(); *copy.expression = expression->deepCopy(mem); break;
     case StatementType::KEYWORD: copy.keyword = keyword; break;
+    case StatementType::ERROR: copy.errorStart = errorStart; break;
     case StatementType::SCOPE: copy.scope = mem.makeScope(); *copy.scope = scope->deepCopy(mem); break;
-    case StatementType::VARIABLE_DEC: copy.varDec = mem.makeVariableDec(VariableDec{varDec->name}); *copy.varDec = varDec->deepCopy(mem); break;
+    case StatementType::VARIABLE_DEC: copy.varDec = mem.make<VariableDec>(varDec->deepCopy(mem)); break;
     case StatementType::NOTHING: break;
   }
   return copy;
@@ -200,8 +197,7 @@ ConditionalStatement* ConditionalStatement::deepCopy(NodeMemPool& mem) {
     mem.release(copyList);
   }
   if (elseStatement) {
-    copy->elseStatement = mem.makeScope();
-    *copy->elseStatement = elseStatement->deepCopy(mem);
+    copy->elseStatement = mem.make<Scope>(elseStatement->deepCopy(mem));
   }
   return copy;
 }
@@ -266,8 +262,7 @@ IfStatement IfStatement::deepCopy(NodeMemPool& mem) {
 VariableDec VariableDec::deepCopy(NodeMemPool& mem) {
   VariableDec copy{name};
   copy.type = type.deepCopy(mem);
-  copy.initialAssignment = mem.makeExpression();
-  *copy.initialAssignment = initialAssignment->deepCopy(mem);
+  copy.initialAssignment = mem.make<Expression>(initialAssignment->deepCopy(mem));
   return copy;
 }
 
@@ -289,13 +284,13 @@ WhileLoop* WhileLoop::deepCopy(NodeMemPool& mem) {
 }
 
 ArrayAccess* ArrayAccess::deepCopy(NodeMemPool& mem) {
-  ArrayAccess* copy = mem.makeArrayAccess(ArrayAccess{array});
+  ArrayAccess* copy = mem.make<ArrayAccess>(array);
   copy->offset = offset.deepCopy(mem);
   return copy;
 }
 
 FunctionCall* FunctionCall::deepCopy(NodeMemPool& mem) {
-  FunctionCall* copy = mem.makeFunctionCall(FunctionCall{name});
+  FunctionCall* copy = mem.make<FunctionCall>(name);
   copy->args = args.deepCopy(mem);
   return copy;
 }
@@ -307,25 +302,14 @@ ArrayOrStructLiteral* ArrayOrStructLiteral::deepCopy(NodeMemPool& mem) {
 }
 
 UnOp* UnOp::deepCopy(NodeMemPool& mem) {
-  UnOp *copy = mem.makeUnOp(UnOp{op});
+  UnOp *copy = mem.make<UnOp>(op);
   copy->operand = operand.deepCopy(mem);
   return copy;
 }
 
 BinOp* BinOp::deepCopy(NodeMemPool& mem) {
-  BinOp *copy = mem.makeBinOp(BinOp{op});
+  BinOp *copy = mem.make<BinOp>(op);
   copy->leftSide = leftSide.deepCopy(mem);
   copy->rightSide = rightSide.deepCopy(mem);
   return copy;
 }
-
-ExpressionList ExpressionList::deepCopy(NodeMemPool& mem) {
-  ExpressionList copy;
-  ExpressionList *copyList = &copy;
-  for (ExpressionList *list = this; list; list = list->next, copyList = copyList->next) {
-    copyList->curr = list->curr.deepCopy(mem);
-    copyList->next = mem.makeExpressionList();
-  }
-  mem.release(copyList);
-  return copy;
-}
@@ -6,6 +6,22 @@ typedef class NodeMemPool NodeMemPool;
 
 bool notFirstOfExpression(TokenType);
 
+/**
+ * A contiguous run of child nodes, allocated in one piece from the NodeMemPool.
+ * Children are collected while parsing and committed once the parent is complete, so the span never grows
+*/
+template<typename T>
+struct NodeSpan {
+  T *data{nullptr};
+  uint32_t count{0};
+  T *begin() const {return data;}
+  T *end() const {return data + count;}
+  uint32_t size() const {return count;}
+  bool empty() const {return count == 0;}
+  T& operator[](uint32_t i) const {return data[i];}
+  NodeSpan deepCopy(NodeMemPool&) const;
+};
+
 typedef struct BinOp BinOp;
 typedef struct UnOp UnOp;
 typedef struct FunctionCall FunctionCall;
@@ -34,6 +50,8 @@ struct Expression {
     ArrayOrStructLiteral *arrayOrStruct;
   };
   ExpressionType type;
+  // index of what the checker found out about the expression, in Checker::expressionTypes. 0 until checked
+  uint32_t annotation{0};
   Expression();
   explicit Expression(Token);
   Expression(const Expression&);
@@ -42,12 +60,8 @@ struct Expression {
   Expression deepCopy(NodeMemPool&);
 };
 
-struct ExpressionList {
-  Expression curr;
-  ExpressionList *next;
-  ExpressionList();
-  ExpressionList deepCopy(NodeMemPool&);
-};
+// expressionList:= expression , expressionList | expression | nothing
+using ExpressionList = NodeSpan<Expression>;
 
 typedef struct ControlFlowStatement ControlFlowStatement;
 typedef struct Scope Scope;
@@ -60,9 +74,11 @@ enum class StatementType: uint8_t {
   SCOPE,
   VARIABLE_DEC,
   KEYWORD,
+  ERROR,
 };
 
 // statement:=  expression; | controlFlowStatement | scope | varDec | nothing
+// a statement that failed to parse is kept as an ERROR statement holding its first token
 struct Statement {
   union {
     Expression *expression;
@@ -70,6 +86,7 @@ struct Statement {
     Scope *scope;
     VariableDec *varDec;
     Token keyword;
+    Token errorStart;
   };
   StatementType type;
   Statement();
@@ -85,6 +102,9 @@ struct Statement {
 //                     | typeQualifier ptr indirectionTypeList
 //                     // | typeQualifier [number | nothing] indirectionTypeList ignore arrays for now
 //                     | typeQualifier ref
+// index of a type in the checker's TypeTable
+using TypeId = uint32_t;
+
 struct TokenList {
   Token token{0,0,TokenType::NOTHING};
   TokenList *next{nullptr};
@@ -103,6 +123,7 @@ struct TokenList {
 struct VariableDec {
   TokenList type{};
   Token name;
+  TypeId typeId{0}; // set by the checker once the type is validated
   Expression *initialAssignment{nullptr};
   VariableDec() = delete;
   explicit VariableDec(const Token&);
@@ -114,14 +135,7 @@ struct VariableDec {
 };
 
 // statementList:= statement statementList | nothing
-struct StatementList {
-  Statement curr{};
-  StatementList *next{nullptr};
-  StatementList() = default;
-  StatementList(const StatementList &) = default;
-  StatementList& operator=(const StatementList &) = default;
-  StatementList deepCopy(NodeMemPool&);
-};
+using StatementList = NodeSpan<Statement>;
 
 // scope:= { statementList }
 struct Scope {
@@ -309,6 +323,7 @@ struct FunctionDec {
   Scope body{};
   TokenList returnType{};
   Token name{0,0,TokenType::NOTHING};
+  TypeId returnTypeId{0}; // set by the checker once the type is validated
   FunctionDec() = default;
   explicit FunctionDec(const Token&);
   FunctionDec(const FunctionDec&) = default;
@@ -324,20 +339,22 @@ enum class StructDecType: uint8_t {
   VAR,
 };
 
-// structDecList:= varDec ; decList | functionDec decList | nothing
-struct StructDecList {
+// structMember:= varDec ; | functionDec
+struct StructMember {
   union {
     VariableDec *varDec;
     FunctionDec *funcDec;
   };
-  StructDecList *next{nullptr};
   StructDecType type{StructDecType::NONE};
-  StructDecList();
-  StructDecList(const StructDecList&);
-  StructDecList& operator=(const StructDecList&);
-  StructDecList deepCopy(NodeMemPool&);
+  StructMember();
+  StructMember(const StructMember&);
+  StructMember& operator=(const StructMember&);
+  StructMember deepCopy(NodeMemPool&);
 };
 
+// structDecList:= structMember structDecList | nothing
+using StructDecList = NodeSpan<StructMember>;
+
 // structDec:= struct identifier { structDecList }
 struct StructDec {
   StructDecList decs{};
@@ -378,7 +395,6 @@ struct TemplateDec {
   TemplateDec();
   void prettyPrint(Tokenizer&, std::string&, uint32_t);
   void prettyPrintDefinition(Tokenizer&, std::string&);
-  GeneralDec *deepCopy(NodeMemPool&, Token);
 };
 
 //templateCreation:= create identifier [ identifierList ] as identifier ;
@@ -420,26 +436,18 @@ struct GeneralDec {
     TemplateCreation *tempCreate;
     IncludeDec *includeDec;
   };
-  uint32_t tokenizerIndex{0};
   GeneralDecType type{GeneralDecType::NOTHING};
   GeneralDec();
+  uint32_t location() const;
   void prettyPrint(std::vector<Tokenizer>&, std::string&);
   void prettyPrintDefinition(std::vector<Tokenizer>&, std::string&);
   GeneralDec *deepCopy(NodeMemPool&);
 };
 
-// globalDecList:= globalDec globalDecList | nothing
-struct GeneralDecList {
-  GeneralDec curr{};
-  GeneralDecList *next{nullptr};
-  GeneralDecList() = default;
-  void prettyPrint(std::vector<Tokenizer>&, std::string&);
-  GeneralDec *deepCopy(NodeMemPool&);
-};
-
-// program:= globalDecList
+// program:= globalDec program | nothing
 struct Program {
-  GeneralDecList decs{};
+  // pointers to the global declarations, in source order
+  std::vector<GeneralDec *> decs;
   Program() = default;
   void prettyPrint(std::vector<Tokenizer>&, std::string&);
 };
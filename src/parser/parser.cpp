@@ -1,28 +1,110 @@
 #include "parser.hpp"
+#include <algorithm>
+#include <array>
 
-Unexpected::Unexpected(const Token& token, uint32_t tkIndex): token{token}, tkIndex{tkIndex} {}
+Unexpected::Unexpected(const Token& token): token{token} {}
 std::string Unexpected::getErrorMessage(std::vector<Tokenizer>& tks) {
-  auto& tk = tks[tkIndex];
+  auto& tk = tokenizerAt(tks, token.position);
   TokenPositionInfo posInfo = tk.getTokenPositionInfo(token);
   std::string message = tk.filePath + ':' + std::to_string(posInfo.lineNum) + ':' + std::to_string(posInfo.linePos) + '\n';
   return message + "Unexpected Token: " + tk.extractToken(token) + "\n\n";
 }
 
-Expected::Expected(ExpectedType exType, const Token& token, uint32_t tkIndex): tokenWhereExpected{token}, tkIndex{tkIndex}, expectedTokenType{TokenType::NOTHING}, expectedType{exType} {}
-Expected::Expected(ExpectedType exType, const Token& token, TokenType tkType, uint32_t tkIndex): tokenWhereExpected{token}, tkIndex{tkIndex}, expectedTokenType{tkType}, expectedType{exType} {}
+Expected::Expected(ExpectedType exType, const Token& token): tokenWhereExpected{token}, expectedTokenType{TokenType::NOTHING}, expectedType{exType} {}
+Expected::Expected(ExpectedType exType, const Token& token, TokenType tkType): tokenWhereExpected{token}, expectedTokenType{tkType}, expectedType{exType} {}
 std::string Expected::getErrorMessage(std::vector<Tokenizer>& tks) {
-  auto& tk = tks[tkIndex];
+  auto& tk = tokenizerAt(tks, tokenWhereExpected.position);
   TokenPositionInfo posInfo = tk.getTokenPositionInfo(tokenWhereExpected);
   std::string message = tk.filePath + ':' + std::to_string(posInfo.lineNum) + ':' + std::to_string(posInfo.linePos) + '\n';
   if (expectedType == ExpectedType::EXPRESSION) {
     return message + "Expected Expression\n\n";
   }
   if (expectedType == ExpectedType::TOKEN) {
-    return message + "Expected Token: " + typeToString.at(expectedTokenType) + "\n\n";
+    auto name = typeToString.find(expectedTokenType);
+    if (name == typeToString.end()) {
+      return message + "Expected Token\n\n";
+    }
+    return message + "Expected Token: " + name->second + "\n\n";
   }
   return message + "\n\n";
 }
 
+NestingTooDeep::NestingTooDeep(const Token& token, uint32_t limit): token{token}, limit{limit} {}
+std::string NestingTooDeep::getErrorMessage(std::vector<Tokenizer>& tks) {
+  auto& tk = tokenizerAt(tks, token.position);
+  TokenPositionInfo posInfo = tk.getTokenPositionInfo(token);
+  std::string message = tk.filePath + ':' + std::to_string(posInfo.lineNum) + ':' + std::to_string(posInfo.linePos) + '\n';
+  return message + "Nesting too deep, maximum depth is " + std::to_string(limit) + "\n\n";
+}
+
+/**
+ * Where an error is sorted to. A token that was never set, such as errorToken before any expression error,
+ * has no location, so its errors go after the ones that do
+*/
+static uint64_t errorLocation(const Token& token) {
+  if (token.position == 0 && token.length == 0 && token.type == TokenType::NOTHING) {
+    return UINT64_MAX;
+  }
+  return token.position;
+}
+
+/**
+ * Gets the messages of every syntax error, merged into source order
+*/
+std::string Parser::getErrorMessages(std::vector<Tokenizer>& tks) {
+  std::vector<std::pair<uint64_t, std::string>> messages;
+  messages.reserve(expected.size() + unexpected.size() + nestingTooDeep.size());
+  for (auto& error : expected) {
+    messages.emplace_back(errorLocation(error.tokenWhereExpected), error.getErrorMessage(tks));
+  }
+  for (auto& error : unexpected) {
+    messages.emplace_back(errorLocation(error.token), error.getErrorMessage(tks));
+  }
+  for (auto& error : nestingTooDeep) {
+    messages.emplace_back(errorLocation(error.token), error.getErrorMessage(tks));
+  }
+  std::stable_sort(messages.begin(), messages.end(), [](const auto& a, const auto& b) {
+    return a.first < b.first;
+  });
+  std::string output;
+  for (auto& message : messages) {
+    output += message.second;
+  }
+  return output;
+}
+
+/**
+ * Increments the parser nesting depth for the lifetime of a recursive parse call
+ * Unary operators in a row add a level each with deeper, since each one puts its operand one level further down the tree.
+ * Binary operators don't: the parser builds operator chains in a loop, and chains of the same precedence lean left,
+ * so later passes walk them in a loop too
+*/
+struct NestingGuard {
+  uint32_t &depth;
+  uint32_t levels{1};
+  explicit NestingGuard(uint32_t &depth): depth{depth} { ++depth; }
+  NestingGuard(const NestingGuard&) = delete;
+  ~NestingGuard() { depth -= levels; }
+  void deeper() { ++depth; ++levels; }
+  // drops the levels added with deeper, once the operand of the unary operators is parsed
+  void shallower() { depth -= levels - 1; levels = 1; }
+};
+
+/**
+ * Marks where a node's children start in a parser scratch buffer. Children are appended while the node is parsed,
+ * copied into the memory pool as one span with commit, and dropped from the buffer when the guard goes out of scope.
+ * Nested nodes append above the mark and are gone again before the outer node continues
+*/
+template<typename T>
+struct ScratchGuard {
+  std::vector<T> &scratch;
+  const size_t start;
+  explicit ScratchGuard(std::vector<T> &scratch): scratch{scratch}, start{scratch.size()} {}
+  ScratchGuard(const ScratchGuard&) = delete;
+  ~ScratchGuard() { scratch.erase(scratch.begin() + start, scratch.end()); }
+  NodeSpan<T> commit(NodeMemPool &memPool) { return memPool.makeSpan(scratch.data() + start, scratch.size() - start); }
+};
+
 // TokenType::NEGATIVE is the "largest" operator token type with an enum value of 82, hence size 83
 uint8_t operatorPrecedence [83]{};
 __attribute__((constructor))
@@ -70,7 +152,7 @@ void initializeOperatorPrecedence() {
 }
 
 Parser::Parser(Tokenizer& tokenizer, NodeMemPool& memPool):
-  tokenizer{&tokenizer}, memPool{memPool}, errorToken{0,0,TokenType::NOTHING} {}
+  tokenizer{&tokenizer}, memPool{memPool}, current{memPool.makeGeneralDec()}, errorToken{0,0,TokenType::NOTHING} {}
 
 Parser::~Parser() {
   memPool.reset();
@@ -80,192 +162,286 @@ void Parser::swapTokenizer(Tokenizer& nextTokenizer) {
   tokenizer = &nextTokenizer;
 }
 
+/**
+ * Reports an error if the current nesting depth is over the limit
+ * \param token the token where the limit was exceeded
+ * \returns true if parsing can go deeper
+*/
+bool Parser::checkNestingDepth(const Token& token) {
+  if (nestingDepth <= maxNestingDepth) {
+    return true;
+  }
+  nestingTooDeep.emplace_back(token, maxNestingDepth);
+  return false;
+}
+
 /**
  * Parses the entire tokenizer ouput
+ * Recovers from syntax errors so that all of them are reported
+ * \returns true if there were no syntax errors
 */
 bool Parser::parse() {
   Token token = tokenizer->peekNext();
   while (token.type != TokenType::END_OF_FILE) {
     if (!parseNext()) {
-      return false;
+      synchronizeGlobal();
     }
     token = tokenizer->peekNext();
   }
-  globalPrev->next = nullptr;
-  return true;
+  return expected.empty() && unexpected.empty() && nestingTooDeep.empty();
+}
+
+/**
+ * Panic mode recovery for a failed general declaration.
+ * Skips tokens up to and including the next semicolon or close brace outside of a block,
+ * or up to the next keyword that starts a general declaration
+*/
+void Parser::synchronizeGlobal() {
+  uint32_t braceDepth = 0;
+  for (Token token = tokenizer->peekNext(); token.type != TokenType::END_OF_FILE; token = tokenizer->peekNext()) {
+    if (braceDepth == 0 && isGlobalDecStart(token.type)) {
+      return;
+    }
+    tokenizer->consumePeek();
+    if (token.type == TokenType::OPEN_BRACE) {
+      ++braceDepth;
+    } else if (token.type == TokenType::CLOSE_BRACE) {
+      if (braceDepth <= 1) {
+        return;
+      }
+      --braceDepth;
+    } else if (token.type == TokenType::SEMICOLON && braceDepth == 0) {
+      return;
+    }
+  }
+}
+
+/**
+ * Panic mode recovery for a failed statement within a scope, or a failed member within a struct.
+ * Skips tokens up to and including the next semicolon, or the close brace of a block opened while skipping.
+ * Stops before the close brace of the enclosing scope
+ * \param inStruct true when recovering a struct member. func then starts the next member instead of a general declaration
+ * \returns false if the enclosing scope cannot be recovered (end of file or start of a general declaration was reached)
+*/
+bool Parser::synchronizeStatement(bool inStruct) {
+  uint32_t braceDepth = 0;
+  for (Token token = tokenizer->peekNext(); token.type != TokenType::END_OF_FILE; token = tokenizer->peekNext()) {
+    if (inStruct && token.type == TokenType::FUNC && braceDepth == 0) {
+      return true;
+    }
+    if (isGlobalDecStart(token.type)) {
+      return false;
+    }
+    if (token.type == TokenType::CLOSE_BRACE && braceDepth == 0) {
+      return true;
+    }
+    tokenizer->consumePeek();
+    if (token.type == TokenType::OPEN_BRACE) {
+      ++braceDepth;
+    } else if (token.type == TokenType::CLOSE_BRACE) {
+      if (--braceDepth == 0) {
+        return true;
+      }
+    } else if (token.type == TokenType::SEMICOLON && braceDepth == 0) {
+      return true;
+    }
+  }
+  return false;
 }
 
 /**
- * Parses the next general declaration
- * \returns a pointer to the declaration
+ * Parses the next general declaration, passing it to onGeneralDec if set
+ * Nodes allocated for a declaration that fails to parse are given back to the pool
+ * \returns a pointer to the declaration, or nullptr on a syntax error
 */
 GeneralDec* Parser::parseNext() {
+  NodeMemPool::Checkpoint checkpoint{memPool};
+  GeneralDec *dec = parseGeneralDec();
+  if (!dec) {
+    checkpoint.rollback();
+    // current is reused for the next declaration. left as is, the failed declaration's type
+    // would be returned again at the end of the file, and it would refer to the nodes given back
+    current->type = GeneralDecType::NOTHING;
+    current->tempDec = nullptr;
+  }
+  return dec;
+}
+
+GeneralDec* Parser::parseGeneralDec() {
   Token token = tokenizer->tokenizeNext();
   if (token.type == TokenType::FUNC) {
-    globalList->curr.type = GeneralDecType::FUNCTION;
-    globalList->curr.funcDec = memPool.makeFunctionDec();
-    if (!parseFunction(*globalList->curr.funcDec)) {
+    current->type = GeneralDecType::FUNCTION;
+    current->funcDec = memPool.makeFunctionDec();
+    if (!parseFunction(*current->funcDec)) {
       return nullptr;
     }
   }
   else if (token.type == TokenType::STRUCT) {
-    globalList->curr.type = GeneralDecType::STRUCT;
-    globalList->curr.structDec = memPool.makeStructDec();
-    if (!parseStruct(*globalList->curr.structDec)) {
+    current->type = GeneralDecType::STRUCT;
+    current->structDec = memPool.makeStructDec();
+    if (!parseStruct(*current->structDec)) {
       return nullptr;
     }
   }
   else if (token.type == TokenType::TEMPLATE) {
-    globalList->curr.type = GeneralDecType::TEMPLATE;
-    globalList->curr.tempDec = memPool.makeTemplateDec();
-    if (!parseTemplate(*globalList->curr.tempDec)) {
+    current->type = GeneralDecType::TEMPLATE;
+    current->tempDec = memPool.makeTemplateDec();
+    if (!parseTemplate(*current->tempDec)) {
       return nullptr;
     }
   }
   else if (token.type == TokenType::IDENTIFIER) {
     if (tokenizer->tokenizeNext().type == TokenType::COLON) {
-      globalList->curr.type = GeneralDecType::VARIABLE;
-      globalList->curr.varDec = memPool.makeVariableDec(VariableDec{token});
-      ParseStatementErrorType errorType = parseVariableDec(*globalList->curr.varDec);
+      current->type = GeneralDecType::VARIABLE;
+      current->varDec = memPool.make<VariableDec>(token);
+      ParseStatementErrorType errorType = parseVariableDec(*current->varDec);
       if (errorType != ParseStatementErrorType::NONE) {
         return nullptr;
       }
       if (tokenizer->tokenizeNext().type != TokenType::SEMICOLON) {
-        expected.emplace_back(ExpectedType::TOKEN, tokenizer->peeked, TokenType::SEMICOLON, tokenizer->tokenizerIndex);
+        expected.emplace_back(ExpectedType::TOKEN, tokenizer->peeked, TokenType::SEMICOLON);
         return nullptr;
       }
     }
     else {
-      expected.emplace_back(ExpectedType::TOKEN, tokenizer->peeked, TokenType::COLON, tokenizer->tokenizerIndex);
+      expected.emplace_back(ExpectedType::TOKEN, tokenizer->peeked, TokenType::COLON);
       return nullptr;
     }
   }
   else if (token.type == TokenType::CREATE) {
-    globalList->curr.type = GeneralDecType::TEMPLATE_CREATE;
-    globalList->curr.tempCreate = memPool.makeTemplateCreation();
+    current->type = GeneralDecType::TEMPLATE_CREATE;
+    current->tempCreate = memPool.makeTemplateCreation();
     token = tokenizer->tokenizeNext();
     if (token.type != TokenType::IDENTIFIER) {
-      expected.emplace_back(ExpectedType::TOKEN, token, TokenType::IDENTIFIER, tokenizer->tokenizerIndex);
+      expected.emplace_back(ExpectedType::TOKEN, token, TokenType::IDENTIFIER);
       return nullptr;
     }
-    globalList->curr.tempCreate->templateName = token;
+    current->tempCreate->templateName = token;
     if (tokenizer->tokenizeNext().type != TokenType::OPEN_BRACKET) {
-      expected.emplace_back(ExpectedType::TOKEN, tokenizer->peeked, TokenType::OPEN_BRACKET, tokenizer->tokenizerIndex);
+      expected.emplace_back(ExpectedType::TOKEN, tokenizer->peeked, TokenType::OPEN_BRACKET);
       return nullptr;
     }
     token = tokenizer->tokenizeNext();
     if (token.type != TokenType::IDENTIFIER && !isBuiltInType(token.type)) {
-      expected.emplace_back(ExpectedType::TOKEN, token, TokenType::TYPE, tokenizer->tokenizerIndex);
+      expected.emplace_back(ExpectedType::TOKEN, token, TokenType::TYPE);
       return nullptr;
     }
-    globalList->curr.tempCreate->templateTypes.token = token;
-    TokenList *tokenPrev = &globalList->curr.tempCreate->templateTypes;
-    tokenPrev->next = memPool.makeTokenList();
-    TokenList *tkList = tokenPrev->next;
+    current->tempCreate->templateTypes.token = token;
+    TokenList *tkList = &current->tempCreate->templateTypes;
     while (tokenizer->peekNext().type == TokenType::COMMA) {
       tokenizer->consumePeek();
       token = tokenizer->tokenizeNext();
       if (token.type != TokenType::IDENTIFIER && !isBuiltInType(token.type)) {
-        expected.emplace_back(ExpectedType::TOKEN, token, TokenType::TYPE, tokenizer->tokenizerIndex);
+        expected.emplace_back(ExpectedType::TOKEN, token, TokenType::TYPE);
         return nullptr;
       }
-      tokenPrev = tkList;
-      tkList->token = token;
       tkList->next = memPool.makeTokenList();
       tkList = tkList->next;
+      tkList->token = token;
     }
-    tokenPrev->next = nullptr;
-    memPool.release(tkList);
     if (tokenizer->tokenizeNext().type != TokenType::CLOSE_BRACKET) {
-      expected.emplace_back(ExpectedType::TOKEN, tokenizer->peeked, TokenType::CLOSE_BRACKET, tokenizer->tokenizerIndex);
+      expected.emplace_back(ExpectedType::TOKEN, tokenizer->peeked, TokenType::CLOSE_BRACKET);
       return nullptr;
     }
     if (tokenizer->tokenizeNext().type != TokenType::AS) {
-      expected.emplace_back(ExpectedType::TOKEN, tokenizer->peeked, TokenType::AS, tokenizer->tokenizerIndex);
+      expected.emplace_back(ExpectedType::TOKEN, tokenizer->peeked, TokenType::AS);
       return nullptr;
     }
     token = tokenizer->tokenizeNext();
     if (token.type != TokenType::IDENTIFIER) {
-      expected.emplace_back(ExpectedType::TOKEN, token, TokenType::IDENTIFIER, tokenizer->tokenizerIndex);
+      expected.emplace_back(ExpectedType::TOKEN, token, TokenType::IDENTIFIER);
       return nullptr;
     }
-    globalList->curr.tempCreate->typeName = token;
+    current->tempCreate->typeName = token;
     if (tokenizer->tokenizeNext().type != TokenType::SEMICOLON) {
-      expected.emplace_back(ExpectedType::TOKEN, token, TokenType::SEMICOLON, tokenizer->tokenizerIndex);
+      expected.emplace_back(ExpectedType::TOKEN, token, TokenType::SEMICOLON);
       return nullptr;
     }
   }
   else if (token.type == TokenType::INCLUDE) {
-    globalList->curr.type = GeneralDecType::INCLUDE_DEC;
-    globalList->curr.includeDec = memPool.makeIncludeDec();
+    current->type = GeneralDecType::INCLUDE_DEC;
+    current->includeDec = memPool.makeIncludeDec();
     token = tokenizer->tokenizeNext();
     if (token.type != TokenType::STRING_LITERAL) {
-      expected.emplace_back(ExpectedType::TOKEN, token, TokenType::STRING_LITERAL, tokenizer->tokenizerIndex);
+      expected.emplace_back(ExpectedType::TOKEN, token, TokenType::STRING_LITERAL);
       return nullptr;
     }
-    globalList->curr.includeDec->file = token;
+    current->includeDec->file = token;
   }
   else if (token.type == TokenType::END_OF_FILE) {
-    return &globalList->curr;
+    return current;
   }
   else {
-    unexpected.emplace_back(token, tokenizer->tokenizerIndex);
+    unexpected.emplace_back(token);
     return nullptr;
   }
-  globalPrev = globalList;
-  globalList->next = memPool.makeGeneralDecList();
-  globalList = globalList->next;
-  return &globalPrev->curr;
+  return appendGeneralDec();
+}
+
+/**
+ * Commits the declaration built in current to the program and starts a new one.
+ * Used by parseNext and by callers that build declarations without parsing them, such as precompiled modules
+ * \returns the committed declaration
+*/
+GeneralDec* Parser::appendGeneralDec() {
+  GeneralDec *dec = current;
+  program.decs.push_back(dec);
+  current = memPool.makeGeneralDec();
+  if (onGeneralDec) {
+    onGeneralDec(*dec);
+  }
+  return dec;
 }
 
 bool Parser::parseFunction(FunctionDec& dec) {
   Token name = tokenizer->peekNext();
   if (name.type != TokenType::IDENTIFIER) {
-    expected.emplace_back(ExpectedType::TOKEN, name, TokenType::IDENTIFIER, tokenizer->tokenizerIndex);
+    expected.emplace_back(ExpectedType::TOKEN, name, TokenType::IDENTIFIER);
     return false;
   }
   // consume identifier
   tokenizer->consumePeek();
   dec.name = name;
   if (tokenizer->peekNext().type != TokenType::OPEN_PAREN) {
-    expected.emplace_back(ExpectedType::TOKEN, tokenizer->peeked, TokenType::OPEN_PAREN, tokenizer->tokenizerIndex);
+    expected.emplace_back(ExpectedType::TOKEN, tokenizer->peeked, TokenType::OPEN_PAREN);
     return false;
   }
   // consume open paren
   tokenizer->consumePeek();
   if (tokenizer->peekNext().type != TokenType::CLOSE_PAREN) {
-    StatementList *paramList = &dec.params;
+    ScratchGuard<Statement> params{statementScratch};
     while (true) {
       Token nextToken = tokenizer->peekNext();
       if (nextToken.type != TokenType::IDENTIFIER) {
-        expected.emplace_back(ExpectedType::TOKEN, nextToken, TokenType::IDENTIFIER, tokenizer->tokenizerIndex);
+        expected.emplace_back(ExpectedType::TOKEN, nextToken, TokenType::IDENTIFIER);
         return false;
       }
       // consume identifier
       tokenizer->consumePeek();
       if (tokenizer->peekNext().type != TokenType::COLON) {
-        expected.emplace_back(ExpectedType::TOKEN, tokenizer->peeked, TokenType::COLON, tokenizer->tokenizerIndex);
+        expected.emplace_back(ExpectedType::TOKEN, tokenizer->peeked, TokenType::COLON);
         return false;
       }
       // consume colon
       tokenizer->consumePeek();
-      paramList->curr.type = StatementType::VARIABLE_DEC;
-      paramList->curr.varDec = memPool.makeVariableDec(VariableDec{nextToken});
-      ParseStatementErrorType errorType = parseVariableDec(*paramList->curr.varDec);
+      Statement param;
+      param.type = StatementType::VARIABLE_DEC;
+      param.varDec = memPool.make<VariableDec>(nextToken);
+      ParseStatementErrorType errorType = parseVariableDec(*param.varDec);
       if (errorType != ParseStatementErrorType::NONE) {
         if (errorType == ParseStatementErrorType::EXPRESSION_AFTER_EXPRESSION) {
-          expected.emplace_back(ExpectedType::TOKEN, errorToken, TokenType::COMMA, tokenizer->tokenizerIndex);
+          expected.emplace_back(ExpectedType::TOKEN, errorToken, TokenType::COMMA);
         }
         return false;
       }
+      params.scratch.push_back(param);
       if (tokenizer->peekNext().type == TokenType::COMMA) {
         tokenizer->consumePeek();
-        paramList->next = memPool.makeStatementList();
-        paramList = paramList->next;
       } else if (tokenizer->peeked.type == TokenType::CLOSE_PAREN) {
+        dec.params = params.commit(memPool);
         break;
       } else {
-        expected.emplace_back(ExpectedType::TOKEN, tokenizer->peeked, TokenType::CLOSE_PAREN, tokenizer->tokenizerIndex);
+        expected.emplace_back(ExpectedType::TOKEN, tokenizer->peeked, TokenType::CLOSE_PAREN);
         return false;
       }
     }
@@ -274,7 +450,7 @@ bool Parser::parseFunction(FunctionDec& dec) {
   tokenizer->consumePeek();
   // get return type
   if (tokenizer->peekNext().type != TokenType::COLON) {
-    expected.emplace_back(ExpectedType::TOKEN, tokenizer->peeked, TokenType::COLON, tokenizer->tokenizerIndex);
+    expected.emplace_back(ExpectedType::TOKEN, tokenizer->peeked, TokenType::COLON);
     return false;
   }
   tokenizer->consumePeek();
@@ -282,7 +458,7 @@ bool Parser::parseFunction(FunctionDec& dec) {
     return false;
   }
   if (tokenizer->peekNext().type != TokenType::OPEN_BRACE) {
-    expected.emplace_back(ExpectedType::TOKEN, tokenizer->peeked, TokenType::OPEN_BRACE, tokenizer->tokenizerIndex);
+    expected.emplace_back(ExpectedType::TOKEN, tokenizer->peeked, TokenType::OPEN_BRACE);
     return false;
   }
   tokenizer->consumePeek();
@@ -296,79 +472,90 @@ bool Parser::parseFunction(FunctionDec& dec) {
 bool Parser::parseStruct(StructDec& dec) {
   Token token = tokenizer->peekNext();
   if (token.type != TokenType::IDENTIFIER) {
-    expected.emplace_back(ExpectedType::TOKEN, token, TokenType::IDENTIFIER, tokenizer->tokenizerIndex);
+    expected.emplace_back(ExpectedType::TOKEN, token, TokenType::IDENTIFIER);
     return false;
   }
   tokenizer->consumePeek();
   dec.name = token;
   if (tokenizer->peekNext().type != TokenType::OPEN_BRACE) {
-    expected.emplace_back(ExpectedType::TOKEN, tokenizer->peeked, TokenType::OPEN_BRACE, tokenizer->tokenizerIndex);
+    expected.emplace_back(ExpectedType::TOKEN, tokenizer->peeked, TokenType::OPEN_BRACE);
     return false;
   }
   tokenizer->consumePeek();
   token = tokenizer->peekNext();
-  StructDecList *prev = nullptr;
-  StructDecList *list = &dec.decs;
+  ScratchGuard<StructMember> members{memberScratch};
   while (true) {
+    StructMember member;
     if (token.type == TokenType::IDENTIFIER) {
       tokenizer->consumePeek();
       if (tokenizer->peekNext().type == TokenType::COLON) {
         tokenizer->consumePeek();
-        list->type = StructDecType::VAR;
-        list->varDec = memPool.makeVariableDec(VariableDec{token});
-        ParseStatementErrorType errorType = parseVariableDec(*list->varDec);
+        member.type = StructDecType::VAR;
+        member.varDec = memPool.make<VariableDec>(token);
+        ParseStatementErrorType errorType = parseVariableDec(*member.varDec);
         if (errorType != ParseStatementErrorType::NONE) {
           if (errorType == ParseStatementErrorType::EXPRESSION_AFTER_EXPRESSION) {
-            expected.emplace_back(ExpectedType::TOKEN, errorToken, TokenType::SEMICOLON, tokenizer->tokenizerIndex);
+            expected.emplace_back(ExpectedType::TOKEN, errorToken, TokenType::SEMICOLON);
+          }
+          if (!synchronizeStatement(true)) {
+            return false;
           }
-          return false;
         }
-        if (tokenizer->peekNext().type != TokenType::SEMICOLON) {
-          expected.emplace_back(ExpectedType::TOKEN, tokenizer->peeked, TokenType::SEMICOLON, tokenizer->tokenizerIndex);
-          return false;
+        else if (tokenizer->peekNext().type != TokenType::SEMICOLON) {
+          expected.emplace_back(ExpectedType::TOKEN, tokenizer->peeked, TokenType::SEMICOLON);
+          if (!synchronizeStatement(true)) {
+            return false;
+          }
+        }
+        else {
+          tokenizer->consumePeek();
         }
-        tokenizer->consumePeek();
       }
       else {
-        expected.emplace_back(ExpectedType::TOKEN, tokenizer->peeked, TokenType::COLON, tokenizer->tokenizerIndex);
-        return false;
+        expected.emplace_back(ExpectedType::TOKEN, tokenizer->peeked, TokenType::COLON);
+        // member variables are recovered like statements
+        member.type = StructDecType::VAR;
+        member.varDec = memPool.make<VariableDec>(token);
+        if (!synchronizeStatement(true)) {
+          return false;
+        }
       }
     }
     else if (token.type == TokenType::FUNC) {
       tokenizer->consumePeek();
-      list->type = StructDecType::FUNC;
-      list->funcDec = memPool.makeFunctionDec();
-      if (!parseFunction(*list->funcDec)) {
-        return false;
+      member.type = StructDecType::FUNC;
+      member.funcDec = memPool.makeFunctionDec();
+      if (!parseFunction(*member.funcDec)) {
+        // the rest of the struct is still parsed, the failed function is left out
+        if (!synchronizeStatement(true)) {
+          return false;
+        }
+        token = tokenizer->peekNext();
+        continue;
       }
     }
     else if (token.type == TokenType::CLOSE_BRACE) {
       tokenizer->consumePeek();
-      if (prev) {
-        prev->next = nullptr;
-        memPool.release(list);
-      }
+      dec.decs = members.commit(memPool);
       return true;
     }
     else {
       if (token.type == TokenType::END_OF_FILE) {
-        expected.emplace_back(ExpectedType::TOKEN, token, TokenType::CLOSE_BRACE, tokenizer->tokenizerIndex);
+        expected.emplace_back(ExpectedType::TOKEN, token, TokenType::CLOSE_BRACE);
       } else {
-        unexpected.emplace_back(token, tokenizer->tokenizerIndex);
+        unexpected.emplace_back(token);
       }
       return false;
     }
+    members.scratch.push_back(member);
     token = tokenizer->peekNext();
-    prev = list;
-    list->next = memPool.makeStructDecList();
-    list = list->next;
   }
 }
 
 bool Parser::parseTemplate(TemplateDec& dec) {
   Token token = tokenizer->peekNext();
   if (token.type != TokenType::OPEN_BRACKET) {
-    expected.emplace_back(ExpectedType::TOKEN, token, TokenType::OPEN_BRACKET, tokenizer->tokenizerIndex);
+    expected.emplace_back(ExpectedType::TOKEN, token, TokenType::OPEN_BRACKET);
     return false;
   }
   tokenizer->consumePeek();
@@ -376,7 +563,7 @@ bool Parser::parseTemplate(TemplateDec& dec) {
   token = tokenizer->peekNext();
   while (true) {
     if (token.type != TokenType::IDENTIFIER) {
-      expected.emplace_back(ExpectedType::TOKEN, token, TokenType::IDENTIFIER, tokenizer->tokenizerIndex);
+      expected.emplace_back(ExpectedType::TOKEN, token, TokenType::IDENTIFIER);
       return false;
     }
     tokenizer->consumePeek();
@@ -386,7 +573,7 @@ bool Parser::parseTemplate(TemplateDec& dec) {
       break;
     }
     if (tokenizer->peeked.type != TokenType::COMMA) {
-      expected.emplace_back(ExpectedType::TOKEN, tokenizer->peeked, TokenType::COMMA, tokenizer->tokenizerIndex);
+      expected.emplace_back(ExpectedType::TOKEN, tokenizer->peeked, TokenType::COMMA);
       return false;
     }
     tokenizer->consumePeek();
@@ -404,7 +591,7 @@ bool Parser::parseTemplate(TemplateDec& dec) {
     dec.isStruct = false;
     return parseFunction(dec.funcDec);
   } else {
-    unexpected.emplace_back(token, tokenizer->tokenizerIndex);
+    unexpected.emplace_back(token);
     return false;
   }
 }
@@ -412,35 +599,68 @@ bool Parser::parseTemplate(TemplateDec& dec) {
 /**
  * parses a scope. the first open brace should be consumed before calling this function
  * consumes the final close brace, unless there was an error
+ * statements that fail to parse are replaced by ERROR statements and parsing continues after them
  * \returns one of ParseStatementErrorType::REPORTED and ParseStatementErrorType::NONE
 */
 ParseStatementErrorType Parser::parseScope(StatementList& statementList) {
-  StatementList* prev = nullptr;
-  StatementList* list = &statementList;
+  NestingGuard nesting{nestingDepth};
   Token token = tokenizer->peekNext();
+  if (!checkNestingDepth(token)) {
+    return ParseStatementErrorType::REPORTED;
+  }
+  ScratchGuard<Statement> statements{statementScratch};
+  // one checkpoint for the scope, each statement only takes a mark in it
+  NodeMemPool::Checkpoint checkpoint{memPool};
   while (token.type != TokenType::CLOSE_BRACE) {
     if (token.type == TokenType::END_OF_FILE) {
-      expected.emplace_back(ExpectedType::TOKEN, token, TokenType::CLOSE_BRACE, tokenizer->tokenizerIndex);
+      expected.emplace_back(ExpectedType::TOKEN, token, TokenType::CLOSE_BRACE);
       return ParseStatementErrorType::REPORTED;
     }
-    ParseStatementErrorType errorType = parseStatement(list->curr);
+    Statement statement;
+    const NodeMemPool::Checkpoint::Mark mark = checkpoint.mark();
+    ParseStatementErrorType errorType = parseStatement(statement);
     if (errorType != ParseStatementErrorType::NONE) {
-      return errorType;
+      checkpoint.rollback(mark);
+      if (!synchronizeStatement()) {
+        return ParseStatementErrorType::REPORTED;
+      }
+      statement.type = StatementType::ERROR;
+      statement.errorStart = token;
     }
-    prev = list;
-    list->next = memPool.makeStatementList();
-    list = list->next;
+    statements.scratch.push_back(statement);
     token = tokenizer->peekNext();
   }
   // consume close brace
   tokenizer->consumePeek();
-  if (prev) {
-    prev->next = nullptr;
-    memPool.release(list);
-  }
+  statementList = statements.commit(memPool);
   return ParseStatementErrorType::NONE;
 }
 
+/**
+ * Statement handlers, indexed by the type of the first token of the statement.
+ * Each handler is called with the first token peeked but not consumed
+*/
+using StatementParser = ParseStatementErrorType (Parser::*)(Statement&, Token);
+
+static std::array<StatementParser, 256> makeStatementParsers() {
+  std::array<StatementParser, 256> parsers;
+  for (uint32_t type = 0; type < parsers.size(); ++type) {
+    parsers[type] = notFirstOfExpression((TokenType)type) ? &Parser::parseUnexpectedStatement : &Parser::parseExpressionStatement;
+  }
+  parsers[(uint8_t)TokenType::IDENTIFIER] = &Parser::parseIdentifierLeadStatement;
+  parsers[(uint8_t)TokenType::IF] = &Parser::parseConditionalStatement;
+  parsers[(uint8_t)TokenType::WHILE] = &Parser::parseWhileLoop;
+  parsers[(uint8_t)TokenType::RETURN] = &Parser::parseReturnStatement;
+  parsers[(uint8_t)TokenType::FOR] = &Parser::parseForLoop;
+  parsers[(uint8_t)TokenType::SWITCH] = &Parser::parseSwitchStatement;
+  parsers[(uint8_t)TokenType::OPEN_BRACE] = &Parser::parseScopeStatement;
+  parsers[(uint8_t)TokenType::BREAK] = &Parser::parseKeywordStatement;
+  parsers[(uint8_t)TokenType::CONTINUE] = &Parser::parseKeywordStatement;
+  return parsers;
+}
+
+static const std::array<StatementParser, 256> statementParsers = makeStatementParsers();
+
 /**
  * parses a single statement within a scope
  * consumes the whole statement, unless there was an error
@@ -448,292 +668,352 @@ ParseStatementErrorType Parser::parseScope(StatementList& statementList) {
 */
 ParseStatementErrorType Parser::parseStatement(Statement &statement) {
   Token token = tokenizer->peekNext();
-  if (token.type == TokenType::IDENTIFIER) { // varDec or expression
+  return (this->*statementParsers[(uint8_t)token.type])(statement, token);
+}
+
+/**
+ * varDec or expression
+*/
+ParseStatementErrorType Parser::parseIdentifierLeadStatement(Statement& statement, Token token) {
+  tokenizer->consumePeek();
+  ParseStatementErrorType errorType = parseIdentifierStatement(statement, token);
+  if (errorType != ParseStatementErrorType::NONE) {
+    if (errorType == ParseStatementErrorType::EXPRESSION_AFTER_EXPRESSION) {
+      expected.emplace_back(ExpectedType::TOKEN, errorToken, TokenType::SEMICOLON);
+    } else if (errorType == ParseStatementErrorType::NOT_EXPRESSION) {
+      unexpected.emplace_back(errorToken);
+    }
+    return ParseStatementErrorType::REPORTED;
+  }
+  if (tokenizer->peekNext().type != TokenType::SEMICOLON) {
+    expected.emplace_back(ExpectedType::TOKEN, tokenizer->peeked, TokenType::SEMICOLON);
+    return ParseStatementErrorType::REPORTED;
+  }
+  tokenizer->consumePeek();
+  return ParseStatementErrorType::NONE;
+}
+
+/**
+ * if, elif and else chain
+*/
+ParseStatementErrorType Parser::parseConditionalStatement(Statement& statement, Token) {
+  statement.type = StatementType::CONTROL_FLOW;
+  statement.controlFlow = memPool.makeControlFlowStatement();
+  tokenizer->consumePeek();
+  statement.controlFlow->type = ControlFlowStatementType::CONDITIONAL_STATEMENT;
+  statement.controlFlow->conditional = memPool.makeConditionalStatement();
+  ConditionalStatement& cond = *statement.controlFlow->conditional;
+  if (parseIfStatement(cond.ifStatement) == ParseStatementErrorType::REPORTED) {
+    return ParseStatementErrorType::REPORTED;
+  }
+
+  ElifStatementList **curr = &cond.elifStatement;
+  while (tokenizer->peekNext().type == TokenType::ELIF) {
     tokenizer->consumePeek();
-    if (parseIdentifierStatement(statement, token) != ParseStatementErrorType::NONE) {
+    *curr = memPool.makeElifStatementList();
+    if (parseIfStatement((*curr)->elif) == ParseStatementErrorType::REPORTED) {
       return ParseStatementErrorType::REPORTED;
     }
-    if (tokenizer->peekNext().type != TokenType::SEMICOLON) {
-      expected.emplace_back(ExpectedType::TOKEN, tokenizer->peeked, TokenType::SEMICOLON, tokenizer->tokenizerIndex);
+    curr = &(*curr)->next;
+  }
+
+  if (tokenizer->peeked.type == TokenType::ELSE) {
+    tokenizer->consumePeek();
+    if (tokenizer->peekNext().type != TokenType::OPEN_BRACE) {
+      expected.emplace_back(ExpectedType::TOKEN, tokenizer->peeked, TokenType::OPEN_BRACE);
       return ParseStatementErrorType::REPORTED;
     }
     tokenizer->consumePeek();
-    return ParseStatementErrorType::NONE;
+
+    cond.elseStatement = memPool.makeScope();
+    ParseStatementErrorType errorType = parseScope(cond.elseStatement->scopeStatements);
+    if (errorType != ParseStatementErrorType::NONE) {
+      return ParseStatementErrorType::REPORTED;
+    }
   }
-  else if (isControlFlow(token.type)) {
-    statement.type = StatementType::CONTROL_FLOW;
-    statement.controlFlow = memPool.makeControlFlowStatement();
-    if (token.type == TokenType::IF) {
-      tokenizer->consumePeek();
-      statement.controlFlow->type = ControlFlowStatementType::CONDITIONAL_STATEMENT;
-      statement.controlFlow->conditional = memPool.makeConditionalStatement();
-      ConditionalStatement& cond = *statement.controlFlow->conditional;
-      if (parseIfStatement(cond.ifStatement) == ParseStatementErrorType::REPORTED) {
-        return ParseStatementErrorType::REPORTED;
-      }
+  return ParseStatementErrorType::NONE;
+}
 
-      ElifStatementList **curr = &cond.elifStatement;
-      while (tokenizer->peekNext().type == TokenType::ELIF) {
-        tokenizer->consumePeek();
-        *curr = memPool.makeElifStatementList();
-        if (parseIfStatement((*curr)->elif) == ParseStatementErrorType::REPORTED) {
-          return ParseStatementErrorType::REPORTED;
-        }
-        curr = &(*curr)->next;
+/**
+ * while loop
+*/
+ParseStatementErrorType Parser::parseWhileLoop(Statement& statement, Token) {
+  statement.type = StatementType::CONTROL_FLOW;
+  statement.controlFlow = memPool.makeControlFlowStatement();
+  tokenizer->consumePeek();
+  statement.controlFlow->type = ControlFlowStatementType::WHILE_LOOP;
+  statement.controlFlow->whileLoop = memPool.makeWhileLoop();
+  if (parseIfStatement(statement.controlFlow->whileLoop->statement) == ParseStatementErrorType::REPORTED) {
+    return ParseStatementErrorType::REPORTED;
+  }
+  return ParseStatementErrorType::NONE;
+}
+
+/**
+ * return statement, with an optional value
+*/
+ParseStatementErrorType Parser::parseReturnStatement(Statement& statement, Token) {
+  statement.type = StatementType::CONTROL_FLOW;
+  statement.controlFlow = memPool.makeControlFlowStatement();
+  tokenizer->consumePeek();
+  statement.controlFlow->type = ControlFlowStatementType::RETURN_STATEMENT;
+  statement.controlFlow->returnStatement = memPool.makeReturnStatement();
+  auto& returnValue = statement.controlFlow->returnStatement->returnValue;
+  if (tokenizer->peekNext().type == TokenType::OPEN_BRACKET) {
+    tokenizer->consumePeek();
+    returnValue.type = ExpressionType::ARRAY_OR_STRUCT_LITERAL;
+    returnValue.arrayOrStruct = memPool.makeArrayOrStruct();
+    if (parseArrayOrStructLiteral(*returnValue.arrayOrStruct) != ParseExpressionErrorType::NONE) {
+      return ParseStatementErrorType::REPORTED;
+    }
+    if (tokenizer->peekNext().type != TokenType::CLOSE_BRACKET) {
+      expected.emplace_back(ExpectedType::TOKEN, tokenizer->peeked, TokenType::CLOSE_BRACKET);
+      return ParseStatementErrorType::REPORTED;
+    }
+    tokenizer->consumePeek();
+  }
+  else if (tokenizer->peeked.type != TokenType::SEMICOLON) {
+    ParseExpressionErrorType errorType = parseExpression(returnValue);
+    if (errorType != ParseExpressionErrorType::NONE) {
+      if (errorType == ParseExpressionErrorType::NOT_EXPRESSION) {
+        expected.emplace_back(ExpectedType::EXPRESSION, errorToken);
+      } else if (errorType == ParseExpressionErrorType::EXPRESSION_AFTER_EXPRESSION) {
+        expected.emplace_back(ExpectedType::TOKEN, errorToken, TokenType::SEMICOLON);
       }
+      return ParseStatementErrorType::REPORTED;
+    }
+    if (tokenizer->peekNext().type != TokenType::SEMICOLON) {
+      expected.emplace_back(ExpectedType::TOKEN, tokenizer->peekNext(), TokenType::SEMICOLON);
+      return ParseStatementErrorType::REPORTED;
+    }
+  }
+  tokenizer->consumePeek();
+  return ParseStatementErrorType::NONE;
+}
 
-      if (tokenizer->peeked.type == TokenType::ELSE) {
-        tokenizer->consumePeek();
-        if (tokenizer->peekNext().type != TokenType::OPEN_BRACE) {
-          expected.emplace_back(ExpectedType::TOKEN, tokenizer->peeked, TokenType::OPEN_BRACE, tokenizer->tokenizerIndex);
-          return ParseStatementErrorType::REPORTED;
-        }
-        tokenizer->consumePeek();
+/**
+ * for loop
+*/
+ParseStatementErrorType Parser::parseForLoop(Statement& statement, Token) {
+  statement.type = StatementType::CONTROL_FLOW;
+  statement.controlFlow = memPool.makeControlFlowStatement();
+  tokenizer->consumePeek();
+  statement.controlFlow->type = ControlFlowStatementType::FOR_LOOP;
+  statement.controlFlow->forLoop = memPool.makeForLoop();
 
-        cond.elseStatement = memPool.makeScope();
-        ParseStatementErrorType errorType = parseScope(cond.elseStatement->scopeStatements);
-        if (errorType != ParseStatementErrorType::NONE) {
-          return ParseStatementErrorType::REPORTED;
-        }
+  auto& forLoop = statement.controlFlow->forLoop;
+  if (tokenizer->peekNext().type != TokenType::OPEN_PAREN) {
+    expected.emplace_back(ExpectedType::TOKEN, tokenizer->peeked, TokenType::OPEN_PAREN);
+    return ParseStatementErrorType::REPORTED;
+  }
+  // consume open paren
+  tokenizer->consumePeek();
+  Token next = tokenizer->peekNext();
+
+  // parse initialize statement. can be expression or varDec
+  if (next.type == TokenType::IDENTIFIER) {
+    // consume identifier
+    tokenizer->consumePeek();
+    ParseStatementErrorType errorType = parseIdentifierStatement(forLoop->initialize, next);
+    if (errorType != ParseStatementErrorType::NONE) {
+      if (errorType == ParseStatementErrorType::EXPRESSION_AFTER_EXPRESSION) {
+        expected.emplace_back(ExpectedType::TOKEN, errorToken, TokenType::SEMICOLON);
+      } else if (errorType == ParseStatementErrorType::NOT_EXPRESSION) {
+        unexpected.emplace_back(errorToken);
       }
+      return ParseStatementErrorType::REPORTED;
     }
-    else if (token.type == TokenType::WHILE) {
-      tokenizer->consumePeek();
-      statement.controlFlow->type = ControlFlowStatementType::WHILE_LOOP;
-      statement.controlFlow->whileLoop = memPool.makeWhileLoop();
-      if (parseIfStatement(statement.controlFlow->whileLoop->statement) == ParseStatementErrorType::REPORTED) {
-        return ParseStatementErrorType::REPORTED;
-      }
+    if (tokenizer->peekNext().type != TokenType::SEMICOLON) {
+      expected.emplace_back(ExpectedType::TOKEN, tokenizer->peeked, TokenType::SEMICOLON);
+      return ParseStatementErrorType::REPORTED;
     }
-    else if (token.type == TokenType::RETURN) {
-      tokenizer->consumePeek();
-      statement.controlFlow->type = ControlFlowStatementType::RETURN_STATEMENT;
-      statement.controlFlow->returnStatement = memPool.makeReturnStatement();
-      auto& returnValue = statement.controlFlow->returnStatement->returnValue;
-      if (tokenizer->peekNext().type == TokenType::OPEN_BRACKET) {
-        tokenizer->consumePeek();
-        returnValue.type = ExpressionType::ARRAY_OR_STRUCT_LITERAL;
-        returnValue.arrayOrStruct = memPool.makeArrayOrStruct();
-        ParseExpressionErrorType errorType = parseArrayOrStructLiteral(*returnValue.arrayOrStruct);
-        if (tokenizer->peekNext().type != TokenType::CLOSE_BRACKET) {
-          expected.emplace_back(ExpectedType::TOKEN, errorToken, TokenType::CLOSE_BRACKET, tokenizer->tokenizerIndex);
-          return ParseStatementErrorType::REPORTED;
-        }
-        tokenizer->consumePeek();
-        if (errorType != ParseExpressionErrorType::NONE) {
-          return ParseStatementErrorType::REPORTED;
-        }
-      }
-      else if (tokenizer->peeked.type != TokenType::SEMICOLON) {
-        ParseExpressionErrorType errorType = parseExpression(returnValue);
-        if (errorType != ParseExpressionErrorType::NONE) {
-          if (errorType == ParseExpressionErrorType::NOT_EXPRESSION) {
-            expected.emplace_back(ExpectedType::EXPRESSION, errorToken, tokenizer->tokenizerIndex);
-          } else if (errorType == ParseExpressionErrorType::EXPRESSION_AFTER_EXPRESSION) {
-            expected.emplace_back(ExpectedType::TOKEN, errorToken, TokenType::SEMICOLON, tokenizer->tokenizerIndex);
-          }
-          return ParseStatementErrorType::REPORTED;
-        }
-        if (tokenizer->peekNext().type != TokenType::SEMICOLON) {
-          expected.emplace_back(ExpectedType::TOKEN, tokenizer->peekNext(), TokenType::SEMICOLON, tokenizer->tokenizerIndex);
-          return ParseStatementErrorType::REPORTED;
-        }
+  } else if (next.type != TokenType::SEMICOLON) {
+    forLoop->initialize.type = StatementType::EXPRESSION;
+    forLoop->initialize.expression = memPool.makeExpression();
+    ParseExpressionErrorType errorType = parseExpression(*forLoop->initialize.expression);
+    if (errorType != ParseExpressionErrorType::NONE) {
+      if (errorType == ParseExpressionErrorType::EXPRESSION_AFTER_EXPRESSION) {
+        expected.emplace_back(ExpectedType::TOKEN, errorToken, TokenType::SEMICOLON);
+      } else if (errorType == ParseExpressionErrorType::NOT_EXPRESSION) {
+        unexpected.emplace_back(errorToken);
       }
-      tokenizer->consumePeek();
+      return ParseStatementErrorType::REPORTED;
     }
-    else if (token.type == TokenType::FOR) {
-      tokenizer->consumePeek();
-      statement.controlFlow->type = ControlFlowStatementType::FOR_LOOP;
-      statement.controlFlow->forLoop = memPool.makeForLoop();
+    if (tokenizer->peekNext().type != TokenType::SEMICOLON) {
+      expected.emplace_back(ExpectedType::TOKEN, tokenizer->peeked, TokenType::SEMICOLON);
+      return ParseStatementErrorType::REPORTED;
+    }
+  }
+  tokenizer->consumePeek();
 
-      auto& forLoop = statement.controlFlow->forLoop;
-      if (tokenizer->peekNext().type != TokenType::OPEN_PAREN) {
-        expected.emplace_back(ExpectedType::TOKEN, tokenizer->peeked, TokenType::OPEN_PAREN, tokenizer->tokenizerIndex);
-        return ParseStatementErrorType::REPORTED;
+  // parse condition statement
+  if (tokenizer->peekNext().type != TokenType::SEMICOLON) {
+    ParseExpressionErrorType errorType = parseExpression(forLoop->condition);
+    if (errorType != ParseExpressionErrorType::NONE) {
+      if (errorType == ParseExpressionErrorType::EXPRESSION_AFTER_EXPRESSION) {
+        expected.emplace_back(ExpectedType::TOKEN, errorToken, TokenType::SEMICOLON);
+      } else if (errorType == ParseExpressionErrorType::NOT_EXPRESSION) {
+        unexpected.emplace_back(errorToken);
       }
-      // consume open paren
-      tokenizer->consumePeek();
-      Token next = tokenizer->peekNext();
+      return ParseStatementErrorType::REPORTED;
+    }
+    if (tokenizer->peekNext().type != TokenType::SEMICOLON) {
+      expected.emplace_back(ExpectedType::TOKEN, tokenizer->peeked, TokenType::SEMICOLON);
+      return ParseStatementErrorType::REPORTED;
+    }
+  }
+  tokenizer->consumePeek();
 
-      // parse initialize statement. can be expression or varDec
-      if (next.type == TokenType::IDENTIFIER) {
-        // consume identifier
-        tokenizer->consumePeek();
-        ParseStatementErrorType errorType = parseIdentifierStatement(forLoop->initialize, next);
-        if (errorType != ParseStatementErrorType::NONE) {
-          if (errorType == ParseStatementErrorType::EXPRESSION_AFTER_EXPRESSION) {
-            expected.emplace_back(ExpectedType::TOKEN, errorToken, TokenType::SEMICOLON, tokenizer->tokenizerIndex);
-          } else if (errorType == ParseStatementErrorType::NOT_EXPRESSION) {
-            unexpected.emplace_back(errorToken, tokenizer->tokenizerIndex);
-          }
-          return ParseStatementErrorType::REPORTED;
-        }
-        if (tokenizer->peekNext().type != TokenType::SEMICOLON) {
-          expected.emplace_back(ExpectedType::TOKEN, tokenizer->peeked, TokenType::SEMICOLON, tokenizer->tokenizerIndex);
-          return ParseStatementErrorType::REPORTED;
-        }
-      } else if (next.type != TokenType::SEMICOLON) {
-        forLoop->initialize.type = StatementType::EXPRESSION;
-        forLoop->initialize.expression = memPool.makeExpression();
-        ParseExpressionErrorType errorType = parseExpression(*forLoop->initialize.expression);
-        if (errorType != ParseExpressionErrorType::NONE) {
-          if (errorType == ParseExpressionErrorType::EXPRESSION_AFTER_EXPRESSION) {
-            expected.emplace_back(ExpectedType::TOKEN, errorToken, TokenType::SEMICOLON, tokenizer->tokenizerIndex);
-          } else if (errorType == ParseExpressionErrorType::NOT_EXPRESSION) {
-            unexpected.emplace_back(errorToken, tokenizer->tokenizerIndex);
-          }
-          return ParseStatementErrorType::REPORTED;
-        }
-        if (tokenizer->peekNext().type != TokenType::SEMICOLON) {
-          expected.emplace_back(ExpectedType::TOKEN, tokenizer->peeked, TokenType::SEMICOLON, tokenizer->tokenizerIndex);
-          return ParseStatementErrorType::REPORTED;
-        }
+  // parse iteration statement
+  if (tokenizer->peekNext().type != TokenType::CLOSE_PAREN) {
+    ParseExpressionErrorType errorType = parseExpression(forLoop->iteration);
+    if (errorType != ParseExpressionErrorType::NONE) {
+      if (errorType == ParseExpressionErrorType::EXPRESSION_AFTER_EXPRESSION) {
+        expected.emplace_back(ExpectedType::TOKEN, errorToken, TokenType::CLOSE_PAREN);
+      } else if (errorType == ParseExpressionErrorType::NOT_EXPRESSION) {
+        unexpected.emplace_back(errorToken);
       }
-      tokenizer->consumePeek();
+      return ParseStatementErrorType::REPORTED;
+    }
+    if (tokenizer->peekNext().type != TokenType::CLOSE_PAREN) {
+      expected.emplace_back(ExpectedType::TOKEN, tokenizer->peeked, TokenType::CLOSE_PAREN);
+      return ParseStatementErrorType::REPORTED;
+    }
+  }
+  tokenizer->consumePeek();
 
-      // parse condition statement
-      if (tokenizer->peekNext().type != TokenType::SEMICOLON) {
-        ParseExpressionErrorType errorType = parseExpression(forLoop->condition);
-        if (errorType != ParseExpressionErrorType::NONE) {
-          if (errorType == ParseExpressionErrorType::EXPRESSION_AFTER_EXPRESSION) {
-            expected.emplace_back(ExpectedType::TOKEN, errorToken, TokenType::SEMICOLON, tokenizer->tokenizerIndex);
-          } else if (errorType == ParseExpressionErrorType::NOT_EXPRESSION) {
-            unexpected.emplace_back(errorToken, tokenizer->tokenizerIndex);
-          }
-          return ParseStatementErrorType::REPORTED;
-        }
-        if (tokenizer->peekNext().type != TokenType::SEMICOLON) {
-          expected.emplace_back(ExpectedType::TOKEN, tokenizer->peeked, TokenType::SEMICOLON, tokenizer->tokenizerIndex);
-          return ParseStatementErrorType::REPORTED;
-        }
-      }
-      tokenizer->consumePeek();
+  // parse scope
+  if (tokenizer->peekNext().type != TokenType::OPEN_BRACE) {
+    expected.emplace_back(ExpectedType::TOKEN, tokenizer->peeked, TokenType::OPEN_BRACE);
+    return ParseStatementErrorType::REPORTED;
+  }
+  tokenizer->consumePeek();
+  ParseStatementErrorType errorType = parseScope(forLoop->body.scopeStatements);
+  if (errorType != ParseStatementErrorType::NONE) {
+    return ParseStatementErrorType::REPORTED;
+  }
+  return ParseStatementErrorType::NONE;
+}
 
-      // parse iteration statement
-      if (tokenizer->peekNext().type != TokenType::CLOSE_PAREN) {
-        ParseExpressionErrorType errorType = parseExpression(forLoop->iteration);
-        if (errorType != ParseExpressionErrorType::NONE) {
-          if (errorType == ParseExpressionErrorType::EXPRESSION_AFTER_EXPRESSION) {
-            expected.emplace_back(ExpectedType::TOKEN, errorToken, TokenType::CLOSE_PAREN, tokenizer->tokenizerIndex);
-          } else if (errorType == ParseExpressionErrorType::NOT_EXPRESSION) {
-            unexpected.emplace_back(errorToken, tokenizer->tokenizerIndex);
-          }
-          return ParseStatementErrorType::REPORTED;
-        }
-        if (tokenizer->peekNext().type != TokenType::CLOSE_PAREN) {
-          expected.emplace_back(ExpectedType::TOKEN, tokenizer->peeked, TokenType::CLOSE_PAREN, tokenizer->tokenizerIndex);
+/**
+ * switch statement
+*/
+ParseStatementErrorType Parser::parseSwitchStatement(Statement& statement, Token) {
+  statement.type = StatementType::CONTROL_FLOW;
+  statement.controlFlow = memPool.makeControlFlowStatement();
+  tokenizer->consumePeek();
+  statement.controlFlow->type = ControlFlowStatementType::SWITCH_STATEMENT;
+  auto& switchStatement = statement.controlFlow->switchStatement;
+  switchStatement = memPool.makeSwitchStatement();
+  if (parseExpressionBeforeScope(switchStatement->switched) != ParseStatementErrorType::NONE) {
+    return ParseStatementErrorType::REPORTED;
+  }
+  SwitchScopeStatementList *list = nullptr;
+  while (true) {
+    Token next = tokenizer->peekNext();
+    if (next.type == TokenType::CLOSE_BRACE) {
+      tokenizer->consumePeek();
+      break;
+    }
+    if (next.type != TokenType::CASE && next.type != TokenType::DEFAULT) {
+      unexpected.emplace_back(next);
+      return ParseStatementErrorType::REPORTED;
+    }
+    // the first case is kept in the switch statement itself, the others are allocated as they are found
+    if (list) {
+      list->next = memPool.makeSwitchScopeStatementList();
+      list = list->next;
+    } else {
+      list = &switchStatement->body;
+    }
+    if (next.type == TokenType::CASE) {
+      tokenizer->consumePeek();
+      list->caseExpression = memPool.makeExpression();
+      if (parseExpressionBeforeScope(*list->caseExpression) != ParseStatementErrorType::NONE) {
+        if (expected.empty() || (expected.back().expectedType != ExpectedType::TOKEN && expected.back().expectedTokenType != TokenType::OPEN_BRACE)) {
           return ParseStatementErrorType::REPORTED;
         }
+        expected.pop_back();
+      } else {
+        list->caseBody = memPool.makeScope();
+        parseScope(list->caseBody->scopeStatements);
       }
+    }
+    else {
       tokenizer->consumePeek();
-
-      // parse scope
       if (tokenizer->peekNext().type != TokenType::OPEN_BRACE) {
-        expected.emplace_back(ExpectedType::TOKEN, tokenizer->peeked, TokenType::OPEN_BRACE, tokenizer->tokenizerIndex);
+        expected.emplace_back(ExpectedType::TOKEN, tokenizer->peeked, TokenType::CLOSE_BRACE);
         return ParseStatementErrorType::REPORTED;
       }
+      // consume open brace
       tokenizer->consumePeek();
-      ParseStatementErrorType errorType = parseScope(forLoop->body.scopeStatements);
-      if (errorType != ParseStatementErrorType::NONE) {
+      list->caseBody = memPool.makeScope();
+      if (parseScope(list->caseBody->scopeStatements) != ParseStatementErrorType::NONE) {
         return ParseStatementErrorType::REPORTED;
       }
     }
-    else if (token.type == TokenType::SWITCH) {
-      tokenizer->consumePeek();
-      statement.controlFlow->type = ControlFlowStatementType::SWITCH_STATEMENT;
-      auto& switchStatement = statement.controlFlow->switchStatement;
-      switchStatement = memPool.makeSwitchStatement();
-      if (parseExpressionBeforeScope(switchStatement->switched) != ParseStatementErrorType::NONE) {
-        return ParseStatementErrorType::REPORTED;
-      }
-      for (SwitchScopeStatementList *list = &switchStatement->body, *prev = nullptr;; list = list->next) {
-        Token next = tokenizer->peekNext();
-        if (next.type == TokenType::CASE) {
-          tokenizer->consumePeek();
-          list->caseExpression = memPool.makeExpression();
-          if (parseExpressionBeforeScope(*list->caseExpression) != ParseStatementErrorType::NONE) {
-            if (expected.back().expectedType != ExpectedType::TOKEN && expected.back().expectedTokenType != TokenType::OPEN_BRACE) {
-              return ParseStatementErrorType::REPORTED;
-            }
-            expected.pop_back();
-          } else {
-            list->caseBody = memPool.makeScope();
-            parseScope(list->caseBody->scopeStatements);
-          }
-        }
-        else if (next.type == TokenType::DEFAULT) {
-          tokenizer->consumePeek();
-          if (tokenizer->peekNext().type != TokenType::OPEN_BRACE) {
-            expected.emplace_back(ExpectedType::TOKEN, tokenizer->peeked, TokenType::CLOSE_BRACE, tokenizer->tokenizerIndex);
-            return ParseStatementErrorType::REPORTED;
-          }
-          // consume open brace
-          tokenizer->consumePeek();
-          list->caseBody = memPool.makeScope();
-          if (parseScope(list->caseBody->scopeStatements) != ParseStatementErrorType::NONE) {
-            return ParseStatementErrorType::REPORTED;
-          }
-        }
-        else if (next.type == TokenType::CLOSE_BRACE) {
-          if (prev) {
-            prev->next = nullptr;
-            memPool.release(list);
-          }
-          tokenizer->consumePeek();
-          break;
-        }
-        else {
-          unexpected.emplace_back(next, tokenizer->tokenizerIndex);
-          return ParseStatementErrorType::REPORTED;
-        }
-        prev = list;
-        list->next = memPool.makeSwitchScopeStatementList();
-      }
-    }
-  }
-  else if (token.type == TokenType::OPEN_BRACE) { // scope
-    tokenizer->consumePeek();
-    statement.type = StatementType::SCOPE;
-    statement.scope = memPool.makeScope();
-    ParseStatementErrorType errorType = parseScope(statement.scope->scopeStatements);
-    if (errorType != ParseStatementErrorType::NONE) {
-      return ParseStatementErrorType::REPORTED;
-    }
   }
-  else if (token.type == TokenType::BREAK || token.type == TokenType::CONTINUE) {
-    tokenizer->consumePeek();
-    statement.type = StatementType::KEYWORD;
-    statement.keyword = token;
-    if (tokenizer->peekNext().type != TokenType::SEMICOLON) {
-      expected.emplace_back(ExpectedType::TOKEN, tokenizer->peeked, TokenType::SEMICOLON, tokenizer->tokenizerIndex);
-      return ParseStatementErrorType::REPORTED;
-    }
-    tokenizer->consumePeek();
+  return ParseStatementErrorType::NONE;
+}
+
+/**
+ * nested scope
+*/
+ParseStatementErrorType Parser::parseScopeStatement(Statement& statement, Token) {
+  tokenizer->consumePeek();
+  statement.type = StatementType::SCOPE;
+  statement.scope = memPool.makeScope();
+  ParseStatementErrorType errorType = parseScope(statement.scope->scopeStatements);
+  if (errorType != ParseStatementErrorType::NONE) {
+    return ParseStatementErrorType::REPORTED;
   }
-  else if (notFirstOfExpression(token.type)) { // unexpected token
-    unexpected.emplace_back(token, tokenizer->tokenizerIndex);
+  return ParseStatementErrorType::NONE;
+}
+
+/**
+ * break or continue
+*/
+ParseStatementErrorType Parser::parseKeywordStatement(Statement& statement, Token token) {
+  tokenizer->consumePeek();
+  statement.type = StatementType::KEYWORD;
+  statement.keyword = token;
+  if (tokenizer->peekNext().type != TokenType::SEMICOLON) {
+    expected.emplace_back(ExpectedType::TOKEN, tokenizer->peeked, TokenType::SEMICOLON);
     return ParseStatementErrorType::REPORTED;
   }
-  else { // expression
-    statement.type = StatementType::EXPRESSION;
-    statement.expression = memPool.makeExpression();
-    ParseExpressionErrorType errorType = parseExpression(*statement.expression);
-    if (errorType != ParseExpressionErrorType::NONE) {
-      if (errorType == ParseExpressionErrorType::NOT_EXPRESSION) {
-        expected.emplace_back(ExpectedType::EXPRESSION, errorToken, tokenizer->tokenizerIndex);
-      } else if (errorType == ParseExpressionErrorType::EXPRESSION_AFTER_EXPRESSION) {
-        expected.emplace_back(ExpectedType::TOKEN, errorToken, TokenType::SEMICOLON, tokenizer->tokenizerIndex);
-      }
-      return ParseStatementErrorType::REPORTED;
-    }
+  tokenizer->consumePeek();
+  return ParseStatementErrorType::NONE;
+}
 
-    if (tokenizer->peekNext().type != TokenType::SEMICOLON) {
-      expected.emplace_back(ExpectedType::TOKEN, tokenizer->peeked, TokenType::SEMICOLON, tokenizer->tokenizerIndex);
-      return ParseStatementErrorType::REPORTED;
+/**
+ * token that cannot start a statement
+*/
+ParseStatementErrorType Parser::parseUnexpectedStatement(Statement&, Token token) {
+  unexpected.emplace_back(token);
+  return ParseStatementErrorType::REPORTED;
+}
+
+/**
+ * expression terminated by a semicolon
+*/
+ParseStatementErrorType Parser::parseExpressionStatement(Statement& statement, Token) {
+  statement.type = StatementType::EXPRESSION;
+  statement.expression = memPool.makeExpression();
+  ParseExpressionErrorType errorType = parseExpression(*statement.expression);
+  if (errorType != ParseExpressionErrorType::NONE) {
+    if (errorType == ParseExpressionErrorType::NOT_EXPRESSION) {
+      expected.emplace_back(ExpectedType::EXPRESSION, errorToken);
+    } else if (errorType == ParseExpressionErrorType::EXPRESSION_AFTER_EXPRESSION) {
+      expected.emplace_back(ExpectedType::TOKEN, errorToken, TokenType::SEMICOLON);
     }
-    tokenizer->consumePeek();
+    return ParseStatementErrorType::REPORTED;
   }
 
+  if (tokenizer->peekNext().type != TokenType::SEMICOLON) {
+    expected.emplace_back(ExpectedType::TOKEN, tokenizer->peeked, TokenType::SEMICOLON);
+    return ParseStatementErrorType::REPORTED;
+  }
+  tokenizer->consumePeek();
   return ParseStatementErrorType::NONE;
 }
 
@@ -755,15 +1035,14 @@ ParseStatementErrorType Parser::parseVariableDec(VariableDec& varDec) {
       tokenizer->consumePeek();
       varDec.initialAssignment->type = ExpressionType::ARRAY_OR_STRUCT_LITERAL;
       varDec.initialAssignment->arrayOrStruct = memPool.makeArrayOrStruct();
-      ParseExpressionErrorType errorType = parseArrayOrStructLiteral(*varDec.initialAssignment->arrayOrStruct);
-      if (tokenizer->peekNext().type != TokenType::CLOSE_BRACKET) {
-        expected.emplace_back(ExpectedType::TOKEN, errorToken, TokenType::CLOSE_BRACKET, tokenizer->tokenizerIndex);
+      if (parseArrayOrStructLiteral(*varDec.initialAssignment->arrayOrStruct) != ParseExpressionErrorType::NONE) {
         return ParseStatementErrorType::REPORTED;
       }
-      tokenizer->consumePeek();
-      if (errorType != ParseExpressionErrorType::NONE) {
+      if (tokenizer->peekNext().type != TokenType::CLOSE_BRACKET) {
+        expected.emplace_back(ExpectedType::TOKEN, tokenizer->peeked, TokenType::CLOSE_BRACKET);
         return ParseStatementErrorType::REPORTED;
       }
+      tokenizer->consumePeek();
     } else {
       varDec.initialAssignment = memPool.makeExpression();
       ParseExpressionErrorType errorType = parseExpression(*varDec.initialAssignment);
@@ -771,7 +1050,7 @@ ParseStatementErrorType Parser::parseVariableDec(VariableDec& varDec) {
         if (errorType == ParseExpressionErrorType::EXPRESSION_AFTER_EXPRESSION) {
           return ParseStatementErrorType::EXPRESSION_AFTER_EXPRESSION;
         } else if (errorType == ParseExpressionErrorType::NOT_EXPRESSION) {
-          expected.emplace_back(ExpectedType::EXPRESSION, errorToken, tokenizer->tokenizerIndex);
+          expected.emplace_back(ExpectedType::EXPRESSION, errorToken);
         }
         return ParseStatementErrorType::REPORTED;
       }
@@ -790,14 +1069,14 @@ ParseStatementErrorType Parser::parseIdentifierStatement(Statement& statement, T
   if (next.type == TokenType::COLON) {
     tokenizer->consumePeek();
     statement.type = StatementType::VARIABLE_DEC;
-    statement.varDec = memPool.makeVariableDec(VariableDec{token});
+    statement.varDec = memPool.make<VariableDec>(token);
     ParseStatementErrorType errorType = parseVariableDec(*statement.varDec);
     return errorType;
   }
   // expression
   statement.type = StatementType::EXPRESSION;
   statement.expression = memPool.makeExpression();
-  tokenizer->position = token.position;
+  tokenizer->position = token.position - tokenizer->baseLocation;
   tokenizer->peeked.type = TokenType::NOTHING;
   ParseExpressionErrorType errorType = parseExpression(*statement.expression);
   if (errorType != ParseExpressionErrorType::NONE) {
@@ -830,14 +1109,14 @@ ParseStatementErrorType Parser::parseExpressionBeforeScope(Expression& expressio
   ParseExpressionErrorType errorType = parseExpression(expression);
   if (errorType != ParseExpressionErrorType::NONE) {
     if (errorType == ParseExpressionErrorType::EXPRESSION_AFTER_EXPRESSION) {
-      expected.emplace_back(ExpectedType::TOKEN, errorToken, TokenType::OPERATOR, tokenizer->tokenizerIndex);
+      expected.emplace_back(ExpectedType::TOKEN, errorToken, TokenType::OPERATOR);
     } else if (errorType == ParseExpressionErrorType::NOT_EXPRESSION) {
-      expected.emplace_back(ExpectedType::EXPRESSION, errorToken, tokenizer->tokenizerIndex);
+      expected.emplace_back(ExpectedType::EXPRESSION, errorToken);
     }
     return ParseStatementErrorType::REPORTED;
   }
   if (tokenizer->peekNext().type != TokenType::OPEN_BRACE) {
-    expected.emplace_back(ExpectedType::TOKEN, tokenizer->peeked, TokenType::OPEN_BRACE, tokenizer->tokenizerIndex);
+    expected.emplace_back(ExpectedType::TOKEN, tokenizer->peeked, TokenType::OPEN_BRACE);
     return ParseStatementErrorType::REPORTED;
   }
   // consume open brace
@@ -853,18 +1132,19 @@ ParseExpressionErrorType Parser::getExpressions(ExpressionList& expressions, Tok
   if (tokenizer->peekNext().type == close) {
     return ParseExpressionErrorType::NONE;
   }
-  ExpressionList *list = &expressions;
+  ScratchGuard<Expression> list{expressionScratch};
   while (true) {
-    ParseExpressionErrorType errorType = parseExpression(list->curr);
+    Expression expression;
+    ParseExpressionErrorType errorType = parseExpression(expression);
     if (errorType != ParseExpressionErrorType::NONE) {
       return errorType;
     }
+    list.scratch.push_back(expression);
     if (tokenizer->peekNext().type != TokenType::COMMA) {
+      expressions = list.commit(memPool);
       return ParseExpressionErrorType::NONE;
     }
     tokenizer->consumePeek();
-    list->next = memPool.makeExpressionList();
-    list = list->next;
   }
 }
 
@@ -873,39 +1153,48 @@ ParseExpressionErrorType Parser::getExpressions(ExpressionList& expressions, Tok
  * actual expressions cannot have an array/struct literal since it only really makes sense to initialize with / return them.
 */
 ParseExpressionErrorType Parser::parseArrayOrStructLiteral(ArrayOrStructLiteral& arrayOrStruct) {
-  if (tokenizer->peekNext().type == TokenType::CLOSE_BRACKET) {
+  NestingGuard nesting{nestingDepth};
+  if (!checkNestingDepth(tokenizer->peekNext())) {
+    return ParseExpressionErrorType::REPORTED;
+  }
+  if (tokenizer->peeked.type == TokenType::CLOSE_BRACKET) {
     return ParseExpressionErrorType::NONE;
   }
-  ExpressionList *list = &arrayOrStruct.values;
+  ScratchGuard<Expression> list{expressionScratch};
   while (true) {
+    Expression value;
     ParseExpressionErrorType errorType;
     if (tokenizer->peekNext().type == TokenType::OPEN_BRACKET) {
       tokenizer->consumePeek();
-      list->curr.type = ExpressionType::ARRAY_OR_STRUCT_LITERAL;
-      list->curr.arrayOrStruct = memPool.makeArrayOrStruct();
-      errorType = parseArrayOrStructLiteral(*list->curr.arrayOrStruct);
+      value.type = ExpressionType::ARRAY_OR_STRUCT_LITERAL;
+      value.arrayOrStruct = memPool.makeArrayOrStruct();
+      errorType = parseArrayOrStructLiteral(*value.arrayOrStruct);
+      // the error is already reported, don't expect the closing bracket of every literal it is nested in
+      if (errorType != ParseExpressionErrorType::NONE) {
+        return ParseExpressionErrorType::REPORTED;
+      }
       if (tokenizer->peekNext().type != TokenType::CLOSE_BRACKET) {
-        expected.emplace_back(ExpectedType::TOKEN, tokenizer->peeked, TokenType::CLOSE_BRACKET, tokenizer->tokenizerIndex);
+        expected.emplace_back(ExpectedType::TOKEN, tokenizer->peeked, TokenType::CLOSE_BRACKET);
         return ParseExpressionErrorType::REPORTED;
       }
       tokenizer->consumePeek();
     } else {
-      errorType = parseExpression(list->curr);
+      errorType = parseExpression(value);
     }
     if (errorType != ParseExpressionErrorType::NONE) {
       if (errorType == ParseExpressionErrorType::EXPRESSION_AFTER_EXPRESSION) {
-        expected.emplace_back(ExpectedType::TOKEN, errorToken, TokenType::COMMA, tokenizer->tokenizerIndex);
+        expected.emplace_back(ExpectedType::TOKEN, errorToken, TokenType::COMMA);
       } else if (errorType == ParseExpressionErrorType::NOT_EXPRESSION) {
-        expected.emplace_back(ExpectedType::EXPRESSION, errorToken, tokenizer->tokenizerIndex);
+        expected.emplace_back(ExpectedType::EXPRESSION, errorToken);
       }
       return ParseExpressionErrorType::REPORTED;
     }
+    list.scratch.push_back(value);
     if (tokenizer->peekNext().type != TokenType::COMMA) {
+      arrayOrStruct.values = list.commit(memPool);
       return ParseExpressionErrorType::NONE;
     }
     tokenizer->consumePeek();
-    list->next = memPool.makeExpressionList();
-    list = list->next;
   }
 }
 
@@ -914,36 +1203,46 @@ ParseExpressionErrorType Parser::parseArrayOrStructLiteral(ArrayOrStructLiteral&
  * Consumes the entire expression unless there was an error
 */
 ParseExpressionErrorType Parser::parseExpression(Expression& rootExpression) {
-  Expression *bottom = nullptr;
+  NestingGuard nesting{nestingDepth};
   Token token = tokenizer->peekNext();
+  if (!checkNestingDepth(token)) {
+    return ParseExpressionErrorType::REPORTED;
+  }
+  Expression *bottom = nullptr;
   while (true) {
     bool binary = isBinaryOp(token.type);
     if (binary || isUnaryOp(token.type)) {
+      if (!binary) {
+        nesting.deeper();
+        if (!checkNestingDepth(token)) {
+          return ParseExpressionErrorType::REPORTED;
+        }
+      }
       tokenizer->consumePeek();
       Expression expression;
       if (binary) {
         expression.type = ExpressionType::BINARY_OP;
-        expression.binOp = memPool.makeBinOp(BinOp{token});
+        expression.binOp = memPool.make<BinOp>(token);
         if (!bottom) {
           // expected expression
-          expected.emplace_back(ExpectedType::EXPRESSION, token, tokenizer->tokenizerIndex);
+          expected.emplace_back(ExpectedType::EXPRESSION, token);
           rootExpression = expression;
           bottom = &rootExpression;
           tokenizer->consumePeek();
           token = tokenizer->peekNext();
           continue;
         } else if (bottom->type == ExpressionType::BINARY_OP || bottom->type == ExpressionType::UNARY_OP) {
-          expected.emplace_back(ExpectedType::EXPRESSION, token, tokenizer->tokenizerIndex);
+          expected.emplace_back(ExpectedType::EXPRESSION, token);
           return ParseExpressionErrorType::REPORTED;
         }
       }
       else {
         expression.type = ExpressionType::UNARY_OP;
-        expression.unOp = memPool.makeUnOp(UnOp{token});
+        expression.unOp = memPool.make<UnOp>(token);
         if (!bottom) {
           if (token.type == TokenType::DECREMENT_POSTFIX || token.type == TokenType::INCREMENT_POSTFIX) {
             // expected expression
-            expected.emplace_back(ExpectedType::EXPRESSION, token, tokenizer->tokenizerIndex);
+            expected.emplace_back(ExpectedType::EXPRESSION, token);
           }
           rootExpression = expression;
           bottom = &rootExpression;
@@ -953,7 +1252,7 @@ ParseExpressionErrorType Parser::parseExpression(Expression& rootExpression) {
         } else if (token.type == TokenType::DECREMENT_POSTFIX || token.type == TokenType::INCREMENT_POSTFIX) {
           if (bottom->type == ExpressionType::BINARY_OP || bottom->type == ExpressionType::UNARY_OP) {
             // expected expression
-            expected.emplace_back(ExpectedType::EXPRESSION, token, tokenizer->tokenizerIndex);
+            expected.emplace_back(ExpectedType::EXPRESSION, token);
             return ParseExpressionErrorType::REPORTED;
           }
         }
@@ -1029,14 +1328,14 @@ ParseExpressionErrorType Parser::parseExpression(Expression& rootExpression) {
         ParseExpressionErrorType errorType = parseExpression(*expression.wrapped);
         if (errorType != ParseExpressionErrorType::NONE) {
           if (errorType == ParseExpressionErrorType::EXPRESSION_AFTER_EXPRESSION) {
-            expected.emplace_back(ExpectedType::TOKEN, errorToken, TokenType::CLOSE_PAREN, tokenizer->tokenizerIndex);
+            expected.emplace_back(ExpectedType::TOKEN, errorToken, TokenType::CLOSE_PAREN);
           } else if (errorType == ParseExpressionErrorType::NOT_EXPRESSION) {
-            expected.emplace_back(ExpectedType::EXPRESSION, errorToken, tokenizer->tokenizerIndex);
+            expected.emplace_back(ExpectedType::EXPRESSION, errorToken);
           }
           return ParseExpressionErrorType::REPORTED;
         }
         if (tokenizer->peekNext().type != TokenType::CLOSE_PAREN) {
-          expected.emplace_back(ExpectedType::TOKEN, tokenizer->peeked, TokenType::CLOSE_PAREN, tokenizer->tokenizerIndex);
+          expected.emplace_back(ExpectedType::TOKEN, tokenizer->peeked, TokenType::CLOSE_PAREN);
           return ParseExpressionErrorType::REPORTED;
         }
         tokenizer->consumePeek();
@@ -1047,21 +1346,21 @@ ParseExpressionErrorType Parser::parseExpression(Expression& rootExpression) {
         if (next.type == TokenType::OPEN_PAREN) {
           tokenizer->consumePeek();
           expression.type = ExpressionType::FUNCTION_CALL;
-          expression.funcCall = memPool.makeFunctionCall(FunctionCall{token});
+          expression.funcCall = memPool.make<FunctionCall>(token);
           ParseExpressionErrorType errorType = getExpressions(expression.funcCall->args, TokenType::CLOSE_PAREN);
           if (errorType != ParseExpressionErrorType::NONE) {
             if (errorType == ParseExpressionErrorType::EXPRESSION_AFTER_EXPRESSION) {
-              expected.emplace_back(ExpectedType::TOKEN, errorToken, TokenType::CLOSE_PAREN, tokenizer->tokenizerIndex);
+              expected.emplace_back(ExpectedType::TOKEN, errorToken, TokenType::CLOSE_PAREN);
             } else if (errorType == ParseExpressionErrorType::NOT_EXPRESSION) {
-              expected.emplace_back(ExpectedType::EXPRESSION, errorToken, tokenizer->tokenizerIndex);
+              expected.emplace_back(ExpectedType::EXPRESSION, errorToken);
             }
             return ParseExpressionErrorType::REPORTED;
           }
           if (tokenizer->peekNext().type != TokenType::CLOSE_PAREN) {
             if (tokenizer->peeked.type == TokenType::COMMA) {
-              expected.emplace_back(ExpectedType::EXPRESSION, tokenizer->peeked, tokenizer->tokenizerIndex);
+              expected.emplace_back(ExpectedType::EXPRESSION, tokenizer->peeked);
             } else {
-              expected.emplace_back(ExpectedType::TOKEN, tokenizer->peeked, TokenType::CLOSE_PAREN, tokenizer->tokenizerIndex);
+              expected.emplace_back(ExpectedType::TOKEN, tokenizer->peeked, TokenType::CLOSE_PAREN);
             }
             return ParseExpressionErrorType::REPORTED;
           }
@@ -1070,18 +1369,18 @@ ParseExpressionErrorType Parser::parseExpression(Expression& rootExpression) {
         else if (next.type == TokenType::OPEN_BRACKET) {
           tokenizer->consumePeek();
           expression.type = ExpressionType::ARRAY_ACCESS;
-          expression.arrAccess = memPool.makeArrayAccess(ArrayAccess{token});
+          expression.arrAccess = memPool.make<ArrayAccess>(token);
           ParseExpressionErrorType errorType = parseExpression(expression.arrAccess->offset);
           if (errorType != ParseExpressionErrorType::NONE) {
             if (errorType == ParseExpressionErrorType::EXPRESSION_AFTER_EXPRESSION) {
-              expected.emplace_back(ExpectedType::TOKEN, errorToken, TokenType::CLOSE_BRACKET, tokenizer->tokenizerIndex);
+              expected.emplace_back(ExpectedType::TOKEN, errorToken, TokenType::CLOSE_BRACKET);
             } else if (errorType == ParseExpressionErrorType::NOT_EXPRESSION) {
-              expected.emplace_back(ExpectedType::EXPRESSION, errorToken, tokenizer->tokenizerIndex);
+              expected.emplace_back(ExpectedType::EXPRESSION, errorToken);
             }
             return ParseExpressionErrorType::REPORTED;
           }
           if (tokenizer->peekNext().type != TokenType::CLOSE_BRACKET) {
-            expected.emplace_back(ExpectedType::TOKEN, tokenizer->peeked, TokenType::CLOSE_BRACKET, tokenizer->tokenizerIndex);
+            expected.emplace_back(ExpectedType::TOKEN, tokenizer->peeked, TokenType::CLOSE_BRACKET);
             return ParseExpressionErrorType::REPORTED;
           }
           tokenizer->consumePeek();
@@ -1094,6 +1393,7 @@ ParseExpressionErrorType Parser::parseExpression(Expression& rootExpression) {
       else {
         break;
       }
+      nesting.shallower();
       if (bottom) {
         if (bottom->type == ExpressionType::BINARY_OP) {
           if (bottom->binOp->rightSide.type != ExpressionType::NONE) {
@@ -1123,13 +1423,13 @@ ParseExpressionErrorType Parser::parseExpression(Expression& rootExpression) {
   if (bottom) {
     if (bottom->type == ExpressionType::BINARY_OP) {
       if (bottom->binOp->rightSide.type == ExpressionType::NONE) {
-        expected.emplace_back(ExpectedType::EXPRESSION, token, tokenizer->tokenizerIndex);
+        expected.emplace_back(ExpectedType::EXPRESSION, token);
         return ParseExpressionErrorType::REPORTED;
       }
       return ParseExpressionErrorType::NONE;
     } else if (bottom->type == ExpressionType::UNARY_OP) {
       if (bottom->unOp->operand.type == ExpressionType::NONE) {
-        expected.emplace_back(ExpectedType::EXPRESSION, token, tokenizer->tokenizerIndex);
+        expected.emplace_back(ExpectedType::EXPRESSION, token);
         return ParseExpressionErrorType::REPORTED;
       }
       return ParseExpressionErrorType::NONE;
@@ -1148,31 +1448,23 @@ ParseExpressionErrorType Parser::parseExpression(Expression& rootExpression) {
 */
 ParseTypeErrorType Parser::getType(TokenList& type) {
   Token tp = tokenizer->peekNext();
-  TokenList *curr = memPool.makeTokenList();
-  if (isConcreteType(tp.type)) {
-    tokenizer->consumePeek();
-    curr->token = tp;
-    TokenList *prev = curr;
-    curr = memPool.makeTokenList();
-    curr->next = prev;
-    tp = tokenizer->peekNext();
-  } else {
-    expected.emplace_back(ExpectedType::TOKEN, tp, TokenType::TYPE, tokenizer->tokenizerIndex);
+  if (!isConcreteType(tp.type)) {
+    expected.emplace_back(ExpectedType::TOKEN, tp, TokenType::TYPE);
     return ParseTypeErrorType::REPORTED;
   }
+  tokenizer->consumePeek();
+  // the last token read is kept in type itself, the ones before it are moved down the list
+  type.token = tp;
+  type.next = nullptr;
+  tp = tokenizer->peekNext();
   while (tp.type != TokenType::END_OF_FILE) {
     if (tp.type < TokenType::POINTER) {
       break;
     }
     tokenizer->consumePeek();
-    curr->token = tp;
-    TokenList *prev = curr;
-    curr = memPool.makeTokenList();
-    curr->next = prev;
+    type.next = memPool.make<TokenList>(type);
+    type.token = tp;
     tp = tokenizer->peekNext();
   }
-  type.token = curr->next->token;
-  type.next = curr->next->next;
-  memPool.release(curr);
   return ParseTypeErrorType::NONE;
 }
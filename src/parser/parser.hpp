@@ -2,12 +2,12 @@
 
 #include "../tokenizer/tokenizer.hpp"
 #include "../nodeMemPool.hpp"
+#include <functional>
 
 struct Unexpected {
   Token token;
-  uint32_t tkIndex;
   Unexpected() = delete;
-  explicit Unexpected(const Token&, uint32_t);
+  explicit Unexpected(const Token&);
   std::string getErrorMessage(std::vector<Tokenizer>&);
 };
 
@@ -19,12 +19,19 @@ enum class ExpectedType : uint8_t {
 
 struct Expected {
   Token tokenWhereExpected;
-  uint32_t tkIndex;
   TokenType expectedTokenType;
   ExpectedType expectedType;
   Expected() = delete;
-  Expected(ExpectedType, const Token&, uint32_t);
-  Expected(ExpectedType, const Token&, TokenType, uint32_t);
+  Expected(ExpectedType, const Token&);
+  Expected(ExpectedType, const Token&, TokenType);
+  std::string getErrorMessage(std::vector<Tokenizer>&);
+};
+
+struct NestingTooDeep {
+  Token token;
+  uint32_t limit;
+  NestingTooDeep() = delete;
+  NestingTooDeep(const Token&, uint32_t);
   std::string getErrorMessage(std::vector<Tokenizer>&);
 };
 
@@ -47,25 +54,55 @@ enum class ParseTypeErrorType: uint8_t {
   REPORTED,
 };
 
+// maximum combined depth of nested scopes, expressions, unary operators and array/struct literals.
+// the parser, checker and serializer recurse once per level, so this bounds their stack usage.
+// chains of binary operators are not limited, they are walked in a loop
+const uint32_t defaultMaxNestingDepth = 1000;
+
 struct Parser {
   Program program;
   std::vector<Unexpected> unexpected;
   std::vector<Expected> expected;
+  std::vector<NestingTooDeep> nestingTooDeep;
   Tokenizer *tokenizer;
   NodeMemPool &memPool;
-  GeneralDecList *globalPrev = nullptr;
-  GeneralDecList *globalList = &program.decs;
+  // the declaration being parsed. it is added to the program once it has been parsed successfully
+  GeneralDec *current;
   Token errorToken;
+  // called with each general declaration as soon as it has been parsed, so later stages can start before parsing is done
+  std::function<void(GeneralDec&)> onGeneralDec;
+  // children of the nodes being parsed, see ScratchGuard
+  std::vector<Statement> statementScratch;
+  std::vector<Expression> expressionScratch;
+  std::vector<StructMember> memberScratch;
+  uint32_t nestingDepth = 0;
+  uint32_t maxNestingDepth = defaultMaxNestingDepth;
   Parser() = delete;
   ~Parser();
   explicit Parser(Tokenizer&, NodeMemPool&);
   bool parse();
+  std::string getErrorMessages(std::vector<Tokenizer>&);
   GeneralDec *parseNext();
+  GeneralDec *parseGeneralDec();
+  GeneralDec *appendGeneralDec();
   bool parseFunction(FunctionDec&);
   bool parseStruct(StructDec&);
   bool parseTemplate(TemplateDec&);
   void swapTokenizer(Tokenizer&);
+  bool checkNestingDepth(const Token&);
+  void synchronizeGlobal();
+  bool synchronizeStatement(bool inStruct = false);
   ParseStatementErrorType parseStatement(Statement&);
+  ParseStatementErrorType parseIdentifierLeadStatement(Statement&, Token);
+  ParseStatementErrorType parseConditionalStatement(Statement&, Token);
+  ParseStatementErrorType parseWhileLoop(Statement&, Token);
+  ParseStatementErrorType parseReturnStatement(Statement&, Token);
+  ParseStatementErrorType parseForLoop(Statement&, Token);
+  ParseStatementErrorType parseSwitchStatement(Statement&, Token);
+  ParseStatementErrorType parseScopeStatement(Statement&, Token);
+  ParseStatementErrorType parseKeywordStatement(Statement&, Token);
+  ParseStatementErrorType parseUnexpectedStatement(Statement&, Token);
+  ParseStatementErrorType parseExpressionStatement(Statement&, Token);
   ParseStatementErrorType parseScope(StatementList&);
   ParseStatementErrorType parseExpressionBeforeScope(Expression&);
   ParseStatementErrorType parseIfStatement(IfStatement& condStatement);
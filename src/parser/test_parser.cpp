@@ -39,24 +39,25 @@ TEST_CASE("Function Declaration", "[parser]") {
   auto& decs = parser.program.decs;
   CHECK(parser.unexpected.empty());
   CHECK(parser.expected.empty());
-  REQUIRE(decs.next == nullptr);
-  REQUIRE(decs.curr.type == GeneralDecType::FUNCTION);
-  auto& func = decs.curr.funcDec;
+  REQUIRE(decs.size() == 1);
+  REQUIRE(decs[0]->type == GeneralDecType::FUNCTION);
+  auto& func = decs[0]->funcDec;
   REQUIRE(func);
   CHECK(tokenizer.extractToken(func->name) == "funcName");
 
   // check parameters
-  REQUIRE(func->params.curr.type == StatementType::VARIABLE_DEC);
-  REQUIRE(func->params.curr.varDec);
-  CHECK(tokenizer.extractToken(func->params.curr.varDec->name) == "first");
-  CHECK(func->params.curr.varDec->type.token.type == TokenType::POINTER);
-  REQUIRE(func->params.curr.varDec->type.next);
-  CHECK(func->params.curr.varDec->type.next->token.type == TokenType::UINT16_TYPE);
+  REQUIRE(func->params.size() == 1);
+  REQUIRE(func->params[0].type == StatementType::VARIABLE_DEC);
+  REQUIRE(func->params[0].varDec);
+  CHECK(tokenizer.extractToken(func->params[0].varDec->name) == "first");
+  CHECK(func->params[0].varDec->type.token.type == TokenType::POINTER);
+  REQUIRE(func->params[0].varDec->type.next);
+  CHECK(func->params[0].varDec->type.next->token.type == TokenType::UINT16_TYPE);
 
   // check return type
   CHECK(func->returnType.next == nullptr);
   CHECK(func->returnType.token.type == TokenType::UINT32_TYPE);
-  CHECK(func->body.scopeStatements.curr.type == StatementType::NOTHING);
+  CHECK(func->body.scopeStatements.empty());
 }
 
 TEST_CASE("Function Call - Base", "[parser]") {
@@ -73,7 +74,7 @@ TEST_CASE("Function Call - Base", "[parser]") {
   REQUIRE(statement.expression->type == ExpressionType::FUNCTION_CALL);
   REQUIRE(statement.expression->funcCall);
   CHECK(tokenizer.extractToken(statement.expression->funcCall->name) == "functionName");
-  CHECK(statement.expression->funcCall->args.curr.type == ExpressionType::NONE);
+  CHECK(statement.expression->funcCall->args.empty());
 }
 
 TEST_CASE("Function Call - Single Arg", "[parser]") {
@@ -91,8 +92,8 @@ TEST_CASE("Function Call - Single Arg", "[parser]") {
   REQUIRE(statement.expression->funcCall);
 
   auto& argsList = statement.expression->funcCall->args;
-  REQUIRE(argsList.next == nullptr);
-  auto& arg1 = argsList.curr;
+  REQUIRE(argsList.size() == 1);
+  auto& arg1 = argsList[0];
   REQUIRE(arg1.type == ExpressionType::VALUE);
   CHECK(tokenizer.extractToken(arg1.value) == "arg1");
 }
@@ -112,14 +113,14 @@ TEST_CASE("Function Call - Multi Arg", "[parser]") {
   REQUIRE(statement.expression->funcCall);
 
   auto& argsList = statement.expression->funcCall->args;
-  auto& arg1 = argsList.curr;
+  REQUIRE(argsList.size() == 2);
+  auto& arg1 = argsList[0];
   REQUIRE(arg1.type == ExpressionType::VALUE);
   CHECK(tokenizer.extractToken(arg1.value) == "arg1");
 
-  REQUIRE(argsList.next);
-  auto& arg2 = *argsList.next;
-  REQUIRE(arg2.curr.type == ExpressionType::VALUE);
-  CHECK(tokenizer.extractToken(arg2.curr.value) == "arg2");
+  auto& arg2 = argsList[1];
+  REQUIRE(arg2.type == ExpressionType::VALUE);
+  CHECK(tokenizer.extractToken(arg2.value) == "arg2");
 }
 
 TEST_CASE("Function Call - Nested", "[parser]") {
@@ -137,7 +138,8 @@ TEST_CASE("Function Call - Nested", "[parser]") {
   REQUIRE(statement.expression->funcCall);
 
   auto& argsList = statement.expression->funcCall->args;
-  auto& arg1 = argsList.curr;
+  REQUIRE(argsList.size() == 1);
+  auto& arg1 = argsList[0];
   REQUIRE(arg1.type == ExpressionType::ARRAY_ACCESS);
   REQUIRE(arg1.arrAccess);
   CHECK(tokenizer.extractToken(arg1.arrAccess->array) == "arg1");
@@ -146,7 +148,7 @@ TEST_CASE("Function Call - Nested", "[parser]") {
   auto& arg1_arg1 = arg1.arrAccess->offset.funcCall;
   REQUIRE(arg1_arg1);
   CHECK(tokenizer.extractToken(arg1_arg1->name) == "nested");
-  CHECK(arg1_arg1->args.curr.type == ExpressionType::NONE);
+  CHECK(arg1_arg1->args.empty());
 }
 
 TEST_CASE("Expressions", "[parser]") {
@@ -201,9 +203,9 @@ TEST_CASE("Expressions", "[parser]") {
     REQUIRE(rl.type == ExpressionType::FUNCTION_CALL);
     REQUIRE(rl.funcCall);
     REQUIRE(tokenizer.extractToken(rl.funcCall->name) == "function");
-    CHECK(rl.funcCall->args.next == nullptr);
-    REQUIRE(rl.funcCall->args.curr.type == ExpressionType::VALUE);
-    CHECK(tokenizer.extractToken(rl.funcCall->args.curr.value) == "var");
+    REQUIRE(rl.funcCall->args.size() == 1);
+    REQUIRE(rl.funcCall->args[0].type == ExpressionType::VALUE);
+    CHECK(tokenizer.extractToken(rl.funcCall->args[0].value) == "var");
 
     auto& rr = binOp->rightSide.binOp->rightSide;
     CHECK(rr.type == ExpressionType::VALUE);
@@ -237,9 +239,9 @@ TEST_CASE("Expressions", "[parser]") {
     REQUIRE(rl.type == ExpressionType::FUNCTION_CALL);
     REQUIRE(rl.funcCall);
     REQUIRE(tokenizer.extractToken(rl.funcCall->name) == "function");
-    CHECK(rl.funcCall->args.next == nullptr);
-    REQUIRE(rl.funcCall->args.curr.type == ExpressionType::VALUE);
-    CHECK(tokenizer.extractToken(rl.funcCall->args.curr.value) == "var");
+    REQUIRE(rl.funcCall->args.size() == 1);
+    REQUIRE(rl.funcCall->args[0].type == ExpressionType::VALUE);
+    CHECK(tokenizer.extractToken(rl.funcCall->args[0].value) == "var");
 
     auto& rr = binOp->leftSide.binOp->leftSide;
     CHECK(rr.type == ExpressionType::VALUE);
@@ -633,15 +635,15 @@ TEST_CASE("Struct Declaration", "[parser]") {
     parser.parse();
     REQUIRE(parser.expected.empty());
     REQUIRE(parser.unexpected.empty());
-    auto& s = parser.program.decs;
-    REQUIRE(s.curr.type == GeneralDecType::STRUCT);
-    REQUIRE(s.curr.structDec);
-    CHECK(tokenizer.extractToken(s.curr.structDec->name) == "sName");
-    auto& sd = s.curr.structDec->decs;
-    CHECK(sd.type == StructDecType::FUNC);
-    REQUIRE(sd.next);
-    CHECK(sd.next->type  == StructDecType::VAR);
-    CHECK(sd.next->next == nullptr);
+    REQUIRE(parser.program.decs.size() == 1);
+    auto& s = *parser.program.decs[0];
+    REQUIRE(s.type == GeneralDecType::STRUCT);
+    REQUIRE(s.structDec);
+    CHECK(tokenizer.extractToken(s.structDec->name) == "sName");
+    auto& sd = s.structDec->decs;
+    REQUIRE(sd.size() == 2);
+    CHECK(sd[0].type == StructDecType::FUNC);
+    CHECK(sd[1].type == StructDecType::VAR);
   }
 }
 
@@ -655,17 +657,16 @@ TEST_CASE("Template Declaration", "[parser]") {
   parser.parse();
   REQUIRE(parser.unexpected.empty());
   REQUIRE(parser.expected.empty());
-  auto& t = parser.program.decs.curr;
+  REQUIRE(parser.program.decs.size() == 1);
+  auto& t = *parser.program.decs[0];
   REQUIRE(t.type == GeneralDecType::TEMPLATE);
   REQUIRE(t.tempDec);
   CHECK(tokenizer.extractToken(t.tempDec->templateTypes.token) == "T");
 
   CHECK(t.tempDec->templateTypes.next == nullptr);
-  CHECK(parser.program.decs.next == nullptr);
 
   REQUIRE_FALSE(t.tempDec->isStruct);
-  REQUIRE(t.tempDec->funcDec.body.scopeStatements.next);
-  CHECK(t.tempDec->funcDec.body.scopeStatements.next->next == nullptr);
+  CHECK(t.tempDec->funcDec.body.scopeStatements.size() == 2);
 }
 
 TEST_CASE("Variable Declaration", "[parser]") {
@@ -675,8 +676,8 @@ TEST_CASE("Variable Declaration", "[parser]") {
   parser.parse();
   REQUIRE(parser.expected.empty());
   REQUIRE(parser.unexpected.empty());
-  CHECK(parser.program.decs.next == nullptr);
-  CHECK(parser.program.decs.curr.type == GeneralDecType::VARIABLE);
+  REQUIRE(parser.program.decs.size() == 1);
+  CHECK(parser.program.decs[0]->type == GeneralDecType::VARIABLE);
 }
 
 TEST_CASE("Keywords", "[parser]") {
@@ -726,8 +727,8 @@ TEST_CASE("Keywords", "[parser]") {
     CHECK(forLoop->initialize.type == StatementType::VARIABLE_DEC);
     CHECK(forLoop->condition.type == ExpressionType::BINARY_OP);
     CHECK(forLoop->iteration.type == ExpressionType::UNARY_OP);
-    CHECK(forLoop->body.scopeStatements.curr.type == StatementType::EXPRESSION);
-    CHECK(forLoop->body.scopeStatements.next == nullptr);
+    REQUIRE(forLoop->body.scopeStatements.size() == 1);
+    CHECK(forLoop->body.scopeStatements[0].type == StatementType::EXPRESSION);
   }
 }
 
@@ -750,3 +751,230 @@ TEST_CASE("Switch Statement", "[parser]") {
   CHECK(parser.expected.empty());
   CHECK(parser.unexpected.empty());
 }
+
+
+TEST_CASE("Nesting Limit", "[parser]") {
+  { // nested scopes past the limit
+    std::string str = "func f(): void ";
+    str += std::string(20, '{') + std::string(20, '}');
+    Tokenizer tokenizer{"./src/parser/test_parser.cpp", str};
+    Parser parser{tokenizer, memPool};
+    parser.maxNestingDepth = 10;
+    CHECK_FALSE(parser.parse());
+    REQUIRE(parser.nestingTooDeep.size() == 1);
+    CHECK(parser.nestingTooDeep[0].limit == 10);
+    CHECK(parser.nestingDepth == 0);
+  }
+
+  { // nested parentheses past the limit
+    std::string str = std::string(20, '(') + "x" + std::string(20, ')') + ';';
+    Tokenizer tokenizer{"./src/parser/test_parser.cpp", str};
+    Parser parser{tokenizer, memPool};
+    parser.maxNestingDepth = 10;
+    Statement statement;
+    CHECK(parser.parseStatement(statement) == ParseStatementErrorType::REPORTED);
+    REQUIRE(parser.nestingTooDeep.size() == 1);
+    CHECK(parser.nestingTooDeep[0].token.position == 10);
+    CHECK(parser.nestingDepth == 0);
+  }
+
+  { // nested literals past the limit report the nesting once, not a missing bracket for every level
+    std::string str = "func f(): void { x: int32 = " + std::string(20, '[') + "1" + std::string(20, ']') + "; }";
+    Tokenizer tokenizer{"./src/parser/test_parser.cpp", str};
+    Parser parser{tokenizer, memPool};
+    parser.maxNestingDepth = 10;
+    CHECK_FALSE(parser.parse());
+    CHECK(parser.nestingTooDeep.size() == 1);
+    CHECK(parser.expected.empty());
+    CHECK(parser.nestingDepth == 0);
+  }
+
+  { // chains of binary operators are not limited, including ones with unary operators in their terms
+    std::string str = "func f(): int32 { return x";
+    for (uint32_t i = 0; i < 5000; ++i) {
+      str += i % 2 ? " + x" : " * -x";
+    }
+    str += "; }";
+    Tokenizer tokenizer{"./src/parser/test_parser.cpp", str};
+    Parser parser{tokenizer, memPool};
+    parser.maxNestingDepth = 10;
+    CHECK(parser.parse());
+    CHECK(parser.nestingTooDeep.empty());
+    CHECK(parser.nestingDepth == 0);
+  }
+
+  { // unary operators in a row nest their operand
+    std::string str = "func f(): int32 { return ";
+    for (uint32_t i = 0; i < 20; ++i) {
+      str += "- ";
+    }
+    str += "x; }";
+    Tokenizer tokenizer{"./src/parser/test_parser.cpp", str};
+    Parser parser{tokenizer, memPool};
+    parser.maxNestingDepth = 10;
+    CHECK_FALSE(parser.parse());
+    REQUIRE(parser.nestingTooDeep.size() == 1);
+    CHECK(parser.nestingTooDeep[0].token.type == TokenType::NEGATIVE);
+    CHECK(parser.nestingDepth == 0);
+  }
+
+  { // nesting within the default limit
+    std::string str = "func f(): void ";
+    str += std::string(200, '{') + std::string(200, '(') + "x" + std::string(200, ')') + ';' + std::string(200, '}');
+    Tokenizer tokenizer{"./src/parser/test_parser.cpp", str};
+    Parser parser{tokenizer, memPool};
+    CHECK(parser.parse());
+    CHECK(parser.nestingTooDeep.empty());
+    CHECK(parser.expected.empty());
+    CHECK(parser.unexpected.empty());
+  }
+}
+
+TEST_CASE("Error Recovery", "[parser]") {
+  { // errors in statements, struct members and function headers are all reported
+    const std::string str =
+R"(func a(): int32 {
+  x: int32 = 1 +;
+  y = 2 3;
+  if (x) {
+    z: int32 = ;
+  }
+  return x;
+}
+struct s {
+  m: int32
+  n: int32;
+}
+func b(: int32 {
+  return 0;
+}
+g: int32 = 4;
+)";
+    Tokenizer tokenizer{"./src/parser/test_parser.cpp", str};
+    Parser parser{tokenizer, memPool};
+    CHECK_FALSE(parser.parse());
+    CHECK(parser.unexpected.empty());
+    REQUIRE(parser.expected.size() == 5);
+    CHECK(parser.expected[0].expectedType == ExpectedType::EXPRESSION);
+    CHECK(parser.expected[1].expectedTokenType == TokenType::SEMICOLON);
+    CHECK(parser.expected[2].expectedType == ExpectedType::EXPRESSION);
+    CHECK(parser.expected[3].expectedTokenType == TokenType::SEMICOLON);
+    CHECK(parser.expected[4].expectedTokenType == TokenType::IDENTIFIER);
+
+    // bad statements are kept as error nodes
+    REQUIRE(parser.program.decs.size() == 3);
+    auto& func = *parser.program.decs[0];
+    REQUIRE(func.type == GeneralDecType::FUNCTION);
+    StatementList& statements = func.funcDec->body.scopeStatements;
+    REQUIRE(statements.size() == 4);
+    CHECK(statements[0].type == StatementType::ERROR);
+    CHECK(statements[1].type == StatementType::ERROR);
+    CHECK(statements[2].type == StatementType::CONTROL_FLOW);
+    CHECK(statements[3].type == StatementType::CONTROL_FLOW);
+
+    // parsing continued after the bad function header
+    CHECK(parser.program.decs[1]->type == GeneralDecType::STRUCT);
+    CHECK(parser.program.decs[2]->type == GeneralDecType::VARIABLE);
+  }
+
+  { // missing close brace is resynchronized at the next function
+    const std::string str = "func a(): void { x = 1; func b(): void { y = ; }";
+    Tokenizer tokenizer{"./src/parser/test_parser.cpp", str};
+    Parser parser{tokenizer, memPool};
+    CHECK_FALSE(parser.parse());
+    REQUIRE(parser.unexpected.size() == 1);
+    CHECK(parser.unexpected[0].token.type == TokenType::FUNC);
+    REQUIRE(parser.expected.size() == 1);
+    CHECK(parser.expected[0].expectedType == ExpectedType::EXPRESSION);
+  }
+
+  { // an error in a struct member does not end the struct at the next member function
+    const std::string str = "struct s {\n  m: int32 = ;\n  func g(): void { }\n  n: int32;\n  func h(: void { }\n  o: int32;\n}\n";
+    Tokenizer tokenizer{"./src/parser/test_parser.cpp", str};
+    Parser parser{tokenizer, memPool};
+    CHECK_FALSE(parser.parse());
+    CHECK(parser.unexpected.empty());
+    REQUIRE(parser.expected.size() == 2);
+    CHECK(parser.expected[0].expectedType == ExpectedType::EXPRESSION);
+    CHECK(parser.expected[1].expectedTokenType == TokenType::IDENTIFIER);
+    REQUIRE(parser.program.decs.size() == 1);
+    REQUIRE(parser.program.decs[0]->type == GeneralDecType::STRUCT);
+    CHECK(parser.program.decs[0]->structDec->decs.size() == 4);
+  }
+
+  { // messages of all kinds of errors are merged into source order
+    const std::string str = "func a(): void { x = ; }\n) \nfunc b(): void { y = 1 2; }\nfunc c(): int32 { if (c) x }\n";
+    std::vector<Tokenizer> tokenizers;
+    tokenizers.emplace_back("./src/parser/test_parser.cpp", str);
+    Parser parser{tokenizers[0], memPool};
+    CHECK_FALSE(parser.parse());
+    CHECK(parser.unexpected.size() == 1);
+    CHECK(parser.expected.size() == 3);
+    const std::string messages = parser.getErrorMessages(tokenizers);
+    const size_t first = messages.find("test_parser.cpp:1:");
+    const size_t second = messages.find("test_parser.cpp:2:");
+    const size_t third = messages.find("test_parser.cpp:3:");
+    const size_t fourth = messages.find("test_parser.cpp:4:");
+    REQUIRE(fourth != std::string::npos);
+    CHECK(first < second);
+    CHECK(second < third);
+    CHECK(third < fourth);
+    CHECK(messages.find("Expected Token: operator") != std::string::npos);
+  }
+
+  { // a literal missing its closing bracket is reported where the bracket was expected
+    const std::string str = "func a(): void { x: int32[2] = [1, 2 ; }";
+    std::vector<Tokenizer> tokenizers;
+    tokenizers.emplace_back("./src/parser/test_parser.cpp", str);
+    Parser parser{tokenizers[0], memPool};
+    CHECK_FALSE(parser.parse());
+    REQUIRE_FALSE(parser.expected.empty());
+    CHECK(parser.expected[0].tokenWhereExpected.position != 0);
+    CHECK(parser.getErrorMessages(tokenizers).find("test_parser.cpp:1:1\n") == std::string::npos);
+  }
+
+  { // errors at a token that was never set have no location, so they come after the ones that do
+    const std::string str = "func a(): void { x = ; }\n";
+    std::vector<Tokenizer> tokenizers;
+    tokenizers.emplace_back("./src/parser/test_parser.cpp", str);
+    Parser parser{tokenizers[0], memPool};
+    CHECK_FALSE(parser.parse());
+    parser.expected.insert(parser.expected.begin(), Expected{ExpectedType::EXPRESSION, Token{0, 0, TokenType::NOTHING}});
+    const std::string messages = parser.getErrorMessages(tokenizers);
+    const size_t located = messages.find("test_parser.cpp:1:22");
+    const size_t unlocated = messages.find("test_parser.cpp:1:1\n");
+    REQUIRE(located != std::string::npos);
+    REQUIRE(unlocated != std::string::npos);
+    CHECK(located < unlocated);
+  }
+
+  { // a broken declaration at the end of the file is not returned again at the end of file
+    const std::string str = "func a(): void { }\nfunc b(: int32 { return 0; }";
+    Tokenizer tokenizer{"./src/parser/test_parser.cpp", str};
+    Parser parser{tokenizer, memPool};
+    REQUIRE(parser.parseNext());
+    CHECK_FALSE(parser.parseNext());
+    parser.synchronizeGlobal();
+    GeneralDec *dec = parser.parseNext();
+    REQUIRE(dec);
+    CHECK(dec->type == GeneralDecType::NOTHING);
+    CHECK(parser.program.decs.size() == 1);
+  }
+
+  { // nodes of failed declarations are given back, so a file full of them does not grow the pool
+    std::string str;
+    for (uint32_t i = 0; i < 5000; ++i) {
+      str += "func f(a: int32): int32 { return a + b * c + d(e, f) + g[h]; if (a) { x: int32 = (a + 1) * 2;\n";
+    }
+    Tokenizer tokenizer{"./src/parser/test_parser.cpp", str};
+    NodeMemPool pool;
+    Parser parser{tokenizer, pool};
+    CHECK_FALSE(parser.parse());
+    CHECK(parser.program.decs.empty());
+    CHECK(parser.unexpected.size() + parser.expected.size() == 5000);
+    CHECK(pool.retainedBytes() == 1 << 12);
+    // end of file after the failed declarations
+    REQUIRE(parser.parseNext());
+    CHECK(parser.current->type == GeneralDecType::NOTHING);
+  }
+}
@@ -8,9 +8,6 @@ void TokenList::prettyPrint(Tokenizer& tk, std::string& str) {
   }
   std::vector<TokenList *> r;
   for (TokenList *iter = this; iter; iter = iter->next) {
-    if (iter->token.type == TokenType::DEC_PTR) {
-      break;
-    }
     r.emplace_back(iter);
   }
   if (!r.empty()) {
@@ -50,6 +47,7 @@ void Statement::prettyPrint(Tokenizer& tk, std::string& str, uint32_t indentatio
       varDec->prettyPrint(tk, str); break;
     case StatementType::KEYWORD: str += typeToString.at(keyword.type); break;
     case StatementType::NOTHING: break;
+    case StatementType::ERROR: str += "{syntax error}"; break;
     default: str += "{not yet implemented in pretty printer}"; break;
   }
 }
@@ -72,13 +70,11 @@ void BinOp::prettyPrint(Tokenizer& tk, std::string& str ) {
 
 void FunctionCall::prettyPrint(Tokenizer& tk, std::string& str) {
   str += tk.extractToken(name) + '(';
-  if (args.curr.type != ExpressionType::NONE) {
-    ExpressionList * iter = &args;
-    for (; iter->next; iter = iter->next) {
-      iter->curr.prettyPrint(tk, str);
+  for (uint32_t i = 0; i < args.size(); ++i) {
+    if (i > 0) {
       str += ", ";
     }
-    iter->curr.prettyPrint(tk, str);
+    args[i].prettyPrint(tk, str);
   }
   str += ')';
 }
@@ -91,13 +87,13 @@ void ArrayAccess::prettyPrint(Tokenizer& tk, std::string& str) {
 
 void Scope::prettyPrint(Tokenizer& tk, std::string& str, uint32_t indentation) {
   str += "{\n";
-  if (scopeStatements.curr.type != StatementType::NOTHING) {
+  if (!scopeStatements.empty()) {
     indentation += indentationSize;
-    for (StatementList *iter = &scopeStatements; iter; iter = iter->next) {
-      if (iter->curr.type != StatementType::NOTHING) {
+    for (Statement& statement : scopeStatements) {
+      if (statement.type != StatementType::NOTHING) {
         str += std::string(indentation, ' ');
-        iter->curr.prettyPrint(tk, str, indentation);
-        if (iter->curr.type != StatementType::SCOPE && (iter->curr.type != StatementType::CONTROL_FLOW || iter->curr.controlFlow->type == ControlFlowStatementType::RETURN_STATEMENT)) {
+        statement.prettyPrint(tk, str, indentation);
+        if (statement.type != StatementType::SCOPE && (statement.type != StatementType::CONTROL_FLOW || statement.controlFlow->type == ControlFlowStatementType::RETURN_STATEMENT)) {
           str += ";\n";
         }
       }
@@ -110,13 +106,11 @@ void Scope::prettyPrint(Tokenizer& tk, std::string& str, uint32_t indentation) {
 void FunctionDec::prettyPrintDefinition(Tokenizer& tk, std::string& str) {
   str += typeToString.at(TokenType::FUNC);
   str += tk.extractToken(name) + '(';
-  if (params.curr.type != StatementType::NOTHING) {
-    StatementList * iter = &params;
-    for (; iter->next; iter = iter->next) {
-      iter->curr.prettyPrint(tk, str, indentationSize);
+  for (uint32_t i = 0; i < params.size(); ++i) {
+    if (i > 0) {
       str += ", ";
     }
-    iter->curr.prettyPrint(tk, str, indentationSize);
+    params[i].prettyPrint(tk, str, indentationSize);
   }
   str += "): ";
   returnType.prettyPrint(tk, str);
@@ -125,15 +119,11 @@ void FunctionDec::prettyPrintDefinition(Tokenizer& tk, std::string& str) {
 void FunctionDec::prettyPrint(Tokenizer& tk, std::string& str, uint32_t indentation) {
   str += typeToString.at(TokenType::FUNC);
   str += tk.extractToken(name) + '(';
-  if (params.curr.type != StatementType::NOTHING) {
-    indentation += indentationSize;
-    StatementList * iter = &params;
-    for (; iter->next; iter = iter->next) {
-      iter->curr.prettyPrint(tk, str, indentation);
+  for (uint32_t i = 0; i < params.size(); ++i) {
+    if (i > 0) {
       str += ", ";
     }
-    iter->curr.prettyPrint(tk, str, indentation);
-    indentation -= indentationSize;
+    params[i].prettyPrint(tk, str, indentation + indentationSize);
   }
   str += "): ";
   returnType.prettyPrint(tk, str);
@@ -155,7 +145,7 @@ void GeneralDec::prettyPrintDefinition(std::vector<Tokenizer>& tks, std::string&
   if (type == GeneralDecType::NOTHING) {
     return;
   }
-  Tokenizer& tk = tks[tokenizerIndex];
+  Tokenizer& tk = tokenizerAt(tks, location());
   switch (type) {
     case GeneralDecType::FUNCTION:
       funcDec->prettyPrintDefinition(tk, str); break;
@@ -177,7 +167,7 @@ void GeneralDec::prettyPrint(std::vector<Tokenizer>& tks, std::string& str) {
   if (type == GeneralDecType::NOTHING) {
     return;
   }
-  Tokenizer& tk = tks[tokenizerIndex];
+  Tokenizer& tk = tokenizerAt(tks, location());
   switch (type) {
     case GeneralDecType::FUNCTION:
       funcDec->prettyPrint(tk, str, 0); break;
@@ -193,14 +183,6 @@ void GeneralDec::prettyPrint(std::vector<Tokenizer>& tks, std::string& str) {
   }
 }
 
-void GeneralDecList::prettyPrint(std::vector<Tokenizer>& tk, std::string& str) {
-  GeneralDecList*list = this;
-  for (; list->next; list = list->next) {
-    list->curr.prettyPrint(tk, str);
-    str += '\n';
-  }
-  list->curr.prettyPrint(tk, str);
-}
 
 void StructDec::prettyPrintDefinition(Tokenizer& tk, std::string& str) {
   str += typeToString.at(TokenType::STRUCT) + tk.extractToken(name);
@@ -209,12 +191,12 @@ void StructDec::prettyPrintDefinition(Tokenizer& tk, std::string& str) {
 void StructDec::prettyPrint(Tokenizer& tk, std::string& str, uint32_t indentation) {
   str += typeToString.at(TokenType::STRUCT) + tk.extractToken(name) + " {\n";
   indentation += indentationSize;
-  for (StructDecList* list = &decs; list; list = list->next) {
+  for (StructMember& member : decs) {
     str += std::string(indentation, ' ');
-    if (list->type == StructDecType::FUNC) {
-      list->funcDec->prettyPrint(tk, str, indentation);
-    } else if (list->type == StructDecType::VAR) {
-      list->varDec->prettyPrint(tk, str);
+    if (member.type == StructDecType::FUNC) {
+      member.funcDec->prettyPrint(tk, str, indentation);
+    } else if (member.type == StructDecType::VAR) {
+      member.varDec->prettyPrint(tk, str);
       str += ";\n";
     } 
   }
@@ -259,7 +241,12 @@ void TemplateDec::prettyPrint(Tokenizer& tk, std::string& str, uint32_t indentat
 }
 
 void Program::prettyPrint(std::vector<Tokenizer>& tk, std::string& str) {
-  decs.prettyPrint(tk, str);
+  for (uint32_t i = 0; i < decs.size(); ++i) {
+    if (i > 0) {
+      str += '\n';
+    }
+    decs[i]->prettyPrint(tk, str);
+  }
 }
 
 void Expression::prettyPrint(Tokenizer& tk, std::string& str) {
@@ -281,12 +268,12 @@ void Expression::prettyPrint(Tokenizer& tk, std::string& str) {
 
 void ArrayOrStructLiteral::prettyPrint(Tokenizer& tk, std::string& str) {
   str += '[';
-  ExpressionList*list = &values;
-  for (; list->next; list = list->next) {
-    list->curr.prettyPrint(tk ,str);
-    str += ", ";
+  for (uint32_t i = 0; i < values.size(); ++i) {
+    if (i > 0) {
+      str += ", ";
+    }
+    values[i].prettyPrint(tk, str);
   }
-  list->curr.prettyPrint(tk, str);
   str += ']';
 }
 
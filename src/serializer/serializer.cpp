@@ -0,0 +1,771 @@
+#include "serializer.hpp"
+#include "../parser/parser.hpp"
+#include <fstream>
+#include <cstring>
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// FNV-1a
+uint64_t hashSource(const std::string& source) {
+  uint64_t hash = 0xcbf29ce484222325;
+  for (const char c : source) {
+    hash ^= (uint8_t)c;
+    hash *= 0x100000001b3;
+  }
+  return hash;
+}
+
+std::string modulePath(const std::string& sourcePath) {
+  if (sourcePath.size() > 3 && sourcePath.compare(sourcePath.size() - 3, 3, ".pr") == 0) {
+    return sourcePath + 'm';
+  }
+  return sourcePath + ".prm";
+}
+
+///////////////////////////////////////
+//              writing              //
+///////////////////////////////////////
+
+/**
+ * Appends nodes to the node stream in pre-order.
+ * Tokens take two words: offset within the file, then length and type
+*/
+struct ModuleWriter {
+  std::vector<uint32_t>& words;
+  const uint32_t baseLocation;
+  bool valid{true};
+  std::vector<const BinOp *> operatorChain; // binary operators whose right side is still to be written
+
+  ModuleWriter(std::vector<uint32_t>& words, uint32_t baseLocation): words{words}, baseLocation{baseLocation} {}
+
+  void word(uint32_t value) {
+    words.push_back(value);
+  }
+
+  void token(const Token& tk) {
+    words.push_back(tk.position - baseLocation);
+    words.push_back((uint32_t)tk.length | (uint32_t)tk.type << 16);
+  }
+
+  void tokenList(const TokenList& list) {
+    size_t countIndex = words.size();
+    word(0);
+    uint32_t count = 0;
+    for (const TokenList *iter = &list; iter; iter = iter->next) {
+      token(iter->token);
+      ++count;
+    }
+    words[countIndex] = count;
+  }
+
+  void expressionList(const ExpressionList& list) {
+    word(list.size());
+    for (const Expression& exp : list) {
+      expression(exp);
+    }
+  }
+
+  /**
+   * Chains of binary operators lean left and are as long as the expression, so their left sides are written in a loop.
+   * The encoding is the same pre-order as recursing: each operator, then its left side, then its right side
+  */
+  void expression(const Expression& root) {
+    const size_t chainStart = operatorChain.size();
+    const Expression *leftmost = &root;
+    while (leftmost->type == ExpressionType::BINARY_OP) {
+      word((uint32_t)ExpressionType::BINARY_OP);
+      token(leftmost->binOp->op);
+      operatorChain.push_back(leftmost->binOp);
+      leftmost = &leftmost->binOp->leftSide;
+    }
+    operand(*leftmost);
+    while (operatorChain.size() > chainStart) {
+      const BinOp *binOp = operatorChain.back();
+      operatorChain.pop_back();
+      expression(binOp->rightSide);
+    }
+  }
+
+  void operand(const Expression& exp) {
+    word((uint32_t)exp.type);
+    switch (exp.type) {
+      case ExpressionType::NONE: break;
+      case ExpressionType::UNARY_OP:
+        token(exp.unOp->op);
+        expression(exp.unOp->operand);
+        break;
+      case ExpressionType::VALUE: token(exp.value); break;
+      case ExpressionType::FUNCTION_CALL:
+        token(exp.funcCall->name);
+        expressionList(exp.funcCall->args);
+        break;
+      case ExpressionType::ARRAY_ACCESS:
+        token(exp.arrAccess->array);
+        expression(exp.arrAccess->offset);
+        break;
+      case ExpressionType::WRAPPED: expression(*exp.wrapped); break;
+      case ExpressionType::ARRAY_OR_STRUCT_LITERAL: expressionList(exp.arrayOrStruct->values); break;
+      default: valid = false; break;
+    }
+  }
+
+  void variableDec(const VariableDec& varDec) {
+    token(varDec.name);
+    tokenList(varDec.type);
+    word(varDec.initialAssignment != nullptr);
+    if (varDec.initialAssignment) {
+      expression(*varDec.initialAssignment);
+    }
+  }
+
+  void statementList(const StatementList& list) {
+    word(list.size());
+    for (const Statement& st : list) {
+      statement(st);
+    }
+  }
+
+  void ifStatement(const IfStatement& ifStatement) {
+    expression(ifStatement.condition);
+    statementList(ifStatement.body.scopeStatements);
+  }
+
+  void statement(const Statement& st) {
+    word((uint32_t)st.type);
+    switch (st.type) {
+      case StatementType::NOTHING: break;
+      case StatementType::EXPRESSION: expression(*st.expression); break;
+      case StatementType::CONTROL_FLOW: controlFlow(*st.controlFlow); break;
+      case StatementType::SCOPE: statementList(st.scope->scopeStatements); break;
+      case StatementType::VARIABLE_DEC: variableDec(*st.varDec); break;
+      case StatementType::KEYWORD: token(st.keyword); break;
+      case StatementType::ERROR: token(st.errorStart); break;
+      default: valid = false; break;
+    }
+  }
+
+  void controlFlow(const ControlFlowStatement& cf) {
+    word((uint32_t)cf.type);
+    switch (cf.type) {
+      case ControlFlowStatementType::NONE: break;
+      case ControlFlowStatementType::FOR_LOOP:
+        statement(cf.forLoop->initialize);
+        expression(cf.forLoop->condition);
+        expression(cf.forLoop->iteration);
+        statementList(cf.forLoop->body.scopeStatements);
+        break;
+      case ControlFlowStatementType::WHILE_LOOP: ifStatement(cf.whileLoop->statement); break;
+      case ControlFlowStatementType::CONDITIONAL_STATEMENT: {
+        const ConditionalStatement& cond = *cf.conditional;
+        ifStatement(cond.ifStatement);
+        size_t countIndex = words.size();
+        word(0);
+        uint32_t count = 0;
+        for (const ElifStatementList *iter = cond.elifStatement; iter; iter = iter->next) {
+          ifStatement(iter->elif);
+          ++count;
+        }
+        words[countIndex] = count;
+        word(cond.elseStatement != nullptr);
+        if (cond.elseStatement) {
+          statementList(cond.elseStatement->scopeStatements);
+        }
+        break;
+      }
+      case ControlFlowStatementType::RETURN_STATEMENT:
+        token(cf.returnStatement->token);
+        expression(cf.returnStatement->returnValue);
+        break;
+      case ControlFlowStatementType::SWITCH_STATEMENT: {
+        expression(cf.switchStatement->switched);
+        size_t countIndex = words.size();
+        word(0);
+        uint32_t count = 0;
+        for (const SwitchScopeStatementList *iter = &cf.switchStatement->body; iter; iter = iter->next) {
+          word(iter->caseExpression != nullptr);
+          if (iter->caseExpression) {
+            expression(*iter->caseExpression);
+          }
+          word(iter->caseBody != nullptr);
+          if (iter->caseBody) {
+            statementList(iter->caseBody->scopeStatements);
+          }
+          ++count;
+        }
+        words[countIndex] = count;
+        break;
+      }
+      default: valid = false; break;
+    }
+  }
+
+  void functionDec(const FunctionDec& funcDec) {
+    token(funcDec.name);
+    statementList(funcDec.params);
+    tokenList(funcDec.returnType);
+    statementList(funcDec.body.scopeStatements);
+  }
+
+  void structDec(const StructDec& structDec) {
+    token(structDec.name);
+    word(structDec.decs.size());
+    for (const StructMember& member : structDec.decs) {
+      word((uint32_t)member.type);
+      if (member.type == StructDecType::VAR) {
+        variableDec(*member.varDec);
+      } else if (member.type == StructDecType::FUNC) {
+        functionDec(*member.funcDec);
+      }
+    }
+  }
+
+  void generalDec(const GeneralDec& dec) {
+    word((uint32_t)dec.type);
+    switch (dec.type) {
+      case GeneralDecType::NOTHING: break;
+      case GeneralDecType::STRUCT: structDec(*dec.structDec); break;
+      case GeneralDecType::VARIABLE: variableDec(*dec.varDec); break;
+      case GeneralDecType::FUNCTION: functionDec(*dec.funcDec); break;
+      case GeneralDecType::TEMPLATE:
+        tokenList(dec.tempDec->templateTypes);
+        token(dec.tempDec->token);
+        word(dec.tempDec->isStruct);
+        if (dec.tempDec->isStruct) {
+          structDec(dec.tempDec->structDec);
+        } else {
+          functionDec(dec.tempDec->funcDec);
+        }
+        break;
+      case GeneralDecType::TEMPLATE_CREATE:
+        token(dec.tempCreate->templateName);
+        tokenList(dec.tempCreate->templateTypes);
+        token(dec.tempCreate->typeName);
+        break;
+      case GeneralDecType::INCLUDE_DEC: token(dec.includeDec->file); break;
+      default: valid = false; break;
+    }
+  }
+};
+
+bool serializeModule(Tokenizer& tk, const std::vector<GeneralDec *>& decs, std::string& out) {
+  std::vector<uint32_t> words((uint32_t)ModuleHeaderField::SIZE, 0);
+  const uint64_t hash = hashSource(tk.content);
+  words[(uint32_t)ModuleHeaderField::MAGIC] = moduleMagic;
+  words[(uint32_t)ModuleHeaderField::VERSION] = moduleVersion;
+  words[(uint32_t)ModuleHeaderField::HASH_LOW] = (uint32_t)hash;
+  words[(uint32_t)ModuleHeaderField::HASH_HIGH] = (uint32_t)(hash >> 32);
+  words[(uint32_t)ModuleHeaderField::SOURCE_SIZE] = tk.content.size();
+
+  words[(uint32_t)ModuleHeaderField::NEWLINE_COUNT] = tk.newlinePositions.size();
+  words[(uint32_t)ModuleHeaderField::NEWLINE_OFFSET] = words.size();
+  words.insert(words.end(), tk.newlinePositions.begin(), tk.newlinePositions.end());
+
+  words[(uint32_t)ModuleHeaderField::DEC_COUNT] = decs.size();
+  const size_t decTableOffset = words.size();
+  words[(uint32_t)ModuleHeaderField::DEC_TABLE_OFFSET] = decTableOffset;
+  words.resize(words.size() + decs.size());
+
+  const size_t nodesOffset = words.size();
+  words[(uint32_t)ModuleHeaderField::NODES_OFFSET] = nodesOffset;
+  ModuleWriter writer{words, tk.baseLocation};
+  for (size_t i = 0; i < decs.size(); ++i) {
+    words[decTableOffset + i] = words.size() - nodesOffset;
+    writer.generalDec(*decs[i]);
+  }
+  if (!writer.valid || words.size() > UINT32_MAX) {
+    return false;
+  }
+  words[(uint32_t)ModuleHeaderField::NODES_SIZE] = words.size() - nodesOffset;
+  out.assign((const char *)words.data(), words.size() * sizeof (uint32_t));
+  return true;
+}
+
+bool writeModuleFile(const std::string& path, const std::string& bytes) {
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  if (!file.is_open()) {
+    return false;
+  }
+  file.write(bytes.data(), bytes.size());
+  return file.good();
+}
+
+///////////////////////////////////////
+//              reading              //
+///////////////////////////////////////
+
+/**
+ * Rebuilds nodes from the node stream into the memory pool.
+ * Every read is bounds checked, tokens must lie within the source and have a known type,
+ * and nodes can't nest deeper than maxDepth; a truncated or corrupt stream sets valid to false
+*/
+struct ModuleReader {
+  const uint32_t *curr;
+  const uint32_t *end;
+  NodeMemPool& mem;
+  const uint32_t baseLocation;
+  const uint32_t sourceSize;
+  bool valid{true};
+  std::vector<BinOp *> operatorChain; // binary operators whose right side is still to be read
+  uint32_t depth{0};
+
+  // a parsed module nests at most defaultMaxNestingDepth levels, and within each level the right sides of operators
+  // only nest once per operator precedence. anything deeper is corrupt, and would overflow the stack
+  static constexpr uint32_t maxDepth = defaultMaxNestingDepth * 16;
+
+  /**
+   * Counts one level of recursion for its lifetime, the stream is invalid past maxDepth
+  */
+  struct DepthGuard {
+    ModuleReader& reader;
+    explicit DepthGuard(ModuleReader& reader): reader{reader} {
+      if (++reader.depth > maxDepth) {
+        reader.valid = false;
+      }
+    }
+    DepthGuard(const DepthGuard&) = delete;
+    ~DepthGuard() { --reader.depth; }
+  };
+
+  ModuleReader(const uint32_t *begin, const uint32_t *end, NodeMemPool& mem, uint32_t baseLocation, uint32_t sourceSize):
+    curr{begin}, end{end}, mem{mem}, baseLocation{baseLocation}, sourceSize{sourceSize} {}
+
+  uint32_t word() {
+    if (curr >= end) {
+      valid = false;
+      return 0;
+    }
+    return *curr++;
+  }
+
+  Token token() {
+    const uint32_t offset = word();
+    const uint32_t lengthAndType = word();
+    const uint16_t length = (uint16_t)lengthAndType;
+    if ((lengthAndType >> 16) > (uint32_t)TokenType::OPERATOR) {
+      valid = false;
+      return Token{};
+    }
+    const TokenType type = (TokenType)(lengthAndType >> 16);
+    // empty tokens are not in the source, their position is kept as written
+    if (type != TokenType::NOTHING && (uint64_t)offset + length > sourceSize) {
+      valid = false;
+      return Token{};
+    }
+    return Token{baseLocation + offset, length, type};
+  }
+
+  void tokenList(TokenList& list) {
+    const uint32_t count = word();
+    if (count == 0) {
+      return;
+    }
+    list.token = token();
+    TokenList *iter = &list;
+    for (uint32_t i = 1; i < count && valid; ++i) {
+      iter->next = mem.makeTokenList();
+      iter = iter->next;
+      iter->token = token();
+    }
+  }
+
+  // every element takes at least one word, which bounds the size of a corrupt count
+  uint32_t listCount() {
+    const uint32_t count = word();
+    if (count > (uint32_t)(end - curr)) {
+      valid = false;
+      return 0;
+    }
+    return count;
+  }
+
+  void expressionList(ExpressionList& list) {
+    list = mem.makeSpan<Expression>(listCount());
+    for (uint32_t i = 0; i < list.size() && valid; ++i) {
+      expression(list[i]);
+    }
+  }
+
+  // reads the left sides of a chain of binary operators in a loop, see ModuleWriter::expression
+  void expression(Expression& root) {
+    DepthGuard guard{*this};
+    if (!valid) {
+      return;
+    }
+    const size_t chainStart = operatorChain.size();
+    Expression *leftmost = &root;
+    ExpressionType type = (ExpressionType)word();
+    while (type == ExpressionType::BINARY_OP && valid) {
+      leftmost->type = type;
+      leftmost->binOp = mem.make<BinOp>(token());
+      operatorChain.push_back(leftmost->binOp);
+      leftmost = &leftmost->binOp->leftSide;
+      type = (ExpressionType)word();
+    }
+    operand(*leftmost, type);
+    while (operatorChain.size() > chainStart) {
+      BinOp *binOp = operatorChain.back();
+      operatorChain.pop_back();
+      if (valid) {
+        expression(binOp->rightSide);
+      }
+    }
+  }
+
+  void operand(Expression& exp, ExpressionType type) {
+    exp.type = type;
+    switch (exp.type) {
+      case ExpressionType::NONE: break;
+      case ExpressionType::UNARY_OP:
+        exp.unOp = mem.make<UnOp>(token());
+        expression(exp.unOp->operand);
+        break;
+      case ExpressionType::VALUE: exp.value = token(); break;
+      case ExpressionType::FUNCTION_CALL:
+        exp.funcCall = mem.make<FunctionCall>(token());
+        expressionList(exp.funcCall->args);
+        break;
+      case ExpressionType::ARRAY_ACCESS:
+        exp.arrAccess = mem.make<ArrayAccess>(token());
+        expression(exp.arrAccess->offset);
+        break;
+      case ExpressionType::WRAPPED:
+        exp.wrapped = mem.makeExpression();
+        expression(*exp.wrapped);
+        break;
+      case ExpressionType::ARRAY_OR_STRUCT_LITERAL:
+        exp.arrayOrStruct = mem.makeArrayOrStruct();
+        expressionList(exp.arrayOrStruct->values);
+        break;
+      default:
+        exp.type = ExpressionType::NONE;
+        valid = false;
+        break;
+    }
+  }
+
+  VariableDec *variableDec() {
+    VariableDec *varDec = mem.make<VariableDec>(token());
+    tokenList(varDec->type);
+    if (word()) {
+      varDec->initialAssignment = mem.makeExpression();
+      expression(*varDec->initialAssignment);
+    }
+    return varDec;
+  }
+
+  void statementList(StatementList& list) {
+    list = mem.makeSpan<Statement>(listCount());
+    for (uint32_t i = 0; i < list.size() && valid; ++i) {
+      statement(list[i]);
+    }
+  }
+
+  void ifStatement(IfStatement& ifStatement) {
+    expression(ifStatement.condition);
+    statementList(ifStatement.body.scopeStatements);
+  }
+
+  void statement(Statement& st) {
+    DepthGuard guard{*this};
+    if (!valid) {
+      return;
+    }
+    st.type = (StatementType)word();
+    switch (st.type) {
+      case StatementType::NOTHING: break;
+      case StatementType::EXPRESSION:
+        st.expression = mem.makeExpression();
+        expression(*st.expression);
+        break;
+      case StatementType::CONTROL_FLOW:
+        st.controlFlow = mem.makeControlFlowStatement();
+        controlFlow(*st.controlFlow);
+        break;
+      case StatementType::SCOPE:
+        st.scope = mem.makeScope();
+        statementList(st.scope->scopeStatements);
+        break;
+      case StatementType::VARIABLE_DEC: st.varDec = variableDec(); break;
+      case StatementType::KEYWORD: st.keyword = token(); break;
+      case StatementType::ERROR: st.errorStart = token(); break;
+      default:
+        st.type = StatementType::NOTHING;
+        valid = false;
+        break;
+    }
+  }
+
+  void controlFlow(ControlFlowStatement& cf) {
+    cf.type = (ControlFlowStatementType)word();
+    switch (cf.type) {
+      case ControlFlowStatementType::NONE: break;
+      case ControlFlowStatementType::FOR_LOOP:
+        cf.forLoop = mem.makeForLoop();
+        statement(cf.forLoop->initialize);
+        expression(cf.forLoop->condition);
+        expression(cf.forLoop->iteration);
+        statementList(cf.forLoop->body.scopeStatements);
+        break;
+      case ControlFlowStatementType::WHILE_LOOP:
+        cf.whileLoop = mem.makeWhileLoop();
+        ifStatement(cf.whileLoop->statement);
+        break;
+      case ControlFlowStatementType::CONDITIONAL_STATEMENT: {
+        cf.conditional = mem.makeConditionalStatement();
+        ConditionalStatement& cond = *cf.conditional;
+        ifStatement(cond.ifStatement);
+        const uint32_t elifCount = word();
+        ElifStatementList **elif = &cond.elifStatement;
+        for (uint32_t i = 0; i < elifCount && valid; ++i) {
+          *elif = mem.makeElifStatementList();
+          ifStatement((*elif)->elif);
+          elif = &(*elif)->next;
+        }
+        if (word()) {
+          cond.elseStatement = mem.makeScope();
+          statementList(cond.elseStatement->scopeStatements);
+        }
+        break;
+      }
+      case ControlFlowStatementType::RETURN_STATEMENT:
+        cf.returnStatement = mem.makeReturnStatement();
+        cf.returnStatement->token = token();
+        expression(cf.returnStatement->returnValue);
+        break;
+      case ControlFlowStatementType::SWITCH_STATEMENT: {
+        cf.switchStatement = mem.makeSwitchStatement();
+        expression(cf.switchStatement->switched);
+        const uint32_t count = word();
+        SwitchScopeStatementList *iter = &cf.switchStatement->body;
+        for (uint32_t i = 0; i < count && valid; ++i) {
+          if (i > 0) {
+            iter->next = mem.makeSwitchScopeStatementList();
+            iter = iter->next;
+          }
+          if (word()) {
+            iter->caseExpression = mem.makeExpression();
+            expression(*iter->caseExpression);
+          }
+          if (word()) {
+            iter->caseBody = mem.makeScope();
+            statementList(iter->caseBody->scopeStatements);
+          }
+        }
+        break;
+      }
+      default:
+        cf.type = ControlFlowStatementType::NONE;
+        valid = false;
+        break;
+    }
+  }
+
+  void functionDec(FunctionDec& funcDec) {
+    funcDec.name = token();
+    statementList(funcDec.params);
+    tokenList(funcDec.returnType);
+    statementList(funcDec.body.scopeStatements);
+  }
+
+  void structDec(StructDec& structDec) {
+    structDec.name = token();
+    structDec.decs = mem.makeSpan<StructMember>(listCount());
+    for (uint32_t i = 0; i < structDec.decs.size() && valid; ++i) {
+      StructMember *iter = &structDec.decs[i];
+      iter->type = (StructDecType)word();
+      if (iter->type == StructDecType::VAR) {
+        iter->varDec = variableDec();
+      } else if (iter->type == StructDecType::FUNC) {
+        iter->funcDec = mem.makeFunctionDec();
+        functionDec(*iter->funcDec);
+      } else if (iter->type != StructDecType::NONE) {
+        iter->type = StructDecType::NONE;
+        valid = false;
+      }
+    }
+  }
+
+  void generalDec(GeneralDec& dec) {
+    dec.type = (GeneralDecType)word();
+    switch (dec.type) {
+      case GeneralDecType::NOTHING: break;
+      case GeneralDecType::STRUCT:
+        dec.structDec = mem.makeStructDec();
+        structDec(*dec.structDec);
+        break;
+      case GeneralDecType::VARIABLE: dec.varDec = variableDec(); break;
+      case GeneralDecType::FUNCTION:
+        dec.funcDec = mem.makeFunctionDec();
+        functionDec(*dec.funcDec);
+        break;
+      case GeneralDecType::TEMPLATE:
+        dec.tempDec = mem.makeTemplateDec();
+        tokenList(dec.tempDec->templateTypes);
+        dec.tempDec->token = token();
+        dec.tempDec->isStruct = word();
+        if (dec.tempDec->isStruct) {
+          structDec(dec.tempDec->structDec);
+        } else {
+          functionDec(dec.tempDec->funcDec);
+        }
+        break;
+      case GeneralDecType::TEMPLATE_CREATE:
+        dec.tempCreate = mem.makeTemplateCreation();
+        dec.tempCreate->templateName = token();
+        tokenList(dec.tempCreate->templateTypes);
+        dec.tempCreate->typeName = token();
+        break;
+      case GeneralDecType::INCLUDE_DEC:
+        dec.includeDec = mem.makeIncludeDec();
+        dec.includeDec->file = token();
+        break;
+      default:
+        dec.type = GeneralDecType::NOTHING;
+        valid = false;
+        break;
+    }
+  }
+};
+
+ModuleFile::~ModuleFile() {
+  close();
+}
+
+void ModuleFile::close() {
+#if defined(__unix__) || defined(__APPLE__)
+  if (mapping) {
+    munmap(mapping, mappingSize);
+  }
+#endif
+  mapping = nullptr;
+  mappingSize = 0;
+  buffer.clear();
+  words = nullptr;
+  wordCount = 0;
+}
+
+/**
+ * Maps a module file into memory. The file is only read, never copied
+ * \returns false if the file does not exist or is not a valid module
+*/
+bool ModuleFile::open(const std::string& path) {
+  close();
+#if defined(__unix__) || defined(__APPLE__)
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat info;
+  if (fstat(fd, &info) != 0 || info.st_size == 0) {
+    ::close(fd);
+    return false;
+  }
+  void *ptr = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (ptr == MAP_FAILED) {
+    return false;
+  }
+  mapping = ptr;
+  mappingSize = info.st_size;
+  words = (const uint32_t *)ptr;
+  wordCount = mappingSize / sizeof (uint32_t);
+  if (mappingSize % sizeof (uint32_t) != 0 || !validate()) {
+    close();
+    return false;
+  }
+  return true;
+#else
+  std::ifstream file(path, std::ios::binary);
+  if (!file.is_open()) {
+    return false;
+  }
+  std::string bytes{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+  return openBuffer(std::move(bytes));
+#endif
+}
+
+bool ModuleFile::openBuffer(std::string&& bytes) {
+  close();
+  buffer = std::move(bytes);
+  if (buffer.size() % sizeof (uint32_t) != 0) {
+    buffer.clear();
+    return false;
+  }
+  // std::string storage is suitably aligned for uint32_t
+  words = (const uint32_t *)buffer.data();
+  wordCount = buffer.size() / sizeof (uint32_t);
+  if (!validate()) {
+    close();
+    return false;
+  }
+  return true;
+}
+
+uint32_t ModuleFile::header(ModuleHeaderField field) const {
+  return words[(uint32_t)field];
+}
+
+bool ModuleFile::validate() {
+  if (wordCount < (uint32_t)ModuleHeaderField::SIZE) {
+    return false;
+  }
+  if (header(ModuleHeaderField::MAGIC) != moduleMagic || header(ModuleHeaderField::VERSION) != moduleVersion) {
+    return false;
+  }
+  const uint64_t newlineEnd = (uint64_t)header(ModuleHeaderField::NEWLINE_OFFSET) + header(ModuleHeaderField::NEWLINE_COUNT);
+  const uint64_t decTableEnd = (uint64_t)header(ModuleHeaderField::DEC_TABLE_OFFSET) + header(ModuleHeaderField::DEC_COUNT);
+  const uint64_t nodesEnd = (uint64_t)header(ModuleHeaderField::NODES_OFFSET) + header(ModuleHeaderField::NODES_SIZE);
+  return newlineEnd <= wordCount && decTableEnd <= wordCount && nodesEnd <= wordCount;
+}
+
+/**
+ * \returns true if the module was built from this exact source text
+*/
+bool ModuleFile::matches(const std::string& source) const {
+  if (!words || header(ModuleHeaderField::SOURCE_SIZE) != source.size()) {
+    return false;
+  }
+  const uint64_t hash = hashSource(source);
+  return header(ModuleHeaderField::HASH_LOW) == (uint32_t)hash && header(ModuleHeaderField::HASH_HIGH) == (uint32_t)(hash >> 32);
+}
+
+uint32_t ModuleFile::decCount() const {
+  return words ? header(ModuleHeaderField::DEC_COUNT) : 0;
+}
+
+/**
+ * Gives the tokenizer the newline positions of the whole file and moves it to the end of the file,
+ * as if it had tokenized the source
+*/
+void ModuleFile::loadNewlines(Tokenizer& tk) const {
+  const uint32_t *newlines = words + header(ModuleHeaderField::NEWLINE_OFFSET);
+  tk.newlinePositions.assign(newlines, newlines + header(ModuleHeaderField::NEWLINE_COUNT));
+  tk.position = tk.content.size();
+  tk.peeked.type = TokenType::NOTHING;
+}
+
+/**
+ * Rebuilds a declaration from the module
+ * \param index index of the declaration within the module
+ * \param dec where the declaration is built
+ * \param baseLocation base location of the module's source file, see Tokenizer
+ * \returns false if the module is corrupt
+*/
+bool ModuleFile::decodeDec(uint32_t index, GeneralDec& dec, NodeMemPool& mem, uint32_t baseLocation) const {
+  if (index >= decCount()) {
+    return false;
+  }
+  const uint32_t *nodes = words + header(ModuleHeaderField::NODES_OFFSET);
+  const uint32_t nodesSize = header(ModuleHeaderField::NODES_SIZE);
+  const uint32_t offset = words[header(ModuleHeaderField::DEC_TABLE_OFFSET) + index];
+  if (offset >= nodesSize) {
+    return false;
+  }
+  ModuleReader reader{nodes + offset, nodes + nodesSize, mem, baseLocation, header(ModuleHeaderField::SOURCE_SIZE)};
+  reader.generalDec(dec);
+  return reader.valid;
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "../nodes.hpp"
+#include "../nodeMemPool.hpp"
+
+/**
+ * Precompiled module (.prm) files.
+ * A module holds the parsed declarations of one source file, the newline positions of the source (so that
+ * diagnostics keep their line numbers), and a hash of the source it was built from.
+ *
+ * Layout, all 32 bit words in native byte order:
+ *   header (see ModuleHeaderField)
+ *   newline positions
+ *   declaration table: offset of each declaration within the node stream
+ *   node stream: declarations encoded in pre-order, children follow their parent
+ *
+ * The file contains no pointers, so it can be mapped at any address. It is not used as the AST in place:
+ * decodeDec rebuilds each declaration from the mapping into a NodeMemPool.
+ * Tokens are stored as offsets into the source text, so the source is needed to extract them.
+*/
+
+const uint32_t moduleMagic = 0x314D5250; // "PRM1"
+const uint32_t moduleVersion = 2;
+
+enum class ModuleHeaderField: uint8_t {
+  MAGIC,
+  VERSION,
+  HASH_LOW,
+  HASH_HIGH,
+  SOURCE_SIZE,
+  NEWLINE_COUNT,
+  NEWLINE_OFFSET,
+  DEC_COUNT,
+  DEC_TABLE_OFFSET,
+  NODES_OFFSET,
+  NODES_SIZE,
+  SIZE,
+};
+
+uint64_t hashSource(const std::string&);
+
+/**
+ * Builds the module path for a source file. "file.pr" becomes "file.prm"
+*/
+std::string modulePath(const std::string&);
+
+/**
+ * Serializes the declarations of a single source file
+ * \param tk the tokenizer of the file. It must have tokenized the whole file
+ * \param decs the declarations of the file, in source order
+ * \param out the encoded module
+ * \returns false if a declaration cannot be serialized
+*/
+bool serializeModule(Tokenizer& tk, const std::vector<GeneralDec *>& decs, std::string& out);
+bool writeModuleFile(const std::string& path, const std::string& bytes);
+
+/**
+ * A read only view of a module, either memory mapped from a file or owning a buffer
+*/
+struct ModuleFile {
+  std::string buffer;
+  const uint32_t *words{nullptr};
+  void *mapping{nullptr};
+  size_t mappingSize{0};
+  uint32_t wordCount{0};
+
+  ModuleFile() = default;
+  ModuleFile(const ModuleFile&) = delete;
+  ModuleFile& operator=(const ModuleFile&) = delete;
+  ~ModuleFile();
+
+  bool open(const std::string& path);
+  bool openBuffer(std::string&&);
+  bool matches(const std::string& source) const;
+  uint32_t decCount() const;
+  void loadNewlines(Tokenizer&) const;
+  bool decodeDec(uint32_t index, GeneralDec&, NodeMemPool&, uint32_t baseLocation = 0) const;
+
+private:
+  bool validate();
+  void close();
+  uint32_t header(ModuleHeaderField) const;
+};
@@ -0,0 +1,189 @@
+#include <catch2/catch_test_macros.hpp>
+#include "../parser/parser.hpp"
+#include "serializer.hpp"
+
+NodeMemPool memPoolSerializer;
+
+const std::string moduleSource =
+R"(include "./other.pr"
+struct Node {
+  value: int;
+  next: Node ptr;
+  func length(): uint32 {
+    return 1 + next->length();
+  }
+}
+template [T] struct Box {
+  item: T;
+}
+create Box [int] as IntBox;
+count: int = 4;
+func main(argc: int, argv: char ptr ptr): int {
+  total: int = 0;
+  values: int ptr = [1, 2, 3, 4];
+  for (i: int = 0; i < count; i++) {
+    total += values[i] * -argc;
+  }
+  while (total > 10) {
+    total = total / 2;
+  }
+  if (total == 0) {
+    return 0;
+  }
+  elif (total == 1) {
+    {
+      print("one");
+    }
+  }
+  else {
+    break;
+  }
+  switch total {
+    case 2
+    case 3 {
+      total = (total + 1);
+    }
+    default {
+    }
+  }
+  return total;
+}
+)";
+
+TEST_CASE("Module round trip", "[serializer]") {
+  std::vector<Tokenizer> tks;
+  tks.emplace_back("./src/serializer/test_serializer.cpp", moduleSource);
+  Parser parser{tks.back(), memPoolSerializer};
+  REQUIRE(parser.parse());
+  std::vector<GeneralDec *>& decs = parser.program.decs;
+  std::string bytes;
+  REQUIRE(serializeModule(tks.back(), decs, bytes));
+
+  ModuleFile module;
+  REQUIRE(module.openBuffer(std::string{bytes}));
+  CHECK(module.matches(moduleSource));
+  CHECK_FALSE(module.matches(moduleSource + ' '));
+  REQUIRE(module.decCount() == decs.size());
+
+  Tokenizer loaded{"./src/serializer/test_serializer.cpp", moduleSource};
+  module.loadNewlines(loaded);
+  CHECK(loaded.newlinePositions == tks.back().newlinePositions);
+  CHECK(loaded.peekNext().type == TokenType::END_OF_FILE);
+
+  NodeMemPool decodePool;
+  for (uint32_t i = 0; i < decs.size(); ++i) {
+    GeneralDec dec;
+    REQUIRE(module.decodeDec(i, dec, decodePool));
+    std::string expected, actual;
+    decs[i]->prettyPrint(tks, expected);
+    dec.prettyPrint(tks, actual);
+    CHECK(expected == actual);
+  }
+}
+
+TEST_CASE("Long operator chains round trip", "[serializer]") {
+  // a flat sum is a chain of operators as long as the sum, encoded and decoded without recursing per operator
+  std::string source = "func f(x: int): int {\n  return x";
+  for (uint32_t i = 0; i < 200000; ++i) {
+    source += " + x";
+  }
+  source += ";\n}\n";
+  std::vector<Tokenizer> tks;
+  tks.emplace_back("./src/serializer/test_serializer.cpp", source);
+  Parser parser{tks.back(), memPoolSerializer};
+  REQUIRE(parser.parse());
+  std::string bytes;
+  REQUIRE(serializeModule(tks.back(), parser.program.decs, bytes));
+
+  ModuleFile module;
+  REQUIRE(module.openBuffer(std::string{bytes}));
+  NodeMemPool decodePool;
+  GeneralDec *dec = decodePool.makeGeneralDec();
+  REQUIRE(module.decodeDec(0, *dec, decodePool));
+  std::string encodedAgain;
+  REQUIRE(serializeModule(tks.back(), {dec}, encodedAgain));
+  CHECK(encodedAgain == bytes);
+}
+
+TEST_CASE("Corrupt modules are rejected", "[serializer]") {
+  std::vector<Tokenizer> tks;
+  tks.emplace_back("./src/serializer/test_serializer.cpp", "func f(): int {\n  return 1 + 2;\n}\n");
+  Parser parser{tks.back(), memPoolSerializer};
+  REQUIRE(parser.parse());
+  std::vector<GeneralDec *>& decs = parser.program.decs;
+  std::string bytes;
+  REQUIRE(serializeModule(tks.back(), decs, bytes));
+
+  ModuleFile module;
+  CHECK_FALSE(module.openBuffer(bytes.substr(0, 8)));
+  std::string badMagic = bytes;
+  badMagic[0] ^= 1;
+  CHECK_FALSE(module.openBuffer(std::move(badMagic)));
+
+  // cut off the end of the node stream but keep the header consistent with the file size
+  std::string truncated = bytes.substr(0, bytes.size() - 2 * sizeof (uint32_t));
+  const uint32_t nodesSize = *(const uint32_t *)(bytes.data() + (uint32_t)ModuleHeaderField::NODES_SIZE * sizeof (uint32_t)) - 2;
+  truncated.replace((uint32_t)ModuleHeaderField::NODES_SIZE * sizeof (uint32_t), sizeof (uint32_t), (const char *)&nodesSize, sizeof (uint32_t));
+  REQUIRE(module.openBuffer(std::move(truncated)));
+  GeneralDec dec;
+  CHECK_FALSE(module.decodeDec(0, dec, memPoolSerializer));
+  CHECK_FALSE(module.decodeDec(1, dec, memPoolSerializer));
+
+  // the node stream starts with the declaration type, then the function name token: offset, then length and type
+  const size_t nameOffset = (*(const uint32_t *)(bytes.data() + (uint32_t)ModuleHeaderField::NODES_OFFSET * sizeof (uint32_t)) + 1) * sizeof (uint32_t);
+  std::string badPosition = bytes;
+  const uint32_t pastEnd = tks.back().content.size();
+  badPosition.replace(nameOffset, sizeof (uint32_t), (const char *)&pastEnd, sizeof (uint32_t));
+  REQUIRE(module.openBuffer(std::move(badPosition)));
+  CHECK_FALSE(module.decodeDec(0, dec, memPoolSerializer));
+
+  std::string badType = bytes;
+  badType[nameOffset + sizeof (uint32_t) + 3] = (char)0xFF;
+  REQUIRE(module.openBuffer(std::move(badType)));
+  CHECK_FALSE(module.decodeDec(0, dec, memPoolSerializer));
+
+  REQUIRE(module.openBuffer(std::string{bytes}));
+  CHECK(module.decodeDec(0, dec, memPoolSerializer));
+}
+
+TEST_CASE("Overly nested modules are rejected", "[serializer]") {
+  std::vector<Tokenizer> tks;
+  tks.emplace_back("./src/serializer/test_serializer.cpp", "func f(): int {\n  return (1);\n}\n");
+  Parser parser{tks.back(), memPoolSerializer};
+  REQUIRE(parser.parse());
+  std::string bytes;
+  REQUIRE(serializeModule(tks.back(), parser.program.decs, bytes));
+  // the node stream ends with the returned expression: WRAPPED, then VALUE and its token
+  const size_t wrappedOffset = bytes.size() - 4 * sizeof (uint32_t);
+  REQUIRE(*(const uint32_t *)(bytes.data() + wrappedOffset) == (uint32_t)ExpressionType::WRAPPED);
+
+  // wraps the returned value in more parentheses, optionally cutting the stream off after them
+  const auto wrap = [&](uint32_t count, bool truncate) {
+    std::string extra;
+    for (uint32_t i = 0; i < count; ++i) {
+      const uint32_t wrapped = (uint32_t)ExpressionType::WRAPPED;
+      extra.append((const char *)&wrapped, sizeof (uint32_t));
+    }
+    std::string nested = bytes;
+    nested.insert(wrappedOffset, extra);
+    if (truncate) {
+      nested.resize(wrappedOffset + extra.size());
+    }
+    const size_t sizeField = (uint32_t)ModuleHeaderField::NODES_SIZE * sizeof (uint32_t);
+    const uint32_t nodesSize = *(const uint32_t *)(bytes.data() + sizeField) + count - (truncate ? 4 : 0);
+    nested.replace(sizeField, sizeof (uint32_t), (const char *)&nodesSize, sizeof (uint32_t));
+    return nested;
+  };
+
+  ModuleFile module;
+  GeneralDec dec;
+  REQUIRE(module.openBuffer(wrap(100, false)));
+  CHECK(module.decodeDec(0, dec, memPoolSerializer));
+  REQUIRE(module.openBuffer(wrap(100, true)));
+  CHECK_FALSE(module.decodeDec(0, dec, memPoolSerializer));
+  // deep enough to overflow the stack if each level recursed
+  REQUIRE(module.openBuffer(wrap(10000000, false)));
+  CHECK_FALSE(module.decodeDec(0, dec, memPoolSerializer));
+  REQUIRE(module.openBuffer(wrap(10000000, true)));
+  CHECK_FALSE(module.decodeDec(0, dec, memPoolSerializer));
+}
@@ -0,0 +1,363 @@
+#include "structuralHash.hpp"
+#include <cstring>
+
+namespace {
+
+const uint32_t cachedMark = UINT32_MAX;
+
+uint64_t mix(uint64_t hash, uint64_t value) {
+  hash ^= value + 0x9e3779b97f4a7c15 + (hash << 6) + (hash >> 2);
+  return hash;
+}
+
+uint32_t elifCount(const ConditionalStatement& conditional) {
+  uint32_t count = 0;
+  for (const ElifStatementList *elif = conditional.elifStatement; elif; elif = elif->next) {
+    ++count;
+  }
+  return count;
+}
+
+// which parts each case of a switch has, two bits per case
+uint64_t switchShape(const SwitchStatement& switchStatement) {
+  uint64_t shape = 1;
+  for (const SwitchScopeStatementList *list = &switchStatement.body; list; list = list->next) {
+    shape = mix(shape, (list->caseExpression != nullptr) | (list->caseBody != nullptr) << 1);
+  }
+  return shape;
+}
+
+}
+
+StructuralHasher::StructuralHasher(): traversal{*this} {}
+
+uint64_t StructuralHasher::hash(Tokenizer& tokenizer, Expression& expression) {
+  tk = &tokenizer;
+  traversal.walk(expression);
+  const uint64_t result = results.back();
+  results.clear();
+  return result;
+}
+
+uint64_t StructuralHasher::hash(Tokenizer& tokenizer, Statement& statement) {
+  tk = &tokenizer;
+  traversal.walk(statement);
+  const uint64_t result = results.back();
+  results.clear();
+  return result;
+}
+
+uint64_t StructuralHasher::hash(Tokenizer& tokenizer, Scope& scope) {
+  tk = &tokenizer;
+  traversal.walk(scope);
+  const uint64_t result = results.back();
+  results.clear();
+  return result;
+}
+
+uint64_t StructuralHasher::hash(Tokenizer& tokenizer, FunctionDec& funcDec) {
+  auto cached = cache.find(&funcDec);
+  if (cached != cache.end()) {
+    return cached->second;
+  }
+  tk = &tokenizer;
+  // parameters and body
+  traversal.walk(funcDec);
+  uint64_t result = mix(typeHash(funcDec.returnType), funcDec.params.size());
+  for (uint64_t child : results) {
+    result = mix(result, child);
+  }
+  results.clear();
+  cache[&funcDec] = result;
+  return result;
+}
+
+/**
+ * Forgets every cached hash. Required once any hashed node has been released or rolled back, see StructuralHasher
+*/
+void StructuralHasher::clear() {
+  cache.clear();
+}
+
+bool StructuralHasher::enterNode(const void *node) {
+  auto cached = cache.find(node);
+  if (cached != cache.end()) {
+    results.push_back(cached->second);
+    marks.push_back(cachedMark);
+    return false;
+  }
+  marks.push_back(results.size());
+  return true;
+}
+
+void StructuralHasher::leaveNode(const void *node, uint64_t hash) {
+  const uint32_t mark = marks.back();
+  marks.pop_back();
+  hash = mix(hash, results.size() - mark);
+  for (uint32_t i = mark; i < results.size(); ++i) {
+    hash = mix(hash, results[i]);
+  }
+  results.resize(mark);
+  results.push_back(hash);
+  cache[node] = hash;
+}
+
+uint64_t StructuralHasher::tokenHash(const Token& token) const {
+  uint64_t hash = 0xcbf29ce484222325 ^ (uint64_t)token.type;
+  const char *text = tk->content.data() + (token.position - tk->baseLocation);
+  for (uint32_t i = 0; i < token.length; ++i) {
+    hash ^= (uint8_t)text[i];
+    hash *= 0x100000001b3;
+  }
+  return hash;
+}
+
+uint64_t StructuralHasher::typeHash(const TokenList& type) const {
+  uint64_t hash = 0;
+  for (const TokenList *list = &type; list; list = list->next) {
+    hash = mix(hash, tokenHash(list->token));
+  }
+  return hash;
+}
+
+bool StructuralHasher::enter(Expression& expression) {
+  return enterNode(&expression);
+}
+
+void StructuralHasher::leave(Expression& expression) {
+  if (marks.back() == cachedMark) {
+    marks.pop_back();
+    return;
+  }
+  uint64_t hash = (uint64_t)expression.type;
+  switch (expression.type) {
+    case ExpressionType::VALUE: hash = mix(hash, tokenHash(expression.value)); break;
+    case ExpressionType::BINARY_OP: hash = mix(hash, (uint64_t)expression.binOp->op.type); break;
+    case ExpressionType::UNARY_OP: hash = mix(hash, (uint64_t)expression.unOp->op.type); break;
+    case ExpressionType::FUNCTION_CALL: hash = mix(hash, tokenHash(expression.funcCall->name)); break;
+    case ExpressionType::ARRAY_ACCESS: hash = mix(hash, tokenHash(expression.arrAccess->array)); break;
+    default: break;
+  }
+  leaveNode(&expression, hash);
+}
+
+bool StructuralHasher::enter(Statement& statement) {
+  return enterNode(&statement);
+}
+
+void StructuralHasher::leave(Statement& statement) {
+  if (marks.back() == cachedMark) {
+    marks.pop_back();
+    return;
+  }
+  uint64_t hash = (uint64_t)statement.type + 0x100;
+  switch (statement.type) {
+    case StatementType::KEYWORD: {
+      hash = mix(hash, (uint64_t)statement.keyword.type);
+      break;
+    }
+    case StatementType::VARIABLE_DEC: {
+      hash = mix(hash, tokenHash(statement.varDec->name));
+      hash = mix(hash, typeHash(statement.varDec->type));
+      break;
+    }
+    case StatementType::CONTROL_FLOW: {
+      ControlFlowStatement& controlFlow = *statement.controlFlow;
+      hash = mix(hash, (uint64_t)controlFlow.type);
+      if (controlFlow.type == ControlFlowStatementType::CONDITIONAL_STATEMENT) {
+        hash = mix(hash, elifCount(*controlFlow.conditional));
+        hash = mix(hash, controlFlow.conditional->elseStatement != nullptr);
+      } else if (controlFlow.type == ControlFlowStatementType::SWITCH_STATEMENT) {
+        hash = mix(hash, switchShape(*controlFlow.switchStatement));
+      }
+      break;
+    }
+    default: break;
+  }
+  leaveNode(&statement, hash);
+}
+
+bool StructuralHasher::enter(Scope& scope) {
+  return enterNode(&scope);
+}
+
+void StructuralHasher::leave(Scope& scope) {
+  if (marks.back() == cachedMark) {
+    marks.pop_back();
+    return;
+  }
+  leaveNode(&scope, 0x200);
+}
+
+namespace {
+
+enum class NodeKind: uint8_t {
+  STATEMENT,
+  EXPRESSION,
+  SCOPE,
+};
+
+/**
+ * Lists the nodes of a tree in pre-order. Two trees are equal when their lists are pairwise equal,
+ * since equal nodes have the same number of children
+*/
+struct NodeCollector: NodeVisitor {
+  using NodeVisitor::enter;
+  std::vector<std::pair<void *, NodeKind>> nodes;
+  bool enter(Statement& statement) {
+    nodes.emplace_back(&statement, NodeKind::STATEMENT);
+    return true;
+  }
+  bool enter(Expression& expression) {
+    nodes.emplace_back(&expression, NodeKind::EXPRESSION);
+    return true;
+  }
+  bool enter(Scope& scope) {
+    nodes.emplace_back(&scope, NodeKind::SCOPE);
+    return true;
+  }
+};
+
+bool sameToken(Tokenizer& tkA, const Token& a, Tokenizer& tkB, const Token& b) {
+  return a.type == b.type && a.length == b.length &&
+    memcmp(tkA.content.data() + (a.position - tkA.baseLocation), tkB.content.data() + (b.position - tkB.baseLocation), a.length) == 0;
+}
+
+bool sameType(Tokenizer& tkA, const TokenList& a, Tokenizer& tkB, const TokenList& b) {
+  const TokenList *listA = &a, *listB = &b;
+  for (; listA && listB; listA = listA->next, listB = listB->next) {
+    if (!sameToken(tkA, listA->token, tkB, listB->token)) {
+      return false;
+    }
+  }
+  return !listA && !listB;
+}
+
+bool sameNode(Tokenizer& tkA, Expression& a, Tokenizer& tkB, Expression& b) {
+  if (a.type != b.type) {
+    return false;
+  }
+  switch (a.type) {
+    case ExpressionType::VALUE: return sameToken(tkA, a.value, tkB, b.value);
+    case ExpressionType::BINARY_OP: return a.binOp->op.type == b.binOp->op.type;
+    case ExpressionType::UNARY_OP: return a.unOp->op.type == b.unOp->op.type;
+    case ExpressionType::FUNCTION_CALL: {
+      return a.funcCall->args.size() == b.funcCall->args.size() && sameToken(tkA, a.funcCall->name, tkB, b.funcCall->name);
+    }
+    case ExpressionType::ARRAY_ACCESS: return sameToken(tkA, a.arrAccess->array, tkB, b.arrAccess->array);
+    case ExpressionType::ARRAY_OR_STRUCT_LITERAL: return a.arrayOrStruct->values.size() == b.arrayOrStruct->values.size();
+    default: return true;
+  }
+}
+
+bool sameNode(Tokenizer& tkA, Statement& a, Tokenizer& tkB, Statement& b) {
+  if (a.type != b.type) {
+    return false;
+  }
+  switch (a.type) {
+    case StatementType::KEYWORD: return a.keyword.type == b.keyword.type;
+    case StatementType::VARIABLE_DEC: {
+      return (a.varDec->initialAssignment != nullptr) == (b.varDec->initialAssignment != nullptr) &&
+        sameToken(tkA, a.varDec->name, tkB, b.varDec->name) && sameType(tkA, a.varDec->type, tkB, b.varDec->type);
+    }
+    case StatementType::CONTROL_FLOW: {
+      ControlFlowStatement &controlA = *a.controlFlow, &controlB = *b.controlFlow;
+      if (controlA.type != controlB.type) {
+        return false;
+      }
+      if (controlA.type == ControlFlowStatementType::CONDITIONAL_STATEMENT) {
+        return elifCount(*controlA.conditional) == elifCount(*controlB.conditional) &&
+          (controlA.conditional->elseStatement != nullptr) == (controlB.conditional->elseStatement != nullptr);
+      }
+      if (controlA.type == ControlFlowStatementType::SWITCH_STATEMENT) {
+        return switchShape(*controlA.switchStatement) == switchShape(*controlB.switchStatement);
+      }
+      return true;
+    }
+    default: return true;
+  }
+}
+
+bool sameNodes(Tokenizer& tkA, const NodeCollector& a, Tokenizer& tkB, const NodeCollector& b) {
+  if (a.nodes.size() != b.nodes.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < a.nodes.size(); ++i) {
+    const NodeKind kind = a.nodes[i].second;
+    if (kind != b.nodes[i].second) {
+      return false;
+    }
+    void *nodeA = a.nodes[i].first, *nodeB = b.nodes[i].first;
+    switch (kind) {
+      case NodeKind::STATEMENT: {
+        if (!sameNode(tkA, *(Statement *)nodeA, tkB, *(Statement *)nodeB)) {
+          return false;
+        }
+        break;
+      }
+      case NodeKind::EXPRESSION: {
+        if (!sameNode(tkA, *(Expression *)nodeA, tkB, *(Expression *)nodeB)) {
+          return false;
+        }
+        break;
+      }
+      case NodeKind::SCOPE: {
+        if (((Scope *)nodeA)->scopeStatements.size() != ((Scope *)nodeB)->scopeStatements.size()) {
+          return false;
+        }
+        break;
+      }
+    }
+  }
+  return true;
+}
+
+template<typename T>
+bool equalTrees(Tokenizer& tkA, T& a, Tokenizer& tkB, T& b) {
+  NodeCollector collectorA, collectorB;
+  Traversal<NodeCollector> traversalA{collectorA}, traversalB{collectorB};
+  traversalA.walk(a);
+  traversalB.walk(b);
+  return sameNodes(tkA, collectorA, tkB, collectorB);
+}
+
+}
+
+bool structurallyEqual(Tokenizer& tkA, Expression& a, Tokenizer& tkB, Expression& b) {
+  return equalTrees(tkA, a, tkB, b);
+}
+
+bool structurallyEqual(Tokenizer& tkA, Statement& a, Tokenizer& tkB, Statement& b) {
+  return equalTrees(tkA, a, tkB, b);
+}
+
+bool structurallyEqual(Tokenizer& tkA, FunctionDec& a, Tokenizer& tkB, FunctionDec& b) {
+  return a.params.size() == b.params.size() && sameType(tkA, a.returnType, tkB, b.returnType) && equalTrees(tkA, a, tkB, b);
+}
+
+std::vector<uint32_t> findIdenticalFunctions(std::vector<Tokenizer>& tokenizers, const std::vector<GeneralDec *>& decs) {
+  std::vector<uint32_t> identical(decs.size());
+  StructuralHasher hasher;
+  // functions seen so far by hash, collisions are told apart with structurallyEqual
+  std::unordered_multimap<uint64_t, uint32_t> seen;
+  for (uint32_t i = 0; i < decs.size(); ++i) {
+    identical[i] = i;
+    if (decs[i]->type != GeneralDecType::FUNCTION) {
+      continue;
+    }
+    Tokenizer& tk = tokenizerAt(tokenizers, decs[i]->location());
+    const uint64_t hash = hasher.hash(tk, *decs[i]->funcDec);
+    auto candidates = seen.equal_range(hash);
+    for (auto candidate = candidates.first; candidate != candidates.second; ++candidate) {
+      GeneralDec *other = decs[candidate->second];
+      if (structurallyEqual(tokenizerAt(tokenizers, other->location()), *other->funcDec, tk, *decs[i]->funcDec)) {
+        identical[i] = candidate->second;
+        break;
+      }
+    }
+    if (identical[i] == i) {
+      seen.emplace(hash, i);
+    }
+  }
+  return identical;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "../traversal/traversal.hpp"
+#include <unordered_map>
+
+/**
+ * Structural hashes of statements, scopes, expressions and functions.
+ * Subtrees with the same shape and the same token text hash the same, wherever they are in the source,
+ * so the hash can key deduplication of identical code and memoization of per subtree results.
+ * Hashes are computed bottom up in a single walk and cached per node, so hashing a subtree of a tree that
+ * was already hashed is a lookup. Equal hashes do not guarantee equal trees, confirm with structurallyEqual.
+ * The cache refers to nodes by address. Call clear after nodes are released, rolled back to a NodeMemPool::Checkpoint,
+ * reset or modified, since new nodes may be built at the same addresses and would get the old hashes.
+ * Not thread safe
+*/
+struct StructuralHasher: NodeVisitor {
+  using NodeVisitor::enter;
+  using NodeVisitor::leave;
+  std::unordered_map<const void *, uint64_t> cache;
+  std::vector<uint64_t> results; // hashes of finished nodes whose parent is not finished yet
+  std::vector<uint32_t> marks; // size of results when each unfinished node was entered
+  Tokenizer *tk{nullptr};
+  Traversal<StructuralHasher> traversal;
+
+  StructuralHasher();
+  StructuralHasher(const StructuralHasher&) = delete;
+  StructuralHasher& operator=(const StructuralHasher&) = delete;
+
+  uint64_t hash(Tokenizer&, Expression&);
+  uint64_t hash(Tokenizer&, Statement&);
+  uint64_t hash(Tokenizer&, Scope&);
+  // the name of the function is not part of the hash, only its signature and body
+  uint64_t hash(Tokenizer&, FunctionDec&);
+  void clear();
+
+  bool enter(Expression&);
+  void leave(Expression&);
+  bool enter(Statement&);
+  void leave(Statement&);
+  bool enter(Scope&);
+  void leave(Scope&);
+
+private:
+  bool enterNode(const void *);
+  void leaveNode(const void *, uint64_t);
+  uint64_t tokenHash(const Token&) const;
+  uint64_t typeHash(const TokenList&) const;
+};
+
+bool structurallyEqual(Tokenizer&, Expression&, Tokenizer&, Expression&);
+bool structurallyEqual(Tokenizer&, Statement&, Tokenizer&, Statement&);
+bool structurallyEqual(Tokenizer&, FunctionDec&, Tokenizer&, FunctionDec&);
+
+/**
+ * Finds functions with identical signatures and bodies, names aside
+ * \param decs declarations to search, only functions are considered
+ * \returns for each declaration, the index of the first declaration identical to it (its own index if there is none)
+*/
+std::vector<uint32_t> findIdenticalFunctions(std::vector<Tokenizer>&, const std::vector<GeneralDec *>& decs);
@@ -0,0 +1,68 @@
+#include <catch2/catch_test_macros.hpp>
+#include "../parser/parser.hpp"
+#include "structuralHash.hpp"
+
+NodeMemPool memPoolStructuralHash;
+
+TEST_CASE("Structural hash of functions", "[structuralHash]") {
+  const std::string str =
+    "func f(a: int32): int32 { x: int32 = a + 1; if (x) { g(x, 2); } else { return 0; } return x * a; }\n"
+    "func h(a: int32): int32 {\n  x: int32 = a    + 1;\n  if (x) {\n    g(x, 2);\n  } else {\n    return 0;\n  }\n  return x * a;\n}\n"
+    "func k(a: int32): int32 { x: int32 = a + 1; if (x) { g(x, 2); } else { return 0; } return x - a; }\n"
+    "func m(a: int64): int32 { x: int32 = a + 1; if (x) { g(x, 2); } else { return 0; } return x * a; }\n";
+  std::vector<Tokenizer> tokenizers;
+  tokenizers.emplace_back("./src/structuralHash/test_structuralHash.cpp", str);
+  Parser parser{tokenizers[0], memPoolStructuralHash};
+  REQUIRE(parser.parse());
+  std::vector<GeneralDec *> decs;
+  for (uint32_t i = 0; i < parser.program.decs.size(); ++i) {
+    decs.push_back(parser.program.decs[i]);
+  }
+  REQUIRE(decs.size() == 4);
+  FunctionDec &f = *decs[0]->funcDec, &h = *decs[1]->funcDec, &k = *decs[2]->funcDec, &m = *decs[3]->funcDec;
+
+  StructuralHasher hasher;
+  const uint64_t hashF = hasher.hash(tokenizers[0], f);
+  CHECK(hashF == hasher.hash(tokenizers[0], h));
+  CHECK(hashF != hasher.hash(tokenizers[0], k));
+  CHECK(hashF != hasher.hash(tokenizers[0], m));
+  CHECK(structurallyEqual(tokenizers[0], f, tokenizers[0], h));
+  CHECK_FALSE(structurallyEqual(tokenizers[0], f, tokenizers[0], k));
+  CHECK_FALSE(structurallyEqual(tokenizers[0], f, tokenizers[0], m));
+
+  // statements and expressions of a hashed function are already cached
+  const size_t cached = hasher.cache.size();
+  Statement &returnF = f.body.scopeStatements[2], &returnK = k.body.scopeStatements[2];
+  const uint64_t hashReturnF = hasher.hash(tokenizers[0], returnF);
+  CHECK(hasher.cache.size() == cached);
+  CHECK(hashReturnF != hasher.hash(tokenizers[0], returnK));
+  CHECK(hasher.hash(tokenizers[0], f.body.scopeStatements[0]) == hasher.hash(tokenizers[0], k.body.scopeStatements[0]));
+  CHECK(structurallyEqual(tokenizers[0], f.body.scopeStatements[1], tokenizers[0], k.body.scopeStatements[1]));
+
+  CHECK(findIdenticalFunctions(tokenizers, decs) == std::vector<uint32_t>{0, 0, 2, 3});
+}
+
+TEST_CASE("Structural hash cache after a rollback", "[structuralHash]") {
+  std::vector<Tokenizer> tokenizers;
+  tokenizers.emplace_back("./src/structuralHash/test_structuralHash.cpp", "a + b * c; x - y;");
+  NodeMemPool pool;
+  Parser parser{tokenizers[0], pool};
+  StructuralHasher hasher;
+  Statement first;
+  uint64_t firstHash;
+  {
+    NodeMemPool::Checkpoint checkpoint{pool};
+    REQUIRE(parser.parseStatement(first) == ParseStatementErrorType::NONE);
+    firstHash = hasher.hash(tokenizers[0], *first.expression);
+    checkpoint.rollback();
+  }
+  // the second statement is built in the memory given back, at the same address
+  Statement second;
+  REQUIRE(parser.parseStatement(second) == ParseStatementErrorType::NONE);
+  REQUIRE(second.expression == first.expression);
+  hasher.clear();
+  const uint64_t secondHash = hasher.hash(tokenizers[0], *second.expression);
+  CHECK(secondHash != firstHash);
+  StructuralHasher fresh;
+  CHECK(secondHash == fresh.hash(tokenizers[0], *second.expression));
+}
@@ -0,0 +1,306 @@
+#include <catch2/catch_test_macros.hpp>
+#include <thread>
+#include "nodeMemPool.hpp"
+
+TEST_CASE("ArrayPool reset cycles", "[memPool]") {
+  ArrayPool pool{256};
+  const uint32_t values[4] = {1, 2, 3, 4};
+  uint32_t *first = pool.get(values, 4);
+  for (uint32_t cycle = 0; cycle < 1000; ++cycle) {
+    pool.reset();
+    REQUIRE(pool.get(values, 4) == first);
+    for (uint32_t i = 0; i < 50; ++i) {
+      REQUIRE(pool.get(values, 4)[3] == 4);
+    }
+  }
+  const size_t retained = pool.retainedBytes();
+  CHECK(retained == 4 * 256);
+
+  pool.reset(256);
+  CHECK(pool.retainedBytes() == 256);
+  CHECK(pool.get(values, 4) == first);
+  pool.reset(0);
+  CHECK(pool.retainedBytes() == 0);
+  CHECK(pool.get(values, 4)[0] == 1);
+}
+
+TEST_CASE("ArrayPool block growth and reserve", "[memPool]") {
+  const uint64_t values[2] = {1, 2};
+  {
+    ArrayPool pool{256, nullptr, 1024};
+    for (uint32_t i = 0; i < 300; ++i) {
+      pool.get(values, 2);
+    }
+    // each block is as large as the ones before it, up to the max
+    std::vector<size_t> sizes;
+    for (const ArrayPool::Block &block : pool.blocks) {
+      sizes.push_back(block.size);
+    }
+    CHECK(sizes == std::vector<size_t>{256, 256, 512, 1024, 1024, 1024, 1024});
+    // arrays larger than the max get a block of their own
+    std::vector<uint64_t> large(1000, 3);
+    pool.get(large.data(), large.size());
+    CHECK(pool.blocks.back().size == 8000);
+  }
+  {
+    ArrayPool pool{256};
+    pool.get(values, 2);
+    pool.reserve(10000);
+    REQUIRE(pool.blocks.size() == 2);
+    CHECK(pool.blocks[1].size == 10000 - (256 - 16));
+    const size_t retained = pool.retainedBytes();
+    uint32_t intact = 0;
+    for (uint32_t i = 0; i < 10000 / 16 - 1; ++i) {
+      intact += pool.get(values, 2)[1] == 2;
+    }
+    CHECK(intact == 10000 / 16 - 1);
+    CHECK(pool.retainedBytes() == retained);
+    // enough room left already
+    pool.reset();
+    pool.reserve(10000);
+    CHECK(pool.retainedBytes() == retained);
+  }
+}
+
+TEST_CASE("NodeMemPool reset cycles", "[memPool]") {
+  NodeMemPool pool;
+  Expression *first = pool.makeExpression();
+  for (uint32_t cycle = 0; cycle < 100; ++cycle) {
+    pool.reset();
+    REQUIRE(pool.makeExpression() == first);
+    for (uint32_t i = 0; i < 20000; ++i) {
+      pool.make<BinOp>(Token{i, 1, TokenType::ADDITION});
+    }
+  }
+  const size_t retained = pool.retainedBytes();
+  pool.reset();
+  CHECK(pool.retainedBytes() == retained);
+  pool.reset(1);
+  CHECK(pool.retainedBytes() == 0);
+  CHECK(pool.makeExpression());
+}
+
+TEST_CASE("NodeMemPool allocation order and reuse", "[memPool]") {
+  NodeMemPool pool;
+  // nodes of different types are allocated next to each other
+  Expression *expression = pool.makeExpression();
+  BinOp *binOp = pool.make<BinOp>(Token{0, 1, TokenType::ADDITION});
+  TokenList *tokenList = pool.makeTokenList();
+  CHECK((void *)binOp == (void *)(expression + 1));
+  CHECK((char *)tokenList == (char *)binOp + sizeof (BinOp));
+  CHECK(binOp->op.type == TokenType::ADDITION);
+
+  // released nodes are reused by nodes of the same size
+  pool.release(tokenList);
+  CHECK(pool.makeTokenList() == tokenList);
+  CHECK(pool.makeTokenList() != tokenList);
+}
+
+TEST_CASE("NodeMemPool checkpoints", "[memPool]") {
+  NodeMemPool pool;
+  TokenList *released = pool.makeTokenList();
+  TokenList *kept = pool.makeTokenList();
+  pool.release(released);
+  Expression *next;
+  {
+    NodeMemPool::Checkpoint checkpoint{pool};
+    next = pool.makeExpression();
+    pool.makeSpan<Expression>(100);
+    // nodes released before the checkpoint are not handed out while it is alive
+    TokenList *tokenList = pool.makeTokenList();
+    CHECK(tokenList != released);
+    // nodes released since are
+    pool.release(tokenList);
+    CHECK(pool.makeTokenList() == tokenList);
+    {
+      NodeMemPool::Checkpoint inner{pool};
+      Expression *innerNext = pool.makeExpression();
+      inner.rollback();
+      CHECK(pool.makeExpression() == innerNext);
+    }
+    pool.release(kept);
+    checkpoint.rollback();
+    // everything allocated since the checkpoint is handed out again, in the same order
+    CHECK(pool.makeExpression() == next);
+    checkpoint.rollback();
+  }
+  // keeping the checkpoint hands out the nodes released before it again
+  CHECK(pool.makeTokenList() == released);
+  CHECK(pool.makeExpression() == next);
+  CHECK(pool.makeTokenList() != kept);
+}
+
+TEST_CASE("NodeMemPool checkpoint marks", "[memPool]") {
+  NodeMemPool pool;
+  TokenList *released = pool.makeTokenList();
+  pool.release(released);
+  NodeMemPool::Checkpoint checkpoint{pool};
+  Expression *first = pool.makeExpression();
+  const NodeMemPool::Checkpoint::Mark mark = checkpoint.mark();
+  Expression *second = pool.makeExpression();
+  pool.makeSpan<Expression>(100);
+  pool.release(first);
+  checkpoint.rollback(mark);
+  // what was allocated before the mark is kept, what came after is handed out again
+  CHECK(pool.makeExpression() == second);
+  CHECK(pool.makeExpression() != first);
+  // the nodes released before the checkpoint are still held back
+  CHECK(pool.makeTokenList() != released);
+#if MEM_STATS_ENABLED
+  // live counts go back to the mark as well
+  const uint32_t binOpRow = 17;
+  const NodeMemPool::Checkpoint::Mark beforeBinOp = checkpoint.mark();
+  pool.make<BinOp>(Token{0, 1, TokenType::ADDITION});
+  CHECK(pool.allocationStats(binOpRow).live == 1);
+  checkpoint.rollback(beforeBinOp);
+  CHECK(pool.allocationStats(binOpRow).live == 0);
+#endif
+}
+
+TEST_CASE("NodeMemPool allocation statistics", "[memPool]") {
+  NodeMemPool pool;
+  const uint32_t binOpRow = 17, tokenListRow = 22, expressionSpanRow = 24;
+  REQUIRE(std::string{NodeMemPool::statsNames[binOpRow]} == "BinOp");
+  REQUIRE(std::string{NodeMemPool::statsNames[tokenListRow]} == "TokenList");
+  REQUIRE(std::string{NodeMemPool::statsNames[expressionSpanRow]} == "Expression[]");
+  for (uint32_t i = 0; i < 10; ++i) {
+    pool.make<BinOp>(Token{i, 1, TokenType::ADDITION});
+  }
+  TokenList *tokenList = pool.makeTokenList();
+  pool.release(tokenList);
+  pool.makeSpan<Expression>(4);
+  CHECK(pool.usedBytes() == 10 * sizeof (BinOp) + sizeof (TokenList) + 4 * sizeof (Expression));
+  CHECK(pool.blockAllocations() == 1);
+#if MEM_STATS_ENABLED
+  const AllocationStats &binOps = pool.allocationStats(binOpRow);
+  CHECK(binOps.allocations == 10);
+  CHECK(binOps.live == 10);
+  CHECK(binOps.bytes == 10 * sizeof (BinOp));
+  const AllocationStats &tokenLists = pool.allocationStats(tokenListRow);
+  CHECK(tokenLists.releases == 1);
+  CHECK(tokenLists.live == 0);
+  CHECK(tokenLists.highWater == 1);
+  CHECK(pool.allocationStats(expressionSpanRow).bytes == 4 * sizeof (Expression));
+  {
+    // rolled back nodes are no longer live
+    NodeMemPool::Checkpoint checkpoint{pool};
+    pool.make<BinOp>(Token{0, 1, TokenType::ADDITION});
+    CHECK(binOps.live == 11);
+    checkpoint.rollback();
+  }
+  CHECK(binOps.live == 10);
+  CHECK(binOps.highWater == 11);
+  pool.reset();
+  CHECK(binOps.live == 0);
+  CHECK(binOps.allocations == 11);
+#endif
+}
+
+TEST_CASE("ArrayPool adopt", "[memPool]") {
+  ArrayPool pool{256};
+  ArrayPool other{256};
+  const uint64_t values[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+  uint64_t *own = pool.get(values, 8);
+  std::vector<uint64_t *> adopted;
+  for (uint32_t i = 0; i < 10; ++i) {
+    adopted.push_back(other.get(values, 8));
+  }
+  // a spare block that was never used
+  other.reset();
+  other.get(values, 8);
+  const size_t retained = pool.retainedBytes() + other.retainedBytes();
+  pool.adopt(other);
+  CHECK(other.retainedBytes() == 0);
+  CHECK(other.blocks.empty());
+  CHECK(pool.retainedBytes() == retained);
+
+  // new arrays do not overwrite adopted ones
+  for (uint32_t i = 0; i < 20; ++i) {
+    uint64_t *arr = pool.get(values, 8);
+    CHECK(arr != own);
+    CHECK(arr != adopted[0]);
+    arr[0] = 0;
+  }
+  CHECK(own[0] == 1);
+  CHECK(adopted[0][0] == 1);
+}
+
+TEST_CASE("NodeMemPool adopt from worker threads", "[memPool]") {
+  const uint32_t workerCount = 4;
+  const uint32_t nodesPerWorker = 20000;
+  NodeMemPool pool;
+  std::vector<std::vector<BinOp *>> nodes(workerCount);
+  {
+    std::vector<NodeMemPool> workerPools(workerCount);
+    std::vector<std::thread> workers;
+    for (uint32_t w = 0; w < workerCount; ++w) {
+      workers.emplace_back([&, w]() {
+        for (uint32_t i = 0; i < nodesPerWorker; ++i) {
+          nodes[w].push_back(workerPools[w].make<BinOp>(Token{i, (uint16_t)w, TokenType::ADDITION}));
+        }
+      });
+    }
+    for (uint32_t w = 0; w < workerCount; ++w) {
+      workers[w].join();
+      pool.adopt(workerPools[w]);
+    }
+  }
+  // the worker pools are gone, their nodes are owned by pool now
+  uint32_t intact = 0;
+  for (uint32_t w = 0; w < workerCount; ++w) {
+    for (uint32_t i = 0; i < nodesPerWorker; ++i) {
+      intact += nodes[w][i]->op.position == i && nodes[w][i]->op.length == w;
+    }
+  }
+  CHECK(intact == workerCount * nodesPerWorker);
+  BinOp *extra = pool.make<BinOp>(Token{0, 0, TokenType::SUBTRACTION});
+  CHECK(extra->op.type == TokenType::SUBTRACTION);
+  CHECK(nodes[0][0]->op.type == TokenType::ADDITION);
+}
+
+TEST_CASE("ReservedBlockSource", "[memPool]") {
+  ReservedBlockSource source{4 << 20};
+  {
+    ArrayPool pool{1 << 16, &source};
+    const uint32_t values[3] = {1, 2, 3};
+    uint32_t *first = pool.get(values, 3);
+    if (source.isReserved()) {
+      CHECK((char *)first == source.begin);
+    }
+    uint32_t intact = 0;
+    for (uint32_t i = 0; i < 10000; ++i) {
+      intact += pool.get(values, 3)[2] == 3;
+    }
+    CHECK(intact == 10000);
+    // larger than what is left of the range, comes from malloc
+    std::vector<uint64_t> large(1 << 20, 7);
+    uint64_t *outside = pool.get(large.data(), large.size());
+    CHECK(outside[(1 << 20) - 1] == 7);
+    if (source.isReserved()) {
+      CHECK(((char *)outside < source.begin || (char *)outside >= source.end));
+    }
+    pool.reset(1 << 16);
+    CHECK(pool.retainedBytes() == 1 << 16);
+    if (source.isReserved()) {
+      // trimmed blocks are handed out again
+      CHECK(source.next == source.begin + (1 << 16));
+    }
+    CHECK(pool.get(values, 3) == first);
+#ifdef __linux__
+    // reset gives the pages of used blocks back, they read as zero once touched again
+    pool.reset();
+    if (source.isReserved()) {
+      CHECK(first[0] == 0);
+      CHECK(pool.get(values, 3) == first);
+      CHECK(first[2] == 3);
+    }
+#endif
+  }
+  if (source.isReserved()) {
+    CHECK(source.next == source.begin);
+  }
+
+  NodeMemPool nodes{&source};
+  BinOp *binOp = nodes.make<BinOp>(Token{1, 2, TokenType::ADDITION});
+  CHECK(binOp->op.length == 2);
+}
@@ -24,6 +24,12 @@ bool isControlFlow(TokenType type) {
   return type >= TokenType::IF && type <= TokenType::WHILE;
 }
 
+// keywords that can only start a general declaration
+bool isGlobalDecStart(TokenType type) {
+  return type == TokenType::FUNC || type == TokenType::STRUCT || type == TokenType::TEMPLATE ||
+    type == TokenType::CREATE || type == TokenType::INCLUDE;
+}
+
 bool isLiteral(TokenType type) {
   return type >= TokenType::CHAR_LITERAL && type <= TokenType::NULL_PTR;
 }
@@ -258,4 +264,5 @@ const std::unordered_map<TokenType, std::string> typeToString {
   {TokenType::CHAR_LITERAL, "'"},
   {TokenType::IDENTIFIER, "identifier"},
   {TokenType::TYPE, "type"},
+  {TokenType::OPERATOR, "operator"},
 };
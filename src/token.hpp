@@ -127,9 +127,6 @@ enum class TokenType : uint8_t {
   // extra types used by parse to report errors
   TYPE,
   OPERATOR,
-
-  // extra types used by checker
-  DEC_PTR,
 };
 
 struct Token {
@@ -146,6 +143,7 @@ bool isConcreteType(TokenType);
 bool isBinaryOp(TokenType);
 bool isUnaryOp(TokenType);
 bool isControlFlow(TokenType);
+bool isGlobalDecStart(TokenType);
 bool isLiteral(TokenType);
 bool isLogicalOp(TokenType);
 bool isAssignment(TokenType);
@@ -165,3 +165,30 @@ TEST_CASE("Unit Test - Token Extraction", "[tokenizer][tokenExtraction]") {
    CHECK(tokenizer.extractToken(tokens[2]) == "0xFABDECAAaaffbceda1010199747393");
    }
 }
+
+TEST_CASE("Unit Test - Locations Across Files", "[tokenizer][tokenExtraction]") {
+   std::vector<Tokenizer> tokenizers;
+   tokenizers.emplace_back("first.pr", "func first\nsecond");
+   const uint32_t baseLocation = tokenizers[0].endLocation();
+   tokenizers.emplace_back("second.pr", "\n  peeked next", baseLocation);
+   tokenizers[1].tokenizerIndex = 1;
+
+   std::vector<Token> tokens;
+   tokenizers[0].tokenizeAll(tokens);
+   REQUIRE(tokens.size() == 4);
+   CHECK(&tokenizerAt(tokenizers, tokens[2].position) == &tokenizers[0]);
+   // the end of file token still belongs to its file
+   CHECK(&tokenizerAt(tokenizers, tokens[3].position) == &tokenizers[0]);
+
+   Tokenizer& second = tokenizers[1];
+   const Token peeked = second.peekNext();
+   CHECK(peeked.position == baseLocation + 3);
+   CHECK(second.tokenizeNext() == peeked);
+   const Token next = second.tokenizeNext();
+   Tokenizer& found = tokenizerAt(tokenizers, next.position);
+   CHECK(found.tokenizerIndex == 1);
+   CHECK(found.extractToken(next) == "next");
+   TokenPositionInfo posInfo = found.getTokenPositionInfo(next);
+   CHECK(posInfo.lineNum == 2);
+   CHECK(posInfo.linePos == 10);
+}
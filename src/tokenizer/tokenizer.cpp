@@ -3,46 +3,63 @@
 
 TokenPositionInfo::TokenPositionInfo(uint32_t lineNum, uint32_t linePos): lineNum{lineNum}, linePos{linePos} {}
 
-Tokenizer::Tokenizer(std::string&& filePath, std::string&& fileContent):
-  newlinePositions{}, filePath{std::move(filePath)}, content{std::move(fileContent)}, peeked{0, 0, TokenType::NOTHING}
+Tokenizer::Tokenizer(std::string&& filePath, std::string&& fileContent, uint32_t baseLocation):
+  newlinePositions{}, filePath{std::move(filePath)}, content{std::move(fileContent)}, peeked{baseLocation, 0, TokenType::NOTHING},
+  baseLocation{baseLocation}
 {
-  if (fileContent.length() > UINT32_MAX) {
+  if ((uint64_t)content.length() + baseLocation >= UINT32_MAX) {
     exit(1);
   }
-  newlinePositions.reserve(fileContent.size() / 40);
+  newlinePositions.reserve(content.size() / 40);
   newlinePositions.emplace_back(0);
 }
-Tokenizer::Tokenizer(std::string&& filePath, const std::string& fileContent):
-  newlinePositions{}, filePath{std::move(filePath)}, content{fileContent}, peeked{0, 0, TokenType::NOTHING}
+Tokenizer::Tokenizer(std::string&& filePath, const std::string& fileContent, uint32_t baseLocation):
+  newlinePositions{}, filePath{std::move(filePath)}, content{fileContent}, peeked{baseLocation, 0, TokenType::NOTHING},
+  baseLocation{baseLocation}
 {
-  if (fileContent.length() > UINT32_MAX) {
+  if ((uint64_t)content.length() + baseLocation >= UINT32_MAX) {
     exit(1);
   }
-  newlinePositions.reserve(fileContent.size() / 40);
+  newlinePositions.reserve(content.size() / 40);
   newlinePositions.emplace_back(0);
 }
 
+Tokenizer& tokenizerAt(std::vector<Tokenizer>& tokenizers, uint32_t location) {
+  uint32_t low = 0;
+  uint32_t high = tokenizers.size() - 1;
+  while (low < high) {
+    const uint32_t middle = (low + high + 1) / 2;
+    if (location < tokenizers[middle].baseLocation) {
+      high = middle - 1;
+    } else {
+      low = middle;
+    }
+  }
+  return tokenizers[low];
+}
+
 // does binary search on the newline list to find the line number
 TokenPositionInfo Tokenizer::getTokenPositionInfo(const Token& tk) {
+  const uint32_t offset = tk.position - baseLocation;
   if (newlinePositions.empty()) {
-    return {1, tk.position + 1};
+    return {1, offset + 1};
   }
   uint32_t high = newlinePositions.size() - 1;
   uint32_t low = 0;
   uint32_t middle = high / 2;
   while (low < high) {
-    if (tk.position < newlinePositions[middle]) {
+    if (offset < newlinePositions[middle]) {
       high = middle - 1;
     }
-    else if (tk.position >= newlinePositions[middle + 1]) {
+    else if (offset >= newlinePositions[middle + 1]) {
       low = middle + 1;
     }
     else {
-      return {middle + 1, tk.position + 1 - newlinePositions[middle]};
+      return {middle + 1, offset + 1 - newlinePositions[middle]};
     }
     middle = (high + low) / 2;
   }
-  return {high + 1, tk.position + 1 - newlinePositions[high]};
+  return {high + 1, offset + 1 - newlinePositions[high]};
 }
 
 void Tokenizer::tokenizeAll(std::vector<Token>& tokens) {
@@ -66,14 +83,14 @@ Token Tokenizer::peekNext() {
   }
   peeked = tokenizeNext();
   // put position back
-  position = peeked.position;
+  position = peeked.position - baseLocation;
   return peeked;
 }
 
 void Tokenizer::consumePeek() {
   if (peeked.type != TokenType::NOTHING) {
     peeked.type = TokenType::NOTHING;
-    position = peeked.position + peeked.length;
+    position = peeked.position - baseLocation + peeked.length;
   }
 }
 
@@ -81,7 +98,7 @@ Token Tokenizer::tokenizeNext() {
   if (peeked.type != TokenType::NOTHING) {
     const Token temp = peeked;
     peeked.type = TokenType::NOTHING;
-    position = peeked.position + peeked.length;
+    position = peeked.position - baseLocation + peeked.length;
     return temp;
   }
   moveToNextNonWhiteSpaceChar();
@@ -428,7 +445,7 @@ Token Tokenizer::tokenizeNext() {
 
     case TokenType::STRING_LITERAL: {
       if (!movePastLiteral('"')) {
-        TokenPositionInfo posInfo = getTokenPositionInfo({position, 0, TokenType::STRING_LITERAL});
+        TokenPositionInfo posInfo = getTokenPositionInfo({baseLocation + position, 0, TokenType::STRING_LITERAL});
         std::cerr << filePath << ':' << posInfo.lineNum << ':' << posInfo.linePos << "\nUnclosed string literal\n";
         exit(1);
       }
@@ -437,7 +454,7 @@ Token Tokenizer::tokenizeNext() {
 
     case TokenType::CHAR_LITERAL: {
       if (!movePastLiteral('\'')) {
-        TokenPositionInfo posInfo = getTokenPositionInfo({position, 0, TokenType::CHAR_LITERAL});
+        TokenPositionInfo posInfo = getTokenPositionInfo({baseLocation + position, 0, TokenType::CHAR_LITERAL});
         std::cerr << filePath << ':' << posInfo.lineNum << ':' << posInfo.linePos << "\nUnclosed character literal\n";
         exit(1);
       }
@@ -632,7 +649,7 @@ Token Tokenizer::tokenizeNext() {
     exit(1);
   }
   prevType = type;
-  return {tokenStartPos, (uint16_t)(position - tokenStartPos), type};
+  return {baseLocation + tokenStartPos, (uint16_t)(position - tokenStartPos), type};
 }
 
 void Tokenizer::moveToNextNonWhiteSpaceChar() {
@@ -700,5 +717,5 @@ void Tokenizer::movePastNewLine() {
 }
 
 std::string Tokenizer::extractToken(const Token &token) {
-  return content.substr(token.position, token.length);
+  return content.substr(token.position - baseLocation, token.length);
 }
@@ -11,19 +11,24 @@ struct TokenPositionInfo{
   TokenPositionInfo(uint32_t, uint32_t);
 };
 
+/**
+ * Tokens hold locations rather than file offsets. All loaded files share one 32 bit location space, each file taking
+ * the range [baseLocation, endLocation()) in load order, so the file of any token can be found from the token alone
+*/
 struct Tokenizer {
   std::vector<uint32_t> newlinePositions;
   const std::string filePath;
   const std::string content;
   Token peeked;
-  uint32_t position{0};
+  uint32_t position{0}; // offset into content
   uint32_t tokenizerIndex{0};
+  const uint32_t baseLocation{0};
   TokenType prevType{TokenType::NOTHING};
 
   Tokenizer() = delete;
 
-  explicit Tokenizer(std::string&&, std::string&&);
-  explicit Tokenizer(std::string&&, const std::string&);
+  explicit Tokenizer(std::string&&, std::string&&, uint32_t baseLocation = 0);
+  explicit Tokenizer(std::string&&, const std::string&, uint32_t baseLocation = 0);
 
   void tokenizeAll(std::vector<Token>&);
   Token tokenizeNext();
@@ -31,6 +36,8 @@ struct Tokenizer {
   void consumePeek();
   std::string extractToken(const Token&);
   TokenPositionInfo getTokenPositionInfo(const Token&);
+  // one past the end of the file, so that the end of file token is still within the file
+  uint32_t endLocation() const { return baseLocation + content.size() + 1; }
 
 private:
   void moveToNextNonWhiteSpaceChar();
@@ -40,3 +47,9 @@ private:
   bool movePastLiteral(char);
   void movePastNewLine();
 };
+
+/**
+ * Finds the file a location belongs to by binary search
+ * \param tokenizers all loaded files, in load order
+*/
+Tokenizer& tokenizerAt(std::vector<Tokenizer>& tokenizers, uint32_t location);
@@ -0,0 +1,91 @@
+#include <catch2/catch_test_macros.hpp>
+#include "../parser/parser.hpp"
+#include "traversal.hpp"
+
+NodeMemPool memPoolTraversal;
+
+struct RecordingVisitor: NodeVisitor {
+  using NodeVisitor::enter;
+  using NodeVisitor::leave;
+  Tokenizer& tk;
+  std::string order;
+  bool skipCalls{false};
+  explicit RecordingVisitor(Tokenizer& tk): tk{tk} {}
+
+  bool enter(Expression& expression) {
+    if (expression.type == ExpressionType::VALUE) {
+      order += tk.extractToken(expression.value) + ' ';
+    } else if (expression.type == ExpressionType::FUNCTION_CALL) {
+      order += tk.extractToken(expression.funcCall->name) + "( ";
+      return !skipCalls;
+    } else if (expression.type == ExpressionType::BINARY_OP) {
+      order += "< ";
+    }
+    return true;
+  }
+  void leave(Expression& expression) {
+    if (expression.type == ExpressionType::FUNCTION_CALL) {
+      order += ") ";
+    } else if (expression.type == ExpressionType::BINARY_OP) {
+      order += tk.extractToken(expression.binOp->op) + " > ";
+    }
+  }
+  bool enter(Scope&) {
+    order += "{ ";
+    return true;
+  }
+  void leave(Scope&) {
+    order += "} ";
+  }
+};
+
+TEST_CASE("Traversal order", "[traversal]") {
+  const std::string str = "func f(a: int32): int32 { x: int32 = a + 1; if (x) { g(x, 2); } elif (a) { return 3; } else { y; } while (x) { x = x - 1; } return x * b; }";
+  Tokenizer tokenizer{"./src/traversal/test_traversal.cpp", str};
+  Parser parser{tokenizer, memPoolTraversal};
+  REQUIRE(parser.parse());
+  RecordingVisitor visitor{tokenizer};
+  Traversal<RecordingVisitor> traversal{visitor};
+  traversal.walk(*parser.program.decs[0]->funcDec);
+  CHECK(visitor.order == "{ < a 1 + > x { g( x 2 ) } a { 3 } { y } x { < x < x 1 - > = > } < x b * > } ");
+  CHECK(traversal.stack.empty());
+
+  visitor.order.clear();
+  visitor.skipCalls = true;
+  traversal.walk(parser.program.decs[0]->funcDec->body.scopeStatements[1]);
+  CHECK(visitor.order == "x { g( ) } a { 3 } { y } ");
+}
+
+struct DepthVisitor: NodeVisitor {
+  using NodeVisitor::enter;
+  using NodeVisitor::leave;
+  uint32_t depth{0};
+  uint32_t maxDepth{0};
+  bool enter(Expression&) {
+    if (++depth > maxDepth) {
+      maxDepth = depth;
+    }
+    return true;
+  }
+  void leave(Expression&) {
+    --depth;
+  }
+};
+
+TEST_CASE("Traversal of deeply nested expressions", "[traversal]") {
+  // deeper than a recursive walk could go on the default stack
+  const uint32_t nesting = 1000000;
+  Expression root;
+  Expression *curr = &root;
+  for (uint32_t i = 0; i < nesting; ++i) {
+    curr->type = ExpressionType::WRAPPED;
+    curr->wrapped = memPoolTraversal.makeExpression();
+    curr = curr->wrapped;
+  }
+  curr->type = ExpressionType::VALUE;
+  DepthVisitor visitor;
+  Traversal<DepthVisitor> traversal{visitor};
+  traversal.walk(root);
+  CHECK(visitor.maxDepth == nesting + 1);
+  CHECK(visitor.depth == 0);
+}
@@ -0,0 +1,261 @@
+#pragma once
+
+#include "../nodes.hpp"
+#include <algorithm>
+#include <vector>
+
+/**
+ * Visitor with no-op callbacks. Derive from it, add 'using NodeVisitor::enter; using NodeVisitor::leave;'
+ * and overload the callbacks that a pass needs.
+ * enter is called before the children of a node are visited, leave after all of them were.
+ * Returning false from enter skips the children of the node, leave is still called
+*/
+struct NodeVisitor {
+  bool enter(Statement&) { return true; }
+  void leave(Statement&) {}
+  bool enter(Expression&) { return true; }
+  void leave(Expression&) {}
+  bool enter(Scope&) { return true; }
+  void leave(Scope&) {}
+};
+
+inline void prefetchNode(const void *node) {
+#if defined(__GNUC__)
+  __builtin_prefetch(node);
+#else
+  (void)node;
+#endif
+}
+
+/**
+ * Non recursive pre/post order walk over statements, scopes and expressions.
+ * Children are visited in source order. The walk uses an explicit stack, so deeply nested code cannot overflow
+ * the call stack, and the callbacks are resolved at compile time since the walk is templated on the visitor.
+ * The node a pointer child refers to is prefetched when the child is pushed, so the load is in flight while
+ * the nodes above it on the stack are visited.
+ * Reuse one Traversal for many walks to reuse its stack.
+ * Not thread safe
+*/
+template<typename Visitor>
+struct Traversal {
+  enum class NodeKind: uint8_t {
+    STATEMENT,
+    EXPRESSION,
+    SCOPE,
+  };
+  struct Frame {
+    void *node;
+    NodeKind kind;
+    bool expanded; // enter was called and the children were pushed
+  };
+  std::vector<Frame> stack;
+  Visitor& visitor;
+
+  explicit Traversal(Visitor& visitor): visitor{visitor} {}
+
+  void walk(Statement& statement) {
+    push(statement);
+    run();
+  }
+
+  void walk(Expression& expression) {
+    push(expression);
+    run();
+  }
+
+  void walk(Scope& scope) {
+    push(scope);
+    run();
+  }
+
+  void walk(FunctionDec& funcDec) {
+    const size_t first = stack.size();
+    for (Statement& param : funcDec.params) {
+      push(param);
+    }
+    push(funcDec.body);
+    std::reverse(stack.begin() + first, stack.end());
+    run();
+  }
+
+private:
+  void push(Statement& statement) {
+    switch (statement.type) {
+      case StatementType::EXPRESSION:
+      case StatementType::CONTROL_FLOW:
+      case StatementType::SCOPE:
+      case StatementType::VARIABLE_DEC: prefetchNode(statement.expression); break;
+      default: break;
+    }
+    stack.push_back(Frame{&statement, NodeKind::STATEMENT, false});
+  }
+
+  void push(Expression& expression) {
+    switch (expression.type) {
+      case ExpressionType::NONE:
+      case ExpressionType::VALUE: break;
+      default: prefetchNode(expression.binOp); break;
+    }
+    stack.push_back(Frame{&expression, NodeKind::EXPRESSION, false});
+  }
+
+  void push(Scope& scope) {
+    prefetchNode(scope.scopeStatements.data);
+    stack.push_back(Frame{&scope, NodeKind::SCOPE, false});
+  }
+
+  void run() {
+    while (!stack.empty()) {
+      Frame& frame = stack.back();
+      if (frame.expanded) {
+        const Frame done = frame;
+        stack.pop_back();
+        switch (done.kind) {
+          case NodeKind::STATEMENT: visitor.leave(*(Statement *)done.node); break;
+          case NodeKind::EXPRESSION: visitor.leave(*(Expression *)done.node); break;
+          case NodeKind::SCOPE: visitor.leave(*(Scope *)done.node); break;
+        }
+        continue;
+      }
+      frame.expanded = true;
+      // frame may be invalidated by the pushes below
+      const Frame current = frame;
+      // children are pushed in source order, then reversed so that they are popped in source order
+      const size_t first = stack.size();
+      switch (current.kind) {
+        case NodeKind::STATEMENT: {
+          Statement& statement = *(Statement *)current.node;
+          if (visitor.enter(statement)) {
+            pushChildren(statement);
+          }
+          break;
+        }
+        case NodeKind::EXPRESSION: {
+          Expression& expression = *(Expression *)current.node;
+          if (visitor.enter(expression)) {
+            pushChildren(expression);
+          }
+          break;
+        }
+        case NodeKind::SCOPE: {
+          Scope& scope = *(Scope *)current.node;
+          if (visitor.enter(scope)) {
+            for (Statement& statement : scope.scopeStatements) {
+              push(statement);
+            }
+          }
+          break;
+        }
+      }
+      std::reverse(stack.begin() + first, stack.end());
+    }
+  }
+
+  void pushChildren(Statement& statement) {
+    switch (statement.type) {
+      case StatementType::EXPRESSION: {
+        push(*statement.expression);
+        break;
+      }
+      case StatementType::SCOPE: {
+        push(*statement.scope);
+        break;
+      }
+      case StatementType::VARIABLE_DEC: {
+        if (statement.varDec->initialAssignment) {
+          push(*statement.varDec->initialAssignment);
+        }
+        break;
+      }
+      case StatementType::CONTROL_FLOW: {
+        pushChildren(*statement.controlFlow);
+        break;
+      }
+      default: break;
+    }
+  }
+
+  void pushChildren(ControlFlowStatement& controlFlow) {
+    switch (controlFlow.type) {
+      case ControlFlowStatementType::FOR_LOOP: {
+        ForLoop& forLoop = *controlFlow.forLoop;
+        push(forLoop.initialize);
+        push(forLoop.condition);
+        push(forLoop.iteration);
+        push(forLoop.body);
+        break;
+      }
+      case ControlFlowStatementType::WHILE_LOOP: {
+        push(controlFlow.whileLoop->statement.condition);
+        push(controlFlow.whileLoop->statement.body);
+        break;
+      }
+      case ControlFlowStatementType::CONDITIONAL_STATEMENT: {
+        ConditionalStatement& conditional = *controlFlow.conditional;
+        push(conditional.ifStatement.condition);
+        push(conditional.ifStatement.body);
+        for (ElifStatementList *elif = conditional.elifStatement; elif; elif = elif->next) {
+          push(elif->elif.condition);
+          push(elif->elif.body);
+        }
+        if (conditional.elseStatement) {
+          push(*conditional.elseStatement);
+        }
+        break;
+      }
+      case ControlFlowStatementType::RETURN_STATEMENT: {
+        push(controlFlow.returnStatement->returnValue);
+        break;
+      }
+      case ControlFlowStatementType::SWITCH_STATEMENT: {
+        SwitchStatement& switchStatement = *controlFlow.switchStatement;
+        push(switchStatement.switched);
+        for (SwitchScopeStatementList *list = &switchStatement.body; list; list = list->next) {
+          if (list->caseExpression) {
+            push(*list->caseExpression);
+          }
+          if (list->caseBody) {
+            push(*list->caseBody);
+          }
+        }
+        break;
+      }
+      case ControlFlowStatementType::NONE: break;
+    }
+  }
+
+  void pushChildren(Expression& expression) {
+    switch (expression.type) {
+      case ExpressionType::BINARY_OP: {
+        push(expression.binOp->leftSide);
+        push(expression.binOp->rightSide);
+        break;
+      }
+      case ExpressionType::UNARY_OP: {
+        push(expression.unOp->operand);
+        break;
+      }
+      case ExpressionType::FUNCTION_CALL: {
+        for (Expression& arg : expression.funcCall->args) {
+          push(arg);
+        }
+        break;
+      }
+      case ExpressionType::ARRAY_ACCESS: {
+        push(expression.arrAccess->offset);
+        break;
+      }
+      case ExpressionType::WRAPPED: {
+        push(*expression.wrapped);
+        break;
+      }
+      case ExpressionType::ARRAY_OR_STRUCT_LITERAL: {
+        for (Expression& value : expression.arrayOrStruct->values) {
+          push(value);
+        }
+        break;
+      }
+      default: break;
+    }
+  }
+};